@@ -0,0 +1,119 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+UnitTest(Algorithms_Sort)
+{
+	TArray<uint> values;
+	uint seed = 1234;
+	for (uint i = 0; i < 5000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		values.Add(seed % 1000);
+	}
+
+	FAlgorithms::Sort(values);
+	tcheck(FAlgorithms::IsSorted(values.GetData(), values.GetData() + values.GetCount()));
+
+	// already sorted and reverse sorted input should not degrade
+	FAlgorithms::Sort(values);
+	tcheck(FAlgorithms::IsSorted(values.GetData(), values.GetData() + values.GetCount()));
+	FAlgorithms::Sort(values.GetData(), values.GetData() + values.GetCount(), [](uint a, uint b) { return a > b; });
+	tcheck(values[0] >= values[values.GetCount() - 1]);
+	FAlgorithms::Sort(values);
+	tcheck(FAlgorithms::IsSorted(values.GetData(), values.GetData() + values.GetCount()));
+
+	TArray<FString> strings;
+	strings.Add("delta");
+	strings.Add("alpha");
+	strings.Add("a string long enough to live on the heap");
+	strings.Add("charlie");
+	FAlgorithms::Sort(strings.GetData(), strings.GetData() + strings.GetCount(),
+	                  [](const FString& a, const FString& b) { return strcmp(a.GetData(), b.GetData()) < 0; });
+	tcheck(strcmp(strings[0].GetData(), "a string long enough to live on the heap") == 0);
+	tcheck(strcmp(strings[3].GetData(), "delta") == 0);
+}
+
+UnitTest(Algorithms_StableSort)
+{
+	TArray<TPair<uint, uint>> pairs;
+	uint seed = 99;
+	for (uint i = 0; i < 3000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		pairs.Add(TPair<uint, uint>((seed >> 8) % 50, i));
+	}
+
+	FAlgorithms::StableSort(pairs.GetData(), pairs.GetData() + pairs.GetCount(),
+	                        [](const TPair<uint, uint>& a, const TPair<uint, uint>& b) { return a.First < b.First; });
+
+	bool stable = true;
+	for (size_t i = 1; i < pairs.GetCount(); ++i)
+	{
+		stable &= pairs[i - 1].First < pairs[i].First || (pairs[i - 1].First == pairs[i].First && pairs[i - 1].Second < pairs[i].Second);
+	}
+	tcheck(stable);
+}
+
+UnitTest(Algorithms_Bounds)
+{
+	const int values[] = {1, 3, 3, 3, 7, 9};
+	const int* const first = values;
+	const int* const last = values + 6;
+
+	tcheck(FAlgorithms::LowerBound(first, last, 3) == values + 1);
+	tcheck(FAlgorithms::UpperBound(first, last, 3) == values + 4);
+	tcheck(FAlgorithms::LowerBound(first, last, 0) == first);
+	tcheck(FAlgorithms::UpperBound(first, last, 9) == last);
+	tcheck(FAlgorithms::LowerBound(first, last, 8) == values + 5);
+	tcheck(FAlgorithms::LowerBound(first, first, 8) == first);
+
+	bool valid = true;
+	for (int v = 0; v < 11; ++v)
+	{
+		size_t expectedLower = 0;
+		size_t expectedUpper = 0;
+		for (int x : values)
+		{
+			expectedLower += x < v;
+			expectedUpper += x <= v;
+		}
+		valid &= (size_t)(FAlgorithms::LowerBound(first, last, v) - first) == expectedLower;
+		valid &= (size_t)(FAlgorithms::UpperBound(first, last, v) - first) == expectedUpper;
+	}
+	tcheck(valid);
+}
+
+UnitTest(Algorithms_FindPartition)
+{
+	TArray<int> values = {5, 8, 1, 4, 7, 2, 9};
+	tcheck(FAlgorithms::Find(values, 4) == values.GetData() + 3);
+	tcheck(FAlgorithms::Find(values, 3) == values.end());
+
+	int* const cut = FAlgorithms::StablePartition(values.begin(), values.end(), [](int v) { return v % 2 == 0; });
+	tcheck(cut == values.GetData() + 3);
+	tcheck(values[0] == 8 && values[1] == 4 && values[2] == 2);
+	tcheck(values[3] == 5 && values[4] == 1 && values[5] == 7 && values[6] == 9);
+}
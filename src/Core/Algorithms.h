@@ -0,0 +1,362 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Generic algorithms over raw ranges [first, last) and containers exposing GetData()/GetCount()
+ */
+namespace FAlgorithms
+{
+	/**
+	 * Ranges up to this size are sorted with insertion sort
+	 */
+	constexpr size_t kInsertionSortThreshold = 16;
+
+	template <typename T, typename TCompare>
+	void InsertionSort(T* first, T* last, TCompare compare)
+	{
+		if (first == last)return;
+
+		for (T* i = first + 1; i < last; ++i)
+		{
+			T value = std::move(*i);
+			T* j = i;
+			while (j > first && compare(value, *(j - 1)))
+			{
+				*j = std::move(*(j - 1));
+				--j;
+			}
+			*j = std::move(value);
+		}
+	}
+
+	template <typename T, typename TCompare>
+	void SiftDown(T* heap, size_t root, const size_t count, TCompare& compare)
+	{
+		for (size_t child = root * 2 + 1; child < count; child = root * 2 + 1)
+		{
+			if (child + 1 < count && compare(heap[child], heap[child + 1]))
+			{
+				++child;
+			}
+
+			if (!compare(heap[root], heap[child]))
+			{
+				return;
+			}
+
+			FUtils::Swap(heap[root], heap[child]);
+			root = child;
+		}
+	}
+
+	template <typename T, typename TCompare>
+	void HeapSort(T* first, T* last, TCompare compare)
+	{
+		const size_t count = last - first;
+		for (size_t i = count / 2; i-- > 0;)
+		{
+			SiftDown(first, i, count, compare);
+		}
+
+		for (size_t i = count; i-- > 1;)
+		{
+			FUtils::Swap(first[0], first[i]);
+			SiftDown(first, 0, i, compare);
+		}
+	}
+
+	/**
+	 * Move the median of a, b and c to `result`
+	 */
+	template <typename T, typename TCompare>
+	FORCEINLINE void MoveMedianToFirst(T* result, T* a, T* b, T* c, TCompare& compare)
+	{
+		if (compare(*a, *b))
+		{
+			if (compare(*b, *c))
+				FUtils::Swap(*result, *b);
+			else if (compare(*a, *c))
+				FUtils::Swap(*result, *c);
+			else
+				FUtils::Swap(*result, *a);
+		}
+		else if (compare(*a, *c))
+			FUtils::Swap(*result, *a);
+		else if (compare(*b, *c))
+			FUtils::Swap(*result, *c);
+		else
+			FUtils::Swap(*result, *b);
+	}
+
+	/**
+	 * Hoare partition around *pivot. The median of three guarantees both scans stop inside the range
+	 */
+	template <typename T, typename TCompare>
+	FORCEINLINE T* UnguardedPartition(T* first, T* last, T* pivot, TCompare& compare)
+	{
+		while (true)
+		{
+			while (compare(*first, *pivot))
+				++first;
+			--last;
+			while (compare(*pivot, *last))
+				--last;
+			if (!(first < last))
+				return first;
+			FUtils::Swap(*first, *last);
+			++first;
+		}
+	}
+
+	template <typename T, typename TCompare>
+	void IntroSortLoop(T* first, T* last, size_t depthLimit, TCompare& compare)
+	{
+		while ((size_t)(last - first) > kInsertionSortThreshold)
+		{
+			if (!depthLimit)
+			{
+				HeapSort(first, last, compare); // quicksort degenerated: bound the worst case to O(n log n)
+				return;
+			}
+			--depthLimit;
+
+			MoveMedianToFirst(first, first + 1, first + (last - first) / 2, last - 1, compare);
+			T* cut = UnguardedPartition(first + 1, last, first, compare);
+			IntroSortLoop(cut, last, depthLimit, compare);
+			last = cut;
+		}
+	}
+
+	/**
+	 * Introsort: quicksort with median of three, heap sort when recursion gets too deep and insertion sort for small
+	 * ranges. Not stable
+	 */
+	template <typename T, typename TCompare = FUtils::Less<T>>
+	void Sort(T* first, T* last, TCompare compare = TCompare())
+	{
+		if (last - first < 2)return;
+
+		size_t depthLimit = 0;
+		for (size_t n = last - first; n > 1; n >>= 1)
+		{
+			depthLimit += 2;
+		}
+
+		IntroSortLoop(first, last, depthLimit, compare);
+		InsertionSort(first, last, compare);
+	}
+
+	template <typename TContainer, typename TCompare = FUtils::Less<typename std::remove_reference<decltype(*std::declval<TContainer&>().GetData())>::type>>
+	void Sort(TContainer& container, TCompare compare = TCompare())
+	{
+		Sort(container.GetData(), container.GetData() + container.GetCount(), compare);
+	}
+
+	/**
+	 * Merge sorted [first, mid) and [mid, last). The left half is moved out to `buffer` (uninitialized memory)
+	 */
+	template <typename T, typename TCompare>
+	void MergeWithBuffer(T* first, T* mid, T* last, T* buffer, TCompare& compare)
+	{
+		const size_t leftCount = mid - first;
+		for (size_t i = 0; i < leftCount; ++i)
+		{
+			new(buffer + i) T(std::move(first[i]));
+		}
+
+		T* left = buffer;
+		T* const leftEnd = buffer + leftCount;
+		T* right = mid;
+		T* out = first;
+
+		while (left < leftEnd && right < last)
+		{
+			if (compare(*right, *left)) // equal elements are taken from the left: keeps the sort stable
+				*out++ = std::move(*right++);
+			else
+				*out++ = std::move(*left++);
+		}
+
+		while (left < leftEnd)
+		{
+			*out++ = std::move(*left++);
+		}
+
+		for (size_t i = 0; i < leftCount; ++i)
+		{
+			buffer[i].~T();
+		}
+	}
+
+	template <typename T, typename TCompare>
+	void StableSortRecursive(T* first, T* last, T* buffer, TCompare& compare)
+	{
+		if ((size_t)(last - first) <= kInsertionSortThreshold)
+		{
+			InsertionSort(first, last, compare);
+			return;
+		}
+
+		T* mid = first + (last - first) / 2;
+		StableSortRecursive(first, mid, buffer, compare);
+		StableSortRecursive(mid, last, buffer, compare);
+
+		if (compare(*mid, *(mid - 1))) // halves are not already in order
+		{
+			MergeWithBuffer(first, mid, last, buffer, compare);
+		}
+	}
+
+	/**
+	 * Merge sort, keeps the relative order of equal elements. Allocates a buffer of half the range
+	 */
+	template <typename T, typename TCompare = FUtils::Less<T>>
+	void StableSort(T* first, T* last, TCompare compare = TCompare())
+	{
+		const size_t count = last - first;
+		if (count < 2)return;
+
+		T* buffer = (T*)FMemory::Alloc(sizeof(T) * (count / 2 + 1), alignof(T));
+		StableSortRecursive(first, last, buffer, compare);
+		FMemory::Free(buffer);
+	}
+
+	template <typename TContainer, typename TCompare = FUtils::Less<typename std::remove_reference<decltype(*std::declval<TContainer&>().GetData())>::type>>
+	void StableSort(TContainer& container, TCompare compare = TCompare())
+	{
+		StableSort(container.GetData(), container.GetData() + container.GetCount(), compare);
+	}
+
+	/**
+	 * First element in sorted [first, last) for which compare(element, value) is false.
+	 * Branchless: the loop has a fixed trip count and the comparison compiles to a conditional move
+	 */
+	template <typename T, typename U, typename TCompare = FUtils::Less<T>>
+	FORCEINLINE T* LowerBound(T* first, T* last, const U& value, TCompare compare = TCompare())
+	{
+		size_t count = last - first;
+		if (!count)return first;
+
+		T* base = first;
+		while (count > 1)
+		{
+			const size_t half = count / 2;
+			base = compare(base[half], value) ? base + half : base;
+			count -= half;
+		}
+		return base + (compare(*base, value) ? 1 : 0);
+	}
+
+	/**
+	 * First element in sorted [first, last) for which compare(value, element) is true. Branchless
+	 */
+	template <typename T, typename U, typename TCompare = FUtils::Less<T>>
+	FORCEINLINE T* UpperBound(T* first, T* last, const U& value, TCompare compare = TCompare())
+	{
+		size_t count = last - first;
+		if (!count)return first;
+
+		T* base = first;
+		while (count > 1)
+		{
+			const size_t half = count / 2;
+			base = compare(value, base[half]) ? base : base + half;
+			count -= half;
+		}
+		return base + (compare(value, *base) ? 0 : 1);
+	}
+
+	template <typename T, typename TCompare = FUtils::Less<T>>
+	bool IsSorted(const T* first, const T* last, TCompare compare = TCompare())
+	{
+		for (const T* i = first; i + 1 < last; ++i)
+		{
+			if (compare(*(i + 1), *i))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename T, typename TPredicate>
+	T* FindIf(T* first, T* last, TPredicate predicate)
+	{
+		for (; first < last; ++first)
+		{
+			if (predicate(*first))
+			{
+				return first;
+			}
+		}
+		return last;
+	}
+
+	/**
+	 * First element equal to `value`, `last` if there is none
+	 */
+	template <typename T, typename U>
+	FORCEINLINE T* Find(T* first, T* last, const U& value)
+	{
+		return FindIf(first, last, [&value](const T& element) { return element == value; });
+	}
+
+	template <typename TContainer, typename U>
+	FORCEINLINE auto Find(TContainer& container, const U& value) -> decltype(container.GetData())
+	{
+		return Find(container.GetData(), container.GetData() + container.GetCount(), value);
+	}
+
+	/**
+	 * Move the elements satisfying `predicate` before the others, keeping the relative order within both groups.
+	 * Returns the first element of the second group. Allocates a buffer for the second group
+	 */
+	template <typename T, typename TPredicate>
+	T* StablePartition(T* first, T* last, TPredicate predicate)
+	{
+		first = FindIf(first, last, [&predicate](const T& element) { return !predicate(element); });
+		if (first == last)return last;
+
+		T* buffer = (T*)FMemory::Alloc(sizeof(T) * (last - first), alignof(T));
+		size_t rejectedCount = 0;
+		T* out = first;
+		for (T* i = first; i < last; ++i)
+		{
+			if (predicate(*i))
+				*out++ = std::move(*i);
+			else
+				new(buffer + rejectedCount++) T(std::move(*i));
+		}
+
+		for (size_t i = 0; i < rejectedCount; ++i)
+		{
+			out[i] = std::move(buffer[i]);
+			buffer[i].~T();
+		}
+		FMemory::Free(buffer);
+		return out;
+	}
+}
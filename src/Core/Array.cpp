@@ -24,6 +24,8 @@
 
 #include "pch.h"
 
+#include <vector>
+
 UnitTest(Array_Basic)
 {
 	{
@@ -65,6 +67,8 @@ UnitTest(Array_ObjectLifetime)
 {
 	static uint constructCount = 0;
 	static uint destructCount = 0;
+	constructCount = 0; // the counters are static, start over on repeated runs
+	destructCount = 0;
 
 	struct SConstructorMock
 	{
@@ -137,3 +141,345 @@ UnitTest(Array_Memory)
 		tcheck(allocator.FreeCount == 1);
 	}
 }
+
+UnitTest(Array_Growth)
+{
+	{
+		TArray<int, TAllocatorMock<int>> intArray;
+		TAllocatorMock<int>& allocator = intArray.GetAllocator();
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			intArray.Add(i);
+		}
+		tcheck(intArray.GetCount() == 1000);
+		tcheck(allocator.AllocCount == 1);
+		tcheck(allocator.ReAllocCount < 20); // geometric growth: O(log n) reallocations
+		tcheck(allocator.FreeCount == 0);
+
+		bool valid = true;
+		for (int i = 0; i < 1000; ++i)
+		{
+			valid &= intArray[i] == i;
+		}
+		tcheck(valid);
+
+		intArray.Add(intArray[0]); // element of the array itself must survive reallocation
+		tcheck(intArray[1000] == 0);
+	}
+
+	{
+		TArray<int, TAllocatorMock<int>, FExactGrowthPolicy> intArray;
+		TAllocatorMock<int>& allocator = intArray.GetAllocator();
+
+		for (int i = 0; i < 100; ++i)
+		{
+			intArray.Add(i);
+		}
+		tcheck(intArray.GetCount() == 100);
+		tcheck(intArray.GetReservation() == 0);
+		tcheck(allocator.AllocCount == 1);
+		tcheck(allocator.ReAllocCount == 99); // exact fit: reallocation on every append
+	}
+}
+
+UnitTest(Array_Shrink)
+{
+	TArray<int, TAllocatorMock<int>> intArray;
+	TAllocatorMock<int>& allocator = intArray.GetAllocator();
+
+	intArray.Resize(100);
+	intArray.Resize(10); // shrinking keeps the memory as reservation
+	tcheck(intArray.GetCount() == 10);
+	tcheck(intArray.GetReservation() == 90);
+	tcheck(allocator.TotalCount == 1);
+
+	intArray.Shrink(40);
+	tcheck(intArray.GetReservation() == 40);
+	tcheck(allocator.ReAllocCount == 1);
+
+	intArray.Shrink(50); // no-op: reservation is already smaller
+	tcheck(intArray.GetReservation() == 40);
+	tcheck(allocator.ReAllocCount == 1);
+
+	intArray.ShrinkToFit();
+	tcheck(intArray.GetCount() == 10);
+	tcheck(intArray.GetReservation() == 0);
+	tcheck(allocator.ReAllocCount == 2);
+
+	intArray.Clear();
+	tcheck(intArray.GetData() == nullptr);
+	tcheck(allocator.FreeCount == 1);
+}
+
+UnitTest(Array_MoveSemantics)
+{
+	static uint copyCount = 0;
+	static uint moveCount = 0;
+	static uint destructCount = 0;
+	copyCount = 0; // the counters are static, start over on repeated runs
+	moveCount = 0;
+	destructCount = 0;
+
+	struct SMoveMock
+	{
+		int Value;
+
+		explicit SMoveMock(const int value) : Value(value)
+		{
+		}
+
+		SMoveMock(const SMoveMock& other) : Value(other.Value)
+		{
+			++copyCount;
+		}
+
+		SMoveMock(SMoveMock&& other) noexcept : Value(other.Value)
+		{
+			other.Value = -1;
+			++moveCount;
+		}
+
+		~SMoveMock()
+		{
+			++destructCount;
+		}
+	};
+
+	{
+		TArray<SMoveMock> mockArray;
+		for (int i = 0; i < 100; ++i)
+		{
+			mockArray.Emplace(i);
+		}
+		tcheck(copyCount == 0); // relocation on growth moves elements instead of copying them
+
+		mockArray.Add(SMoveMock(100));
+		tcheck(copyCount == 0);
+		tcheck(mockArray.GetCount() == 101);
+
+		bool valid = true;
+		for (int i = 0; i < 101; ++i)
+		{
+			valid &= mockArray[i].Value == i;
+		}
+		tcheck(valid);
+
+		const uint moveCountBefore = moveCount;
+		TArray<SMoveMock> movedArray = std::move(mockArray);
+		tcheck(moveCount == moveCountBefore); // moving the array steals the memory, elements stay in place
+		tcheck(mockArray.GetCount() == 0);
+		tcheck(mockArray.GetData() == nullptr);
+		tcheck(movedArray.GetCount() == 101);
+
+		TArray<SMoveMock> assignedArray;
+		assignedArray.Emplace(5);
+		assignedArray = std::move(movedArray);
+		tcheck(movedArray.GetData() == nullptr);
+		tcheck(assignedArray.GetCount() == 101);
+		tcheck(assignedArray[100].Value == 100);
+
+		TArray<SMoveMock> copiedArray;
+		copiedArray = assignedArray;
+		tcheck(copyCount == 101);
+		tcheck(copiedArray[50].Value == 50);
+	}
+	tcheck(destructCount == copyCount + moveCount + 102); // every constructed instance was destroyed
+
+	{
+		struct SMoveOnly
+		{
+			int* Ptr;
+
+			explicit SMoveOnly(int* ptr) : Ptr(ptr)
+			{
+			}
+
+			SMoveOnly(const SMoveOnly&) = delete;
+
+			SMoveOnly(SMoveOnly&& other) noexcept : Ptr(other.Ptr)
+			{
+				other.Ptr = nullptr;
+			}
+		};
+
+		int values[3] = {1, 2, 3};
+		TArray<SMoveOnly> moveOnlyArray;
+		moveOnlyArray.Emplace(values);
+		moveOnlyArray.Emplace(values + 1);
+		moveOnlyArray.Add(SMoveOnly(values + 2));
+		tcheck(moveOnlyArray.GetCount() == 3);
+		tcheck(*moveOnlyArray[2].Ptr == 3);
+	}
+
+	{
+		TArray<FString> stringArray;
+		stringArray.Add("first");
+		for (int i = 0; i < 20; ++i)
+		{
+			stringArray.Add(stringArray[0]); // argument aliases the array being grown
+		}
+		tcheck(stringArray.GetCount() == 21);
+		tcheck(strcmp(stringArray[20].GetData(), "first") == 0);
+	}
+}
+
+UnitTest(Array_InlineAllocator)
+{
+	using FMockAllocator = TAllocatorMock<int>;
+	using FInlineAllocator = TInlineAllocator<8, FMockAllocator>;
+
+	{
+		TArray<int, FInlineAllocator> intArray;
+		FMockAllocator& heap = intArray.GetAllocator().Fallback;
+
+		for (int i = 0; i < 8; ++i)
+		{
+			intArray.Add(i);
+		}
+		tcheck(intArray.GetCount() == 8);
+		tcheck(intArray.GetAllocator().IsInline(intArray.GetData()));
+		tcheck(heap.TotalCount == 0); // first N elements never touch the heap
+
+		intArray.Add(8); // spill
+		tcheck(!intArray.GetAllocator().IsInline(intArray.GetData()));
+		tcheck(heap.AllocCount == 1);
+		tcheck(heap.TotalCount == 1);
+
+		bool valid = true;
+		for (int i = 0; i < 9; ++i)
+		{
+			valid &= intArray[i] == i;
+		}
+		tcheck(valid);
+
+		intArray.Resize(4);
+		intArray.ShrinkToFit(); // fits back into the inline block
+		tcheck(intArray.GetAllocator().IsInline(intArray.GetData()));
+		tcheck(heap.FreeCount == 1);
+		tcheck(intArray[3] == 3);
+
+		TArray<int, FInlineAllocator> movedArray = std::move(intArray); // inline elements are moved one by one
+		tcheck(movedArray.GetAllocator().IsInline(movedArray.GetData()));
+		tcheck(movedArray.GetCount() == 4);
+		tcheck(movedArray[3] == 3);
+		tcheck(intArray.GetData() == nullptr);
+
+		intArray.Clear();
+		tcheck(heap.TotalCount == 2);
+	}
+
+	{
+		TArray<FString, TInlineAllocator<2, TAllocatorMock<FString>>> stringArray;
+		TAllocatorMock<FString>& heap = stringArray.GetAllocator().Fallback;
+		stringArray.Add("a");
+		stringArray.Add("b");
+		tcheck(heap.TotalCount == 0);
+		stringArray.Add("a rather long string that does not fit inline");
+		tcheck(heap.AllocCount == 1);
+		tcheck(heap.ReAllocCount == 0); // not trivially relocatable: move-constructed into a fresh block
+		tcheck(strcmp(stringArray[1].GetData(), "b") == 0);
+
+		TArray<FString, TInlineAllocator<2, TAllocatorMock<FString>>> movedArray = std::move(stringArray);
+		tcheck(movedArray.GetCount() == 3);
+		tcheck(strcmp(movedArray[2].GetData(), "a rather long string that does not fit inline") == 0);
+	}
+}
+
+UnitTest(Array_InsertRemove)
+{
+	TArray<int> intArray = {0, 1, 2, 3};
+	intArray.EmplaceAt(0, -1);
+	intArray.EmplaceAt(2, 42);
+	intArray.EmplaceAt(intArray.GetCount(), 4);
+	tcheck(intArray.GetCount() == 7);
+	tcheck(intArray[0] == -1 && intArray[1] == 0 && intArray[2] == 42 && intArray[3] == 1 && intArray[6] == 4);
+
+	intArray.EmplaceAt(1, intArray[6]); // argument aliases an element that gets shifted
+	tcheck(intArray[1] == 4);
+
+	intArray.RemoveAt(1);
+	intArray.RemoveAt(2);
+	tcheck(intArray.GetCount() == 6);
+	intArray.RemoveAt(3, 3);
+	tcheck(intArray.GetCount() == 3);
+	tcheck(intArray[0] == -1 && intArray[1] == 0 && intArray[2] == 1);
+
+	TArray<FString> stringArray;
+	stringArray.Add("b");
+	stringArray.Add("a rather long string that does not fit inline");
+	stringArray.EmplaceAt(0, "a");
+	stringArray.EmplaceAt(1, "another long string that does not fit inline");
+	tcheck(strcmp(stringArray[0].GetData(), "a") == 0);
+	tcheck(strcmp(stringArray[1].GetData(), "another long string that does not fit inline") == 0);
+	tcheck(strcmp(stringArray[3].GetData(), "a rather long string that does not fit inline") == 0);
+
+	stringArray.RemoveAt(0, 2);
+	tcheck(stringArray.GetCount() == 2);
+	tcheck(strcmp(stringArray[0].GetData(), "b") == 0);
+	tcheck(strcmp(stringArray[1].GetData(), "a rather long string that does not fit inline") == 0);
+}
+
+Benchmark(Array_Add)
+{
+	bench.Measure("Growing", []
+	{
+		TArray<uint> values;
+		for (uint i = 0; i < 1000; ++i)
+		{
+			values.Add(i);
+		}
+		FBenchmark::DoNotOptimize(values[999]);
+	});
+
+	bench.Measure("Reserved", []
+	{
+		TArray<uint> values;
+		values.Reserve(1000);
+		for (uint i = 0; i < 1000; ++i)
+		{
+			values.Add(i);
+		}
+		FBenchmark::DoNotOptimize(values[999]);
+	});
+
+	bench.Measure("String", []
+	{
+		TArray<FString> values;
+		for (uint i = 0; i < 100; ++i)
+		{
+			values.Emplace("a rather long string that does not fit inline");
+		}
+		FBenchmark::DoNotOptimize(values[99]);
+	});
+
+	// append throughput against std::vector, one iteration fills a whole array
+	const char* sizeNames[] = {"1K", "1M", "100M"};
+	const uint sizes[] = {1000, 1000000, 100000000};
+	for (uint size = 0; size < 3; ++size)
+	{
+		const uint count = sizes[size];
+		char variant[32];
+		FFormat::ToBuffer(variant, sizeof(variant), "TArray/{}", sizeNames[size]);
+		bench.Measure(variant, [count]
+		{
+			TArray<uint> values;
+			for (uint i = 0; i < count; ++i)
+			{
+				values.Add(i);
+			}
+			FBenchmark::DoNotOptimize(values[count - 1]);
+		});
+
+		FFormat::ToBuffer(variant, sizeof(variant), "std::vector/{}", sizeNames[size]);
+		bench.Measure(variant, [count]
+		{
+			std::vector<uint> values;
+			for (uint i = 0; i < count; ++i)
+			{
+				values.push_back(i);
+			}
+			FBenchmark::DoNotOptimize(values[count - 1]);
+		});
+	}
+}
@@ -24,7 +24,37 @@
 
 #pragma once
 
-template <typename T, typename TAllocator = TRawAllocator<T>>
+/**
+ * Geometric growth policy: once the reservation is used up, the capacity is multiplied by TNumerator / TDenominator.
+ * Gives amortized O(1) appends
+ */
+template <size_t TNumerator = 3, size_t TDenominator = 2>
+struct TGeometricGrowthPolicy
+{
+	static_assert(TNumerator > TDenominator, "Geometric growth factor must be greater than 1");
+
+	FORCEINLINE static size_t GetCapacity(const size_t capacity, const size_t requiredCapacity)
+	{
+		const size_t grownCapacity = capacity / TDenominator * TNumerator + capacity % TDenominator * TNumerator / TDenominator;
+		return grownCapacity > requiredCapacity ? grownCapacity : requiredCapacity;
+	}
+};
+
+/**
+ * Exact fit growth policy: the array never allocates more slots than it needs.
+ * Every append past the reservation reallocates, use only for arrays that rarely grow
+ */
+struct FExactGrowthPolicy
+{
+	FORCEINLINE static size_t GetCapacity(const size_t, const size_t requiredCapacity)
+	{
+		return requiredCapacity;
+	}
+};
+
+using FDefaultGrowthPolicy = TGeometricGrowthPolicy<3, 2>;
+
+template <typename T, typename TAllocator = TRawAllocator<T>, typename TGrowthPolicy = FDefaultGrowthPolicy>
 class TArray
 {
 	static_assert(TAllocator::kCanAllocateMany, "TArray requires an allocator with kCanAllocateMany");
@@ -61,21 +91,34 @@ class TArray
 		}
 		else
 		{
-			if (m_Array)
+			if (!m_Array)
+			{
+				m_Array = m_Allocator.Alloc(newSize);
+			}
+			else if constexpr (TIsTriviallyRelocatable<T>::kValue)
 			{
-				m_Array = m_Allocator.ReAlloc(m_Array, newSize);
+				m_Array = m_Allocator.ReAlloc(m_Array, newSize); // elements can be moved around as raw bytes
 			}
 			else
 			{
-				m_Array = m_Allocator.Alloc(newSize);
+				// move-construct elements into the new memory, realloc would skip their move constructors
+				T* newArray = m_Allocator.Alloc(newSize);
+				const size_t relocatedCount = m_Count < newSize ? m_Count : newSize;
+				for (size_t i = 0; i < relocatedCount; ++i)
+				{
+					new(newArray + i) T(std::move(m_Array[i]));
+					(m_Array + i)->~T();
+				}
+				m_Allocator.Free(m_Array);
+				m_Array = newArray;
 			}
 		}
 	}
 
 	FORCEINLINE void InitFromRaw(const T* arr, const size_t count)
 	{
+		RawResize(count);
 		m_Count = count;
-		RawResize(m_Count);
 
 		for (size_t i = 0; i < count; ++i)
 		{
@@ -86,13 +129,54 @@ class TArray
 	FORCEINLINE void InternalShrink(const size_t count) // separate function to avoid unnecessary exemplar construction
 	{
 		check(count < m_Count);
-		const size_t deletedElements = m_Count - count;
 		for (size_t i = count; i < m_Count; ++i)
 		{
 			(m_Array + i)->~T(); // call destructors on all elements
 		}
+		m_Reservation += m_Count - count; // keep the memory: freed slots become reserved
 		m_Count = count;
-		RawResize(m_Count + m_Reservation); // reallocate array with new count
+	}
+
+	/**
+	 * Take over the elements of another array. This array must be empty
+	 */
+	FORCEINLINE void MoveFrom(TArray& other)
+	{
+		if (other.m_Allocator.IsInline(other.m_Array)) // inline memory can't change owners: move element by element
+		{
+			RawResize(other.m_Count + other.m_Reservation);
+			for (size_t i = 0; i < other.m_Count; ++i)
+			{
+				new(m_Array + i) T(std::move(other.m_Array[i]));
+				(other.m_Array + i)->~T();
+			}
+			other.m_Allocator.Free(other.m_Array);
+		}
+		else
+		{
+			m_Array = other.m_Array;
+		}
+
+		m_Count = other.m_Count;
+		m_Reservation = other.m_Reservation;
+		other.m_Array = nullptr;
+		other.m_Count = 0;
+		other.m_Reservation = 0;
+	}
+
+	/**
+	 * Make room for at least `count` elements, growing the capacity according to the growth policy
+	 */
+	FORCEINLINE void Grow(const size_t count)
+	{
+		check(count > m_Count + m_Reservation);
+		size_t capacity = TGrowthPolicy::GetCapacity(m_Count + m_Reservation, count);
+		if (count <= TAllocator::kInlineCount)
+		{
+			capacity = TAllocator::kInlineCount; // take the whole inline block right away
+		}
+		m_Reservation = capacity - m_Count;
+		RawResize(capacity);
 	}
 
 public:
@@ -100,21 +184,23 @@ public:
 
 	FORCEINLINE TArray() = default;
 
+	explicit FORCEINLINE TArray(const TAllocator& allocator) : m_Allocator(allocator)
+	{
+	}
+
 	explicit FORCEINLINE TArray(const size_t count, const T* data)
 	{
 		InitFromRaw(data, count);
 	}
 
-	FORCEINLINE TArray(const TArray& other)
+	FORCEINLINE TArray(const TArray& other) : m_Allocator(other.m_Allocator)
 	{
 		InitFromRaw(other.m_Array, other.m_Count);
 	}
 
-	FORCEINLINE TArray(TArray&& other) noexcept
+	FORCEINLINE TArray(TArray&& other) noexcept : m_Allocator(std::move(other.m_Allocator))
 	{
-		m_Allocator = std::move(other.m_Allocator);
-		m_Count = std::move(other.m_Count);
-		m_Array = std::move(other.m_Array);
+		MoveFrom(other);
 	}
 
 	FORCEINLINE TArray(std::initializer_list<T> initializerList)
@@ -127,6 +213,27 @@ public:
 		Clear();
 	}
 
+	FORCEINLINE TArray& operator=(const TArray& other)
+	{
+		if (this != &other)
+		{
+			Clear();
+			InitFromRaw(other.m_Array, other.m_Count);
+		}
+		return *this;
+	}
+
+	FORCEINLINE TArray& operator=(TArray&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Clear();
+			m_Allocator = std::move(other.m_Allocator);
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
 	FORCEINLINE void Reserve(const size_t reservation)
 	{
 		if (reservation > m_Reservation)
@@ -136,11 +243,38 @@ public:
 		}
 	}
 
+	/**
+	 * Destroy all elements and release the memory, including the reservation
+	 */
 	FORCEINLINE void Clear()
 	{
-		if (!m_Count)return;
+		if (m_Count)
+		{
+			InternalShrink(0);
+		}
 
-		InternalShrink(0);
+		m_Reservation = 0;
+		RawResize(0);
+	}
+
+	/**
+	 * Release reserved slots so that no more than `maxReservation` remain
+	 */
+	FORCEINLINE void Shrink(const size_t maxReservation)
+	{
+		if (m_Reservation > maxReservation)
+		{
+			m_Reservation = maxReservation;
+			RawResize(m_Count + m_Reservation);
+		}
+	}
+
+	/**
+	 * Release all reserved slots, the array memory is reallocated to fit exactly GetCount() elements
+	 */
+	FORCEINLINE void ShrinkToFit()
+	{
+		Shrink(0);
 	}
 
 	FORCEINLINE bool IsEmpty() const
@@ -158,32 +292,120 @@ public:
 		{
 			const size_t addedElements = count - m_Count;
 			const size_t initialCount = m_Count;
+			if (m_Reservation < addedElements) // if reservation is smaller than added elements
+			{
+				Grow(count); // reallocate array to place elements that didn't get into pre-reserved memory
+			}
+			m_Reservation -= addedElements; // place new elements in reserved memory
 			m_Count = count;
-			if (m_Reservation >= addedElements) // if reservation can handle all added elements
+
+			for (size_t i = initialCount; i < initialCount + addedElements; ++i)
 			{
-				m_Reservation -= addedElements; // place new elements in previously reserved memory
-				//if(m_Reservation) // if there's reserved space left
-				//{
-				//	RawResize(m_Count + m_Reservation); // reallocate array to place elements that didn't get into pre-reserved memory
-				//}
+				new(m_Array + i) T(exemplar); // call copy constructors (<-- exemplar) on all elements
 			}
-			else // if reservation is smaller than added elements
+		}
+	}
+
+	/**
+	 * Construct a new element in place at the end of the array
+	 */
+	template <typename...Args>
+	FORCEINLINE T& Emplace(Args&&...args)
+	{
+		if (!m_Reservation)
+		{
+			// args may reference elements of this array: construct the element before they get relocated by Grow
+			T obj(std::forward<Args>(args)...);
+			Grow(m_Count + 1);
+			new(m_Array + m_Count) T(std::move(obj));
+		}
+		else
+		{
+			new(m_Array + m_Count) T(std::forward<Args>(args)...);
+		}
+
+		--m_Reservation;
+		return m_Array[m_Count++];
+	}
+
+	/**
+	 * Construct a new element in place at `index`, elements from `index` on are shifted towards the end
+	 */
+	template <typename...Args>
+	FORCEINLINE T& EmplaceAt(const size_t index, Args&&...args)
+	{
+		check(index <= m_Count);
+		if (index == m_Count)
+		{
+			return Emplace(std::forward<Args>(args)...);
+		}
+
+		T obj(std::forward<Args>(args)...); // args may reference elements that are about to be shifted
+		if (!m_Reservation)
+		{
+			Grow(m_Count + 1);
+		}
+
+		if constexpr (TIsTriviallyRelocatable<T>::kValue)
+		{
+			FMemory::Move(m_Array + index + 1, m_Array + index, (m_Count - index) * sizeof(T));
+			new(m_Array + index) T(std::move(obj));
+		}
+		else
+		{
+			new(m_Array + m_Count) T(std::move(m_Array[m_Count - 1]));
+			for (size_t i = m_Count - 1; i > index; --i)
 			{
-				m_Reservation = 0; // place all new elements in pre-reserved memory
-				RawResize(m_Count + m_Reservation);
-				// reallocate array to place elements that didn't get into pre-reserved memory 
+				m_Array[i] = std::move(m_Array[i - 1]);
 			}
+			m_Array[index] = std::move(obj);
+		}
 
-			for (size_t i = initialCount; i < initialCount + addedElements; ++i)
+		--m_Reservation;
+		++m_Count;
+		return m_Array[index];
+	}
+
+	/**
+	 * Remove `count` elements starting at `index`, the following elements are shifted to close the gap
+	 */
+	FORCEINLINE void RemoveAt(const size_t index, const size_t count = 1)
+	{
+		check(index + count <= m_Count);
+		if (!count)return;
+
+		if constexpr (TIsTriviallyRelocatable<T>::kValue)
+		{
+			for (size_t i = index; i < index + count; ++i)
 			{
-				new(m_Array + i) T(exemplar); // call copy constructors (<-- exemplar) on all elements
+				(m_Array + i)->~T();
+			}
+			FMemory::Move(m_Array + index, m_Array + index + count, (m_Count - index - count) * sizeof(T));
+		}
+		else
+		{
+			for (size_t i = index; i + count < m_Count; ++i)
+			{
+				m_Array[i] = std::move(m_Array[i + count]);
+			}
+			for (size_t i = m_Count - count; i < m_Count; ++i)
+			{
+				(m_Array + i)->~T();
 			}
 		}
+
+		m_Count -= count;
+		m_Reservation += count;
 	}
 
 	FORCEINLINE void Add(const T& obj)
 	{
-		Resize(m_Count + 1, obj);
+		Emplace(obj);
+	}
+
+	FORCEINLINE void Add(T&& obj)
+	{
+		Emplace(std::move(obj));
 	}
 
 	FORCEINLINE T& operator[](size_t index)
@@ -241,3 +463,9 @@ public:
 		return m_Array + m_Count;
 	}
 };
+
+template <typename T, EAllocationPurpose TPurpose, size_t TSize, typename TGrowthPolicy>
+struct TIsTriviallyRelocatable<TArray<T, TRawAllocator<T, TPurpose, TSize>, TGrowthPolicy>>
+{
+	const static bool kValue = true; // heap storage only: nothing points back into the array object
+};
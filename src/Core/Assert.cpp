@@ -90,6 +90,15 @@ bool AssertInternal::Assert(const char* code, const char* filename, const uint l
 {
 	if (gIgnoreAsserts)return false;
 
+	FConsole::FlushOnCrash(); // the process may end right after the dialog
+
+	if (FConsole::IsHeadless()) // nobody is there to answer the dialog
+	{
+		FConsole::WriteLine(FFormat::Format("Assertion failed: {} ({}:{})", code, filename, line));
+		FConsole::FlushOnCrash();
+		::ExitProcess(2);
+	}
+
 	EAssertResponse response = EAssertResponse::Abort;
 
 	const size_t codeLen = strlen(code) + 1;
@@ -0,0 +1,520 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+/**
+ * Check the B+tree invariants below `node`: keys ascending and within (lower, upper], node fill within bounds, every
+ * leaf at the same depth and the leaves linked in key order
+ */
+template <typename TMapType>
+static bool ValidateBTreeNode(TMapType& map, typename TMapType::SNode* node, const uint depth, const typename TMapType::PairType::FirstType* lower,
+                              const typename TMapType::PairType::FirstType* upper, typename TMapType::SLeafNode*& prevLeaf, size_t& count)
+{
+	using TKey = typename TMapType::PairType::FirstType;
+
+	if (node->IsLeaf != (depth == map.GetDepth()))
+	{
+		return false;
+	}
+
+	if (node->IsLeaf)
+	{
+		auto* leaf = (typename TMapType::SLeafNode*)node;
+		const bool sparseAllowed = !depth || !leaf->Next; // the root, or the last leaf while keys are appended
+		if (!leaf->Count || leaf->Count > TMapType::kLeafCapacity || (leaf->Count < TMapType::kLeafMinCount && !sparseAllowed))
+		{
+			return false;
+		}
+		if (leaf->Prev != prevLeaf || (prevLeaf && prevLeaf->Next != leaf))
+		{
+			return false;
+		}
+
+		const auto* pairs = leaf->GetPairs();
+		for (uint i = 0; i < leaf->Count; ++i)
+		{
+			const TKey& key = pairs[i].First;
+			if ((lower && !(*lower < key)) || (upper && *upper < key) || (i && !(pairs[i - 1].First < key)))
+			{
+				return false;
+			}
+		}
+		prevLeaf = leaf;
+		count += leaf->Count;
+		return true;
+	}
+
+	auto* inner = (typename TMapType::SInnerNode*)node;
+	if (!inner->Count || inner->Count > TMapType::kInnerCapacity || (depth && inner->Count < TMapType::kInnerMinCount))
+	{
+		return false;
+	}
+
+	const TKey* keys = inner->GetKeys();
+	for (uint i = 0; i < inner->Count; ++i)
+	{
+		if ((lower && !(*lower < keys[i])) || (upper && *upper < keys[i]) || (i && !(keys[i - 1] < keys[i])))
+		{
+			return false;
+		}
+	}
+	for (uint i = 0; i <= inner->Count; ++i)
+	{
+		if (!ValidateBTreeNode(map, inner->Children[i], depth + 1, i ? keys + i - 1 : lower, i < inner->Count ? keys + i : upper, prevLeaf, count))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename TMapType>
+static bool ValidateBTree(TMapType& map)
+{
+	if (!map.GetRootNode())
+	{
+		return map.GetCount() == 0 && map.begin() == map.end() && map.GetAllocatedSize() == 0;
+	}
+
+	typename TMapType::SLeafNode* lastLeaf = nullptr;
+	size_t count = 0;
+	return ValidateBTreeNode(map, map.GetRootNode(), 0, nullptr, nullptr, lastLeaf, count) && !lastLeaf->Next &&
+		count == map.GetCount();
+}
+
+UnitTest(BTreeMap_Basic)
+{
+	TBTreeMap<int, int> map;
+	tcheck(map.GetCount() == 0);
+	tcheck(map.begin() == map.end());
+	tcheck(map.rbegin() == map.rend());
+	tcheck(map.Find(1) == nullptr);
+	map.Remove(1);
+
+	map.Insert(3, 10);
+	map.Insert(21, 10);
+	map.Insert(-32, 10);
+	map.Insert(17, 199);
+	map.Insert(7, 10444);
+	map.Insert(7, 1); // already present: ignored
+	tcheck(map.GetCount() == 5);
+	tcheck(map[17] == 199);
+	tcheck(map[7] == 10444);
+	map[7] = 99;
+	tcheck(map[7] == 99);
+
+	map.InsertOrUpdate(3, 42);
+	map.InsertOrUpdate(4, 43);
+	tcheck(map[3] == 42);
+	tcheck(map[4] == 43);
+	tcheck(map.GetCount() == 6);
+	tcheck(map.FindOrAdd(4, 1000) == 43);
+	tcheck(map.Contains(-32)); // signed keys keep their order through the SIMD search
+	tcheck(!map.Contains(-31));
+
+	const int expected[] = {-32, 3, 4, 7, 17, 21};
+	bool ordered = true;
+	uint iterated = 0;
+	for (TPair<int, int>& pair : map)
+	{
+		ordered &= iterated < 6 && pair.First == expected[iterated++];
+	}
+	tcheck(ordered && iterated == 6);
+
+	for (auto it = map.rbegin(); it != map.rend(); ++it)
+	{
+		ordered &= iterated > 0 && (*it).First == expected[--iterated];
+	}
+	tcheck(ordered && iterated == 0);
+
+	map.Remove(21);
+	map.Remove(1000); // not present
+	tcheck(map.GetCount() == 5);
+	tcheck(ValidateBTree(map));
+
+	map.Clear();
+	tcheck(map.GetCount() == 0);
+	tcheck(ValidateBTree(map));
+}
+
+UnitTest(BTreeMap_Churn)
+{
+	TBTreeMap<uint, uint> map;
+	TBTreeMap<uint, uint64> wideMap; // 16 byte pairs: the other SIMD leaf layout
+	bool present[20000]{};
+	size_t expectedCount = 0;
+
+	// grow to several levels, then shrink back to nothing: splits, borrows and merges at every level
+	uint seed = 1234;
+	bool valid = true;
+	for (uint i = 0; i < 300000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223; // LCG
+		const uint key = (seed >> 8) % 20000;
+		const bool insert = i < 150000 ? (seed >> 4) % 4 != 0 : (seed >> 4) % 4 == 0;
+		if (insert && !present[key])
+		{
+			map.Insert(key, key * 3);
+			wideMap.Insert(key, key * 3ull);
+			present[key] = true;
+			++expectedCount;
+		}
+		else if (!insert && present[key])
+		{
+			map.Remove(key);
+			wideMap.Remove(key);
+			present[key] = false;
+			--expectedCount;
+		}
+
+		if (i % 10000 == 0)
+		{
+			valid &= ValidateBTree(map) && ValidateBTree(wideMap);
+		}
+	}
+	tcheck(valid);
+	tcheck(map.GetCount() == expectedCount);
+	tcheck(wideMap.GetCount() == expectedCount);
+
+	bool found = true;
+	for (uint key = 0; key < 20000; ++key)
+	{
+		const uint* value = map.Find(key);
+		const uint64* wideValue = wideMap.Find(key);
+		found &= present[key] ? value && *value == key * 3 && wideValue && *wideValue == key * 3ull : !value && !wideValue;
+	}
+	tcheck(found);
+
+	for (uint key = 0; key < 20000; ++key)
+	{
+		map.Remove(key);
+	}
+	tcheck(map.GetCount() == 0);
+	tcheck(ValidateBTree(map));
+}
+
+UnitTest(BTreeMap_Sequential)
+{
+	TBTreeMap<uint, uint> map;
+	constexpr uint kCount = 100000;
+	for (uint i = 0; i < kCount; ++i)
+	{
+		map.Insert(i, i);
+	}
+	tcheck(ValidateBTree(map));
+
+	// appending leaves full leaves behind
+	const size_t leafCount = (kCount + TBTreeMap<uint, uint>::kLeafCapacity - 1) / TBTreeMap<uint, uint>::kLeafCapacity;
+	tcheck(map.GetAllocatedSize() < leafCount * sizeof(TBTreeMap<uint, uint>::SLeafNode) * 11 / 10);
+
+	uint expected = 0;
+	bool ordered = true;
+	for (const TPair<uint, uint>& pair : map)
+	{
+		ordered &= pair.First == expected++;
+	}
+	tcheck(ordered && expected == kCount);
+
+	for (auto it = map.rbegin(); it != map.rend(); ++it)
+	{
+		ordered &= (*it).First == --expected;
+	}
+	tcheck(ordered && expected == 0);
+
+	for (uint i = kCount; i-- > 0;)
+	{
+		map.Remove(i);
+	}
+	tcheck(ValidateBTree(map));
+}
+
+UnitTest(BTreeMap_Strings)
+{
+	// small nodes (the capacities are set by the key and pair size) and keys that are not trivially relocatable
+	using FStringMap = TBTreeMap<FString, FString>;
+	static_assert(FStringMap::kInnerCapacity == 8 && FStringMap::kLeafCapacity == 8, "capacities changed, the test no longer covers deep trees");
+
+	FStringMap map;
+	bool present[2000]{};
+	const auto makeKey = [](const uint key)
+	{
+		return FFormat::Format("key {} is long enough for the heap", 10000 + key); // fixed width: string order is key order
+	};
+
+	uint seed = 99;
+	bool valid = true;
+	for (uint i = 0; i < 20000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		const uint key = (seed >> 8) % 2000;
+		if (present[key])
+		{
+			map.Remove(makeKey(key));
+		}
+		else
+		{
+			map.Insert(makeKey(key), makeKey(key * 2));
+		}
+		present[key] = !present[key];
+
+		if (i % 1000 == 0)
+		{
+			valid &= ValidateBTree(map);
+		}
+	}
+	tcheck(valid);
+	tcheck(map.GetDepth() >= 3);
+
+	bool found = true;
+	for (uint key = 0; key < 2000; ++key)
+	{
+		const FString* value = map.Find(makeKey(key));
+		found &= present[key] ? value && *value == makeKey(key * 2) : !value;
+	}
+	tcheck(found);
+	tcheck(map.Contains(makeKey(0).GetData()) == present[0]); // heterogeneous lookup
+
+	FStringMap moved = std::move(map);
+	tcheck(map.GetCount() == 0);
+	tcheck(ValidateBTree(map));
+	tcheck(ValidateBTree(moved));
+}
+
+UnitTest(BTreeMap_Range)
+{
+	using FMapType = TBTreeMap<uint, uint>;
+	FMapType map;
+	tcheck(map.LowerBound(5u) == map.end());
+	tcheck(map.Range(0u, 100u).IsEmpty());
+	tcheck(map.Range(0u, 100u).rbegin() == map.Range(0u, 100u).rend());
+
+	for (uint i = 0; i < 1000; ++i)
+	{
+		map.Insert(i * 10, i);
+	}
+	for (uint i = 0; i < 1000; i += 3)
+	{
+		map.Remove(i * 10); // partly filled leaves, and separators above keys that are gone
+	}
+	tcheck(map.GetDepth() >= 1);
+	tcheck(ValidateBTree(map));
+
+	tcheck((*map.LowerBound(40u)).First == 40);
+	tcheck((*map.LowerBound(41u)).First == 50);
+	tcheck((*map.LowerBound(30u)).First == 40); // removed
+	tcheck((*map.UpperBound(40u)).First == 50);
+	tcheck(map.LowerBound(9991u) == map.end());
+	tcheck(map.UpperBound(9980u) == map.end());
+
+	const TPair<FMapType::Iterator, FMapType::Iterator> found = map.EqualRange(50u);
+	tcheck((*found.First).First == 50 && (*found.Second).First == 70);
+	const TPair<FMapType::Iterator, FMapType::Iterator> missing = map.EqualRange(55u);
+	tcheck(missing.First == missing.Second && (*missing.First).First == 70);
+
+	// bounds that fall between leaves must give the first pair of the next leaf
+	bool boundsValid = true;
+	FMapType::Iterator next = map.begin();
+	for (uint key = 0; key < 10010; ++key)
+	{
+		while (next != map.end() && (*next).First < key)
+		{
+			++next;
+		}
+		boundsValid &= map.LowerBound(key) == next;
+	}
+	tcheck(boundsValid);
+
+	// every range against a filtered full scan, both directions, including empty, inverted and out of bounds ones
+	bool forwardValid = true;
+	bool reverseValid = true;
+	for (uint lo = 0; lo < 10020; lo += 37)
+	{
+		for (uint hi = 0; hi < 10020; hi += 41)
+		{
+			TArray<uint> expected;
+			for (const TPair<uint, uint>& pair : map)
+			{
+				if (pair.First >= lo && pair.First < hi)
+				{
+					expected.Add(pair.First);
+				}
+			}
+
+			size_t index = 0;
+			for (const TPair<uint, uint>& pair : map.Range(lo, hi))
+			{
+				forwardValid &= index < expected.GetCount() && pair.First == expected[index++];
+			}
+			forwardValid &= index == expected.GetCount() && map.Range(lo, hi).IsEmpty() == expected.IsEmpty();
+
+			for (const TPair<uint, uint>& pair : reverse(map.Range(lo, hi)))
+			{
+				reverseValid &= index > 0 && pair.First == expected[--index];
+			}
+			reverseValid &= index == 0;
+		}
+	}
+	tcheck(forwardValid);
+	tcheck(reverseValid);
+
+	TBTreeMap<FString, uint> stringMap;
+	stringMap.Insert("apple", 1);
+	stringMap.Insert("banana", 2);
+	stringMap.Insert("cherry", 3);
+	stringMap.Insert("date", 4);
+	uint sum = 0;
+	for (const TPair<FString, uint>& pair : stringMap.Range("b", "d")) // looked up by const char*
+	{
+		sum += pair.Second;
+	}
+	tcheck(sum == 2 + 3);
+}
+
+UnitTest(BTreeMap_CopyMove)
+{
+	TBTreeMap<uint, FString> map;
+	for (uint i = 0; i < 1000; ++i)
+	{
+		map.Insert(i * 3, FFormat::Format("value {}", i));
+	}
+
+	TBTreeMap<uint, FString> copy(map);
+	tcheck(ValidateBTree(copy));
+	tcheck(copy.GetCount() == map.GetCount());
+	copy.Remove(0u);
+	*copy.Find(3u) = "changed";
+	tcheck(map.GetCount() == 1000);
+	tcheck(*map.Find(0u) == "value 0");
+	tcheck(*map.Find(3u) == "value 1");
+
+	copy = map;
+	tcheck(ValidateBTree(copy));
+	bool equal = copy.GetCount() == map.GetCount();
+	for (uint i = 0; i < 1000; ++i)
+	{
+		equal &= *copy.Find(i * 3) == *map.Find(i * 3);
+	}
+	tcheck(equal);
+
+	TBTreeMap<uint, FString> moved(std::move(copy));
+	tcheck(copy.GetCount() == 0);
+	tcheck(ValidateBTree(copy));
+	tcheck(moved.GetCount() == 1000);
+	tcheck(ValidateBTree(moved));
+
+	TBTreeMap<uint, FString> target;
+	target.Insert(1u, "dropped");
+	target = std::move(moved);
+	tcheck(moved.GetCount() == 0);
+	tcheck(ValidateBTree(moved));
+	tcheck(target.GetCount() == 1000 && !target.Find(1u));
+	tcheck(*target.Find(2997u) == "value 999");
+
+	copy.Insert(7u, "reused"); // moved-from maps stay usable
+	tcheck(copy.GetCount() == 1);
+}
+
+/**
+ * A bijection on 32-bit integers: distinct keys spread over the whole range
+ */
+static FORCEINLINE uint GetBTreeBenchmarkKey(const uint i)
+{
+	uint x = i * 0x9E3779B1u;
+	x ^= x >> 16;
+	return x * 0x85EBCA6Bu;
+}
+
+/**
+ * TMap against TBTreeMap on the same random keys. Bytes per key are reported on the Find results.
+ * Insert runs last: it adds new keys to the maps that were just measured
+ */
+Benchmark(BTreeMap_VsMap)
+{
+	using FMap = TMap<uint, uint>;
+	using FBTreeMap = TBTreeMap<uint, uint>;
+
+	for (const uint count : {1000000u, 10000000u})
+	{
+		FMap map;
+		FBTreeMap btree;
+		for (uint i = 0; i < count; ++i)
+		{
+			map.Insert(GetBTreeBenchmarkKey(i), i);
+			btree.Insert(GetBTreeBenchmarkKey(i), i);
+		}
+
+		char variant[32];
+		uint next = 0;
+		FFormat::ToBuffer(variant, sizeof(variant), "Find/TMap/{}M", count / 1000000);
+		bench.Measure(variant, [&map, &next, count]
+		{
+			FBenchmark::DoNotOptimize(map.Find(GetBTreeBenchmarkKey(next++ % count)));
+		});
+		bench.SetBytesPerItem((double)sizeof(FMap::TreeNodeType));
+
+		FFormat::ToBuffer(variant, sizeof(variant), "Find/TBTreeMap/{}M", count / 1000000);
+		bench.Measure(variant, [&btree, &next, count]
+		{
+			FBenchmark::DoNotOptimize(btree.Find(GetBTreeBenchmarkKey(next++ % count)));
+		});
+		bench.SetBytesPerItem((double)btree.GetAllocatedSize() / (double)btree.GetCount());
+
+		FFormat::ToBuffer(variant, sizeof(variant), "Iterate/TMap/{}M", count / 1000000);
+		bench.Measure(variant, [&map]
+		{
+			uint64 sum = 0;
+			for (const TPair<uint, uint>& pair : map)
+			{
+				sum += pair.Second;
+			}
+			FBenchmark::DoNotOptimize(sum);
+		});
+
+		FFormat::ToBuffer(variant, sizeof(variant), "Iterate/TBTreeMap/{}M", count / 1000000);
+		bench.Measure(variant, [&btree]
+		{
+			uint64 sum = 0;
+			for (const TPair<uint, uint>& pair : btree)
+			{
+				sum += pair.Second;
+			}
+			FBenchmark::DoNotOptimize(sum);
+		});
+
+		uint inserted = count;
+		FFormat::ToBuffer(variant, sizeof(variant), "Insert/TMap/{}M", count / 1000000);
+		bench.Measure(variant, [&map, &inserted]
+		{
+			map.Insert(GetBTreeBenchmarkKey(inserted++), 0);
+		});
+
+		inserted = count;
+		FFormat::ToBuffer(variant, sizeof(variant), "Insert/TBTreeMap/{}M", count / 1000000);
+		bench.Measure(variant, [&btree, &inserted]
+		{
+			btree.Insert(GetBTreeBenchmarkKey(inserted++), 0);
+		});
+	}
+}
@@ -0,0 +1,1028 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Number of elements of `elementSize` bytes that fit in `bytes`, clamped to [8, 128] and rounded down to a multiple of
+ * 4, so that SIMD search always reads whole groups of 4 keys inside the node
+ */
+constexpr uint GetBTreeNodeCapacity(const size_t bytes, const size_t elementSize)
+{
+	return (uint)((bytes / elementSize < 8 ? 8 : bytes / elementSize > 128 ? 128 : bytes / elementSize) & ~(size_t)3);
+}
+
+/**
+ * An ordered map laid out as a B+tree. Inner nodes hold only separator keys, contiguous and searched 4 at a time
+ * with SSE2 for 32-bit integer keys, so a lookup takes a handful of cache line bursts instead of one miss per level
+ * of TMap. Pairs live in the leaves, which are linked in both directions for iteration and range scans.
+ * Per entry overhead is a fraction of TMap's three pointers per node. Pairs move when nodes split or merge: pointers
+ * to values are invalidated by Insert and Remove. Lookup, iteration, bounds and ranges work as in TMap
+ */
+template <typename TKey, typename TValue, typename TCompare = FUtils::Less<const TKey>, typename TAllocator = TRawAllocator<uint8>>
+class TBTreeMap
+{
+	static_assert(TAllocator::kCanAllocateMany, "TBTreeMap requires an allocator with kCanAllocateMany");
+	static_assert(std::is_same<typename TAllocator::ElementType, uint8>::value, "TBTreeMap allocates raw bytes");
+
+public:
+	using PairType = TPair<TKey, TValue>;
+	using AllocatorType = TAllocator;
+
+	/**
+	 * Separator keys per inner node (four cache lines of keys) and pairs per leaf (eight cache lines of pairs)
+	 */
+	static constexpr uint kInnerCapacity = GetBTreeNodeCapacity(256, sizeof(TKey));
+	static constexpr uint kLeafCapacity = GetBTreeNodeCapacity(512, sizeof(PairType));
+
+	/**
+	 * Nodes other than the root never have fewer keys (pairs) than this, except the last leaf while keys are appended.
+	 * A full inner node keeps its middle key out of both halves when it splits, hence one less
+	 */
+	static constexpr uint kInnerMinCount = kInnerCapacity / 2 - 1;
+	static constexpr uint kLeafMinCount = kLeafCapacity / 2;
+
+	/**
+	 * Inner levels above the leaves. Every inner node but the root has more than kInnerMinCount children
+	 */
+	static constexpr uint kMaxDepth = 32;
+
+	/**
+	 * Node types are public for external tree inspection
+	 */
+	struct SNode
+	{
+		uint Count = 0; // keys of an inner node, pairs of a leaf
+		bool IsLeaf;
+	};
+
+	/**
+	 * Child i holds the keys in (Keys[i - 1], Keys[i]]: the descent follows the lower bound of the key
+	 */
+	struct alignas(64) SInnerNode : SNode
+	{
+		alignas(TKey) uint8 KeyStorage[sizeof(TKey) * kInnerCapacity];
+		SNode* Children[kInnerCapacity + 1];
+
+		FORCEINLINE TKey* GetKeys()
+		{
+			return (TKey*)KeyStorage;
+		}
+	};
+
+	struct alignas(64) SLeafNode : SNode
+	{
+		SLeafNode* Prev = nullptr;
+		SLeafNode* Next = nullptr;
+		alignas(PairType) uint8 PairStorage[sizeof(PairType) * kLeafCapacity];
+
+		FORCEINLINE PairType* GetPairs()
+		{
+			return (PairType*)PairStorage;
+		}
+	};
+
+private:
+	/**
+	 * Keys are compared with SSE2 when they are 32-bit integers in the default order
+	 */
+	static constexpr bool kSimdKeys = std::is_integral<TKey>::value && sizeof(TKey) == 4 && std::is_same<TCompare, FUtils::Less<const TKey>>::value;
+
+	/**
+	 * Leaf pairs are searched with SIMD too when the keys can be gathered from them with shuffles
+	 */
+	static constexpr bool kSimdLeaves = kSimdKeys && (sizeof(PairType) == 8 || sizeof(PairType) == 16);
+
+	TCompare m_Compare{};
+	TAllocator m_Allocator{};
+
+	SNode* m_Root = nullptr;
+	SLeafNode* m_FirstLeaf = nullptr;
+	SLeafNode* m_LastLeaf = nullptr;
+	size_t m_Count = 0;
+	uint m_Depth = 0;
+
+	size_t m_InnerNodeCount = 0;
+	size_t m_LeafNodeCount = 0;
+
+	/**
+	 * Move `count` elements from `src` to the uninitialized `dst`, leaving `src` uninitialized. The ranges may overlap
+	 */
+	template <typename T>
+	static FORCEINLINE void Relocate(T* dst, T* src, const size_t count)
+	{
+		if constexpr (TIsTriviallyRelocatable<T>::kValue)
+		{
+			FMemory::Move(dst, src, count * sizeof(T));
+		}
+		else if (dst < src)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				new(dst + i) T(std::move(src[i]));
+				src[i].~T();
+			}
+		}
+		else
+		{
+			for (size_t i = count; i-- > 0;)
+			{
+				new(dst + i) T(std::move(src[i]));
+				src[i].~T();
+			}
+		}
+	}
+
+	/**
+	 * Keys of 4 consecutive elements `TStride` 32-bit lanes apart, the key being the first lane of an element
+	 */
+	template <uint TStride>
+	static FORCEINLINE __m128i LoadKeys(const int32* lanes)
+	{
+		if constexpr (TStride == 1)
+		{
+			return _mm_loadu_si128((const __m128i*)lanes);
+		}
+		else if constexpr (TStride == 2)
+		{
+			const __m128 a = _mm_loadu_ps((const float*)lanes);
+			const __m128 b = _mm_loadu_ps((const float*)lanes + 4);
+			return _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+		else
+		{
+			const __m128 ab = _mm_shuffle_ps(_mm_loadu_ps((const float*)lanes), _mm_loadu_ps((const float*)lanes + 4), _MM_SHUFFLE(0, 0, 0, 0));
+			const __m128 cd = _mm_shuffle_ps(_mm_loadu_ps((const float*)lanes + 8), _mm_loadu_ps((const float*)lanes + 12), _MM_SHUFFLE(0, 0, 0, 0));
+			return _mm_castps_si128(_mm_shuffle_ps(ab, cd, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+	}
+
+	/**
+	 * Number of keys less than `key` among `count` sorted keys. Groups past `count` are never read, but the tail of
+	 * the last group is: node capacities are multiples of 4, so it is still inside the node
+	 */
+	template <uint TStride>
+	static FORCEINLINE uint SimdLowerBound(const void* elements, const uint count, const TKey key)
+	{
+		// SSE2 compares are signed: flip the top bit of unsigned keys to keep their order
+		const __m128i bias = _mm_set1_epi32(std::is_signed<TKey>::value ? 0 : (int32)0x80000000);
+		const __m128i needle = _mm_xor_si128(_mm_set1_epi32((int32)key), bias);
+
+		const int32* lanes = (const int32*)elements;
+		for (uint i = 0; i < count; i += 4)
+		{
+			const __m128i keys = _mm_xor_si128(LoadKeys<TStride>(lanes + i * TStride), bias);
+			const uint32 less = (uint32)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(needle, keys)));
+			if (less != 0xF)
+			{
+				// sorted keys: the mask is a run of ones from the lowest bit, lanes past `count` may extend it
+				const uint index = i + FUtils::CountTrailingZeros(~less);
+				return index < count ? index : count;
+			}
+		}
+		return count;
+	}
+
+	template <typename U>
+	static constexpr bool CanSearchSimd()
+	{
+		return kSimdKeys && (std::is_same<U, TKey>::value ||
+			(std::is_integral<U>::value && sizeof(U) <= sizeof(TKey) && std::is_signed<U>::value == std::is_signed<TKey>::value));
+	}
+
+	template <typename U>
+	FORCEINLINE uint LowerBound(SInnerNode* node, const U& key) const
+	{
+		if constexpr (CanSearchSimd<U>())
+		{
+			return SimdLowerBound<1>(node->GetKeys(), node->Count, (TKey)key);
+		}
+		else
+		{
+			TKey* keys = node->GetKeys();
+			return (uint)(FAlgorithms::LowerBound(keys, keys + node->Count, key, m_Compare) - keys);
+		}
+	}
+
+	template <typename U>
+	FORCEINLINE uint LowerBound(SLeafNode* node, const U& key) const
+	{
+		if constexpr (kSimdLeaves && CanSearchSimd<U>())
+		{
+			return SimdLowerBound<sizeof(PairType) / sizeof(int32)>(node->GetPairs(), node->Count, (TKey)key);
+		}
+		else
+		{
+			PairType* pairs = node->GetPairs();
+			return (uint)(FAlgorithms::LowerBound(pairs, pairs + node->Count, key,
+			                                      [this](const PairType& p, const U& k) { return m_Compare(p.First, k); }) - pairs);
+		}
+	}
+
+	/**
+	 * Request the cache lines holding the keys of `node` at once, rather than one by one as the search reaches them
+	 */
+	static FORCEINLINE void PrefetchNode(const SNode* node)
+	{
+		for (uint offset = 0; offset < 256 + 64; offset += 64)
+		{
+			_mm_prefetch((const char*)node + offset, _MM_HINT_T0);
+		}
+	}
+
+	template <typename U>
+	FORCEINLINE SLeafNode* FindLeaf(const U& key) const
+	{
+		SNode* node = m_Root;
+		for (uint depth = 0; depth < m_Depth; ++depth)
+		{
+			SInnerNode* inner = (SInnerNode*)node;
+			node = inner->Children[LowerBound(inner, key)];
+			PrefetchNode(node);
+		}
+		return (SLeafNode*)node;
+	}
+
+	template <typename U>
+	FORCEINLINE PairType* FindPair(const U& key) const
+	{
+		if (!m_Root)return nullptr;
+
+		SLeafNode* leaf = FindLeaf(key);
+		const uint index = LowerBound(leaf, key);
+		return index < leaf->Count && !m_Compare(key, leaf->GetPairs()[index].First) ? leaf->GetPairs() + index : nullptr;
+	}
+
+	SLeafNode* NewLeaf()
+	{
+		SLeafNode* leaf = new(m_Allocator.Alloc(sizeof(SLeafNode), alignof(SLeafNode))) SLeafNode;
+		leaf->IsLeaf = true;
+		++m_LeafNodeCount;
+		return leaf;
+	}
+
+	SInnerNode* NewInner()
+	{
+		SInnerNode* inner = new(m_Allocator.Alloc(sizeof(SInnerNode), alignof(SInnerNode))) SInnerNode;
+		inner->IsLeaf = false;
+		++m_InnerNodeCount;
+		return inner;
+	}
+
+	/**
+	 * Free a node whose elements were destroyed or moved out
+	 */
+	FORCEINLINE void FreeNode(SNode* node)
+	{
+		if (node->IsLeaf)
+		{
+			--m_LeafNodeCount;
+		}
+		else
+		{
+			--m_InnerNodeCount;
+		}
+		m_Allocator.Free((uint8*)node);
+	}
+
+	void DestroyNode(SNode* node, const uint depth)
+	{
+		if (depth == m_Depth)
+		{
+			SLeafNode* leaf = (SLeafNode*)node;
+			for (uint i = 0; i < leaf->Count; ++i)
+			{
+				leaf->GetPairs()[i].~PairType();
+			}
+		}
+		else
+		{
+			SInnerNode* inner = (SInnerNode*)node;
+			for (uint i = 0; i < inner->Count; ++i)
+			{
+				inner->GetKeys()[i].~TKey();
+			}
+			for (uint i = 0; i <= inner->Count; ++i)
+			{
+				DestroyNode(inner->Children[i], depth + 1);
+			}
+		}
+		FreeNode(node);
+	}
+
+	FORCEINLINE void InsertIntoInner(SInnerNode* inner, const uint index, TKey&& key, SNode* child)
+	{
+		TKey* keys = inner->GetKeys();
+		Relocate(keys + index + 1, keys + index, inner->Count - index);
+		new(keys + index) TKey(std::move(key));
+		FMemory::Move(inner->Children + index + 2, inner->Children + index + 1, (inner->Count - index) * sizeof(SNode*));
+		inner->Children[index + 1] = child;
+		++inner->Count;
+	}
+
+	/**
+	 * Add `child` right after the child that was split along `path`, separated by `separator`. Full inner nodes are
+	 * split in turn, up to a new root
+	 */
+	void InsertChild(SInnerNode** path, const uint* indices, const TKey& separator, SNode* child)
+	{
+		TKey key(separator);
+		for (uint depth = m_Depth; depth-- > 0;)
+		{
+			SInnerNode* inner = path[depth];
+			const uint index = indices[depth];
+			if (inner->Count < kInnerCapacity)
+			{
+				InsertIntoInner(inner, index, std::move(key), child);
+				return;
+			}
+
+			// the middle key moves up, the keys right of it go to a new sibling
+			constexpr uint kMiddle = kInnerCapacity / 2;
+			SInnerNode* sibling = NewInner();
+			TKey* keys = inner->GetKeys();
+			TKey promoted(std::move(keys[kMiddle]));
+			keys[kMiddle].~TKey();
+			Relocate(sibling->GetKeys(), keys + kMiddle + 1, kInnerCapacity - kMiddle - 1);
+			FMemory::Copy(sibling->Children, inner->Children + kMiddle + 1, (kInnerCapacity - kMiddle) * sizeof(SNode*));
+			sibling->Count = kInnerCapacity - kMiddle - 1;
+			inner->Count = kMiddle;
+
+			if (index <= kMiddle)
+			{
+				InsertIntoInner(inner, index, std::move(key), child);
+			}
+			else
+			{
+				InsertIntoInner(sibling, index - kMiddle - 1, std::move(key), child);
+			}
+			key = std::move(promoted);
+			child = sibling;
+		}
+
+		check(m_Depth < kMaxDepth);
+		SInnerNode* root = NewInner();
+		new(root->GetKeys()) TKey(std::move(key));
+		root->Children[0] = m_Root;
+		root->Children[1] = child;
+		root->Count = 1;
+		m_Root = root;
+		++m_Depth;
+	}
+
+	/**
+	 * Split the full `leaf` before a pair is inserted at `index`, which is updated to the leaf and index the pair
+	 * goes to
+	 */
+	void SplitLeaf(SInnerNode** path, const uint* indices, SLeafNode*& leaf, uint& index)
+	{
+		// appending past the last key of the map leaves the leaf full: ascending loads fill every leaf completely
+		const uint splitIndex = index == kLeafCapacity && !leaf->Next ? kLeafCapacity : kLeafCapacity / 2;
+
+		SLeafNode* sibling = NewLeaf();
+		Relocate(sibling->GetPairs(), leaf->GetPairs() + splitIndex, kLeafCapacity - splitIndex);
+		sibling->Count = kLeafCapacity - splitIndex;
+		leaf->Count = splitIndex;
+
+		sibling->Prev = leaf;
+		sibling->Next = leaf->Next;
+		(leaf->Next ? leaf->Next->Prev : m_LastLeaf) = sibling;
+		leaf->Next = sibling;
+
+		InsertChild(path, indices, leaf->GetPairs()[splitIndex - 1].First, sibling);
+		if (index >= splitIndex)
+		{
+			leaf = sibling;
+			index -= splitIndex;
+		}
+	}
+
+	/**
+	 * Remove the key at `keyIndex` and the child right of it from the inner node at `depth` of `path`, then refill
+	 * or merge inner nodes that drop below kInnerMinCount keys, up to the root
+	 */
+	void RemoveChild(SInnerNode** path, const uint* indices, uint depth, uint keyIndex)
+	{
+		while (true)
+		{
+			SInnerNode* inner = path[depth];
+			TKey* keys = inner->GetKeys();
+			keys[keyIndex].~TKey();
+			Relocate(keys + keyIndex, keys + keyIndex + 1, inner->Count - keyIndex - 1);
+			FMemory::Move(inner->Children + keyIndex + 1, inner->Children + keyIndex + 2, (inner->Count - keyIndex - 1) * sizeof(SNode*));
+			--inner->Count;
+
+			if (!depth)
+			{
+				if (!inner->Count) // a single child left: it becomes the root
+				{
+					m_Root = inner->Children[0];
+					FreeNode(inner);
+					--m_Depth;
+				}
+				return;
+			}
+
+			if (inner->Count >= kInnerMinCount)return;
+
+			SInnerNode* parent = path[depth - 1];
+			TKey* parentKeys = parent->GetKeys();
+			const uint index = indices[depth - 1];
+			SInnerNode* left = index > 0 ? (SInnerNode*)parent->Children[index - 1] : nullptr;
+			SInnerNode* right = index < parent->Count ? (SInnerNode*)parent->Children[index + 1] : nullptr;
+
+			// borrow through the parent: its separator comes down, the sibling's outermost key goes up
+			if (left && left->Count > kInnerMinCount)
+			{
+				Relocate(keys + 1, keys, inner->Count);
+				FMemory::Move(inner->Children + 1, inner->Children, (inner->Count + 1) * sizeof(SNode*));
+				Relocate(keys, parentKeys + index - 1, 1);
+				Relocate(parentKeys + index - 1, left->GetKeys() + left->Count - 1, 1);
+				inner->Children[0] = left->Children[left->Count];
+				--left->Count;
+				++inner->Count;
+				return;
+			}
+			if (right && right->Count > kInnerMinCount)
+			{
+				Relocate(keys + inner->Count, parentKeys + index, 1);
+				Relocate(parentKeys + index, right->GetKeys(), 1);
+				inner->Children[inner->Count + 1] = right->Children[0];
+				Relocate(right->GetKeys(), right->GetKeys() + 1, right->Count - 1);
+				FMemory::Move(right->Children, right->Children + 1, right->Count * sizeof(SNode*));
+				--right->Count;
+				++inner->Count;
+				return;
+			}
+
+			// merge with a sibling around a copy of their separator, which is then removed from the parent
+			SInnerNode* mergeLeft = left ? left : inner;
+			SInnerNode* mergeRight = left ? inner : right;
+			const uint separator = left ? index - 1 : index;
+			TKey* leftKeys = mergeLeft->GetKeys();
+			new(leftKeys + mergeLeft->Count) TKey(parentKeys[separator]);
+			Relocate(leftKeys + mergeLeft->Count + 1, mergeRight->GetKeys(), mergeRight->Count);
+			FMemory::Copy(mergeLeft->Children + mergeLeft->Count + 1, mergeRight->Children, (mergeRight->Count + 1) * sizeof(SNode*));
+			mergeLeft->Count += mergeRight->Count + 1;
+			FreeNode(mergeRight);
+
+			--depth;
+			keyIndex = separator;
+		}
+	}
+
+	/**
+	 * Refill `leaf`, which dropped below kLeafMinCount pairs, from a sibling or merge it with one
+	 */
+	void RebalanceLeaf(SInnerNode** path, const uint* indices, SLeafNode* leaf)
+	{
+		SInnerNode* parent = path[m_Depth - 1];
+		const uint index = indices[m_Depth - 1];
+		SLeafNode* left = index > 0 ? (SLeafNode*)parent->Children[index - 1] : nullptr;
+		SLeafNode* right = index < parent->Count ? (SLeafNode*)parent->Children[index + 1] : nullptr;
+
+		if (left && left->Count > kLeafMinCount)
+		{
+			Relocate(leaf->GetPairs() + 1, leaf->GetPairs(), leaf->Count);
+			Relocate(leaf->GetPairs(), left->GetPairs() + left->Count - 1, 1);
+			--left->Count;
+			++leaf->Count;
+			parent->GetKeys()[index - 1] = left->GetPairs()[left->Count - 1].First;
+			return;
+		}
+		if (right && right->Count > kLeafMinCount)
+		{
+			Relocate(leaf->GetPairs() + leaf->Count, right->GetPairs(), 1);
+			Relocate(right->GetPairs(), right->GetPairs() + 1, right->Count - 1);
+			--right->Count;
+			++leaf->Count;
+			parent->GetKeys()[index] = leaf->GetPairs()[leaf->Count - 1].First;
+			return;
+		}
+
+		SLeafNode* mergeLeft = left ? left : leaf;
+		SLeafNode* mergeRight = left ? leaf : right;
+		Relocate(mergeLeft->GetPairs() + mergeLeft->Count, mergeRight->GetPairs(), mergeRight->Count);
+		mergeLeft->Count += mergeRight->Count;
+		mergeLeft->Next = mergeRight->Next;
+		(mergeRight->Next ? mergeRight->Next->Prev : m_LastLeaf) = mergeLeft;
+		FreeNode(mergeRight);
+
+		RemoveChild(path, indices, m_Depth - 1, left ? index - 1 : index);
+	}
+
+	/**
+	 * Returns the pair of `key` and whether it was inserted, its value constructed from `args`
+	 */
+	template <typename...Args>
+	TPair<PairType*, bool> FindOrEmplace(const TKey& key, Args&&...args)
+	{
+		if (!m_Root)
+		{
+			m_Root = m_FirstLeaf = m_LastLeaf = NewLeaf();
+		}
+
+		SInnerNode* path[kMaxDepth];
+		uint indices[kMaxDepth];
+		SNode* node = m_Root;
+		for (uint depth = 0; depth < m_Depth; ++depth)
+		{
+			SInnerNode* inner = (SInnerNode*)node;
+			path[depth] = inner;
+			indices[depth] = LowerBound(inner, key);
+			node = inner->Children[indices[depth]];
+		}
+
+		SLeafNode* leaf = (SLeafNode*)node;
+		uint index = LowerBound(leaf, key);
+		if (index < leaf->Count && !m_Compare(key, leaf->GetPairs()[index].First))
+		{
+			return TPair<PairType*, bool>(leaf->GetPairs() + index, false);
+		}
+
+		if (leaf->Count == kLeafCapacity)
+		{
+			SplitLeaf(path, indices, leaf, index);
+		}
+
+		PairType* pairs = leaf->GetPairs();
+		Relocate(pairs + index + 1, pairs + index, leaf->Count - index);
+		new(pairs + index) PairType(FEmplaceSecond(), key, std::forward<Args>(args)...);
+		++leaf->Count;
+		++m_Count;
+		return TPair<PairType*, bool>(pairs + index, true);
+	}
+
+public:
+	class Iterator
+	{
+		friend TBTreeMap;
+
+		SLeafNode* m_Leaf;
+		uint m_Index;
+
+		FORCEINLINE Iterator(SLeafNode* leaf, const uint index) : m_Leaf(leaf), m_Index(index)
+		{
+		}
+
+	public:
+		void operator++()
+		{
+			check(m_Leaf);
+			if (++m_Index == m_Leaf->Count)
+			{
+				m_Leaf = m_Leaf->Next;
+				m_Index = 0;
+			}
+		}
+
+		PairType& operator*()
+		{
+			check(m_Leaf);
+			return m_Leaf->GetPairs()[m_Index];
+		}
+
+		const PairType& operator*() const
+		{
+			check(m_Leaf);
+			return m_Leaf->GetPairs()[m_Index];
+		}
+
+		bool operator==(const Iterator& other) const
+		{
+			return m_Leaf == other.m_Leaf && m_Index == other.m_Index;
+		}
+
+		bool operator!=(const Iterator& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	class ReverseIterator
+	{
+		friend TBTreeMap;
+
+		SLeafNode* m_Leaf;
+		uint m_Index;
+
+		FORCEINLINE ReverseIterator(SLeafNode* leaf, const uint index) : m_Leaf(leaf), m_Index(index)
+		{
+		}
+
+	public:
+		void operator++()
+		{
+			check(m_Leaf);
+			if (m_Index)
+			{
+				--m_Index;
+				return;
+			}
+
+			m_Leaf = m_Leaf->Prev;
+			m_Index = m_Leaf ? m_Leaf->Count - 1 : 0;
+		}
+
+		PairType& operator*()
+		{
+			check(m_Leaf);
+			return m_Leaf->GetPairs()[m_Index];
+		}
+
+		const PairType& operator*() const
+		{
+			check(m_Leaf);
+			return m_Leaf->GetPairs()[m_Index];
+		}
+
+		bool operator==(const ReverseIterator& other) const
+		{
+			return m_Leaf == other.m_Leaf && m_Index == other.m_Index;
+		}
+
+		bool operator!=(const ReverseIterator& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	/**
+	 * The pairs with keys in [lo, hi), see TBTreeMap::Range. Forward and reverse iteration visit only these pairs
+	 */
+	class KeyRange
+	{
+		friend TBTreeMap;
+
+		Iterator m_First;
+		Iterator m_End;
+		ReverseIterator m_Last; // last pair in the range, or the pair before an empty range
+		ReverseIterator m_BeforeFirst;
+
+		KeyRange(const Iterator first, const Iterator end, const ReverseIterator last, const ReverseIterator beforeFirst)
+			: m_First(first), m_End(end), m_Last(last), m_BeforeFirst(beforeFirst)
+		{
+		}
+
+	public:
+		FORCEINLINE bool IsEmpty() const
+		{
+			return m_First == m_End;
+		}
+
+		FORCEINLINE Iterator begin() const
+		{
+			return m_First;
+		}
+
+		FORCEINLINE Iterator end() const
+		{
+			return m_End;
+		}
+
+		FORCEINLINE ReverseIterator rbegin() const
+		{
+			return m_Last;
+		}
+
+		FORCEINLINE ReverseIterator rend() const
+		{
+			return m_BeforeFirst;
+		}
+	};
+
+private:
+	/**
+	 * Position `index` of `leaf`, one past its last pair being the first pair of the next leaf
+	 */
+	static FORCEINLINE Iterator MakeIterator(SLeafNode* leaf, const uint index)
+	{
+		return index < leaf->Count ? Iterator(leaf, index) : Iterator(leaf->Next, 0);
+	}
+
+	/**
+	 * The pair before `it` in reverse iteration order: the last pair of the map for end()
+	 */
+	FORCEINLINE ReverseIterator GetPrevious(const Iterator it) const
+	{
+		if (!it.m_Leaf)
+		{
+			return rbegin();
+		}
+		if (it.m_Index)
+		{
+			return ReverseIterator(it.m_Leaf, it.m_Index - 1);
+		}
+		SLeafNode* prev = it.m_Leaf->Prev;
+		return ReverseIterator(prev, prev ? prev->Count - 1 : 0);
+	}
+
+	void CopyFrom(const TBTreeMap& other)
+	{
+		Clear();
+		// ascending appends leave every leaf but the last one full
+		for (const PairType& pair : other)
+		{
+			FindOrEmplace(pair.First, pair.Second);
+		}
+	}
+
+	FORCEINLINE void StealFrom(TBTreeMap& other)
+	{
+		m_Root = other.m_Root;
+		m_FirstLeaf = other.m_FirstLeaf;
+		m_LastLeaf = other.m_LastLeaf;
+		m_Count = other.m_Count;
+		m_Depth = other.m_Depth;
+		m_InnerNodeCount = other.m_InnerNodeCount;
+		m_LeafNodeCount = other.m_LeafNodeCount;
+
+		other.m_Root = nullptr;
+		other.m_FirstLeaf = nullptr;
+		other.m_LastLeaf = nullptr;
+		other.m_Count = 0;
+		other.m_Depth = 0;
+		other.m_InnerNodeCount = 0;
+		other.m_LeafNodeCount = 0;
+	}
+
+public:
+	FORCEINLINE TBTreeMap() = default;
+
+	explicit FORCEINLINE TBTreeMap(const TAllocator& allocator) : m_Allocator(allocator)
+	{
+	}
+
+	/**
+	 * Copies own their nodes, filled in one ascending pass over `other`
+	 */
+	TBTreeMap(const TBTreeMap& other) : m_Compare(other.m_Compare), m_Allocator(other.m_Allocator)
+	{
+		CopyFrom(other);
+	}
+
+	FORCEINLINE TBTreeMap(TBTreeMap&& other) noexcept : m_Compare(std::move(other.m_Compare)), m_Allocator(std::move(other.m_Allocator))
+	{
+		StealFrom(other);
+	}
+
+	TBTreeMap& operator=(const TBTreeMap& other)
+	{
+		if (this != &other)
+		{
+			m_Compare = other.m_Compare;
+			CopyFrom(other);
+		}
+		return *this;
+	}
+
+	TBTreeMap& operator=(TBTreeMap&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Clear(); // the nodes go back to the allocator that is about to be replaced
+			m_Compare = std::move(other.m_Compare);
+			m_Allocator = std::move(other.m_Allocator);
+			StealFrom(other);
+		}
+		return *this;
+	}
+
+	FORCEINLINE ~TBTreeMap()
+	{
+		Clear();
+	}
+
+	FORCEINLINE void Insert(const TKey& key, const TValue& value)
+	{
+		FindOrEmplace(key, value);
+	}
+
+	FORCEINLINE void InsertOrUpdate(const TKey& key, const TValue& value)
+	{
+		const TPair<PairType*, bool> result = FindOrEmplace(key, value);
+		if (!result.Second)
+		{
+			result.First->Second = value;
+		}
+	}
+
+	template <typename U>
+	void Remove(const U& key)
+	{
+		if (!m_Root)return;
+
+		SInnerNode* path[kMaxDepth];
+		uint indices[kMaxDepth];
+		SNode* node = m_Root;
+		for (uint depth = 0; depth < m_Depth; ++depth)
+		{
+			SInnerNode* inner = (SInnerNode*)node;
+			path[depth] = inner;
+			indices[depth] = LowerBound(inner, key);
+			node = inner->Children[indices[depth]];
+		}
+
+		SLeafNode* leaf = (SLeafNode*)node;
+		const uint index = LowerBound(leaf, key);
+		PairType* pairs = leaf->GetPairs();
+		if (index == leaf->Count || m_Compare(key, pairs[index].First))return;
+
+		pairs[index].~PairType();
+		Relocate(pairs + index, pairs + index + 1, leaf->Count - index - 1);
+		--leaf->Count;
+		--m_Count;
+
+		if (!m_Depth)
+		{
+			if (!leaf->Count)
+			{
+				FreeNode(leaf);
+				m_Root = m_FirstLeaf = m_LastLeaf = nullptr;
+			}
+			return;
+		}
+
+		// separators stay valid upper bounds when the largest key of a leaf goes away: only underflow needs work
+		if (leaf->Count < kLeafMinCount)
+		{
+			RebalanceLeaf(path, indices, leaf);
+		}
+	}
+
+	/**
+	 * Returns the value of `key` or null. Never allocates.
+	 * `key` may be of any type TCompare can compare with TKey
+	 */
+	template <typename U>
+	FORCEINLINE TValue* Find(const U& key)
+	{
+		PairType* pair = FindPair(key);
+		return pair ? &pair->Second : nullptr;
+	}
+
+	template <typename U>
+	FORCEINLINE const TValue* Find(const U& key) const
+	{
+		return const_cast<TBTreeMap*>(this)->Find(key);
+	}
+
+	template <typename U>
+	FORCEINLINE bool Contains(const U& key) const
+	{
+		return FindPair(key) != nullptr;
+	}
+
+	/**
+	 * Returns the value of `key`, inserting one constructed in place from `args` if the key is missing
+	 */
+	template <typename...Args>
+	FORCEINLINE TValue& FindOrAdd(const TKey& key, Args&&...args)
+	{
+		return FindOrEmplace(key, std::forward<Args>(args)...).First->Second;
+	}
+
+	FORCEINLINE TValue& operator[](const TKey& key)
+	{
+		return FindOrAdd(key);
+	}
+
+	/**
+	 * Returns the first pair whose key is not less than `key`, or end(). O(log n)
+	 */
+	template <typename U>
+	FORCEINLINE Iterator LowerBound(const U& key) const
+	{
+		if (!m_Root)return end();
+
+		SLeafNode* leaf = FindLeaf(key);
+		return MakeIterator(leaf, LowerBound(leaf, key));
+	}
+
+	/**
+	 * Returns the first pair whose key is greater than `key`, or end(). O(log n)
+	 */
+	template <typename U>
+	FORCEINLINE Iterator UpperBound(const U& key) const
+	{
+		return EqualRange(key).Second;
+	}
+
+	/**
+	 * Returns LowerBound and UpperBound of `key`: the pair with that key, or an empty range where it would be
+	 */
+	template <typename U>
+	FORCEINLINE TPair<Iterator, Iterator> EqualRange(const U& key) const
+	{
+		if (!m_Root)return TPair<Iterator, Iterator>(end(), end());
+
+		SLeafNode* leaf = FindLeaf(key);
+		const Iterator first = MakeIterator(leaf, LowerBound(leaf, key));
+		if (first.m_Leaf && !m_Compare(key, (*first).First))
+		{
+			return TPair<Iterator, Iterator>(first, MakeIterator(first.m_Leaf, first.m_Index + 1));
+		}
+		return TPair<Iterator, Iterator>(first, first);
+	}
+
+	/**
+	 * The pairs with keys in [lo, hi) in ascending order, or descending through reverse(). Empty if hi is not greater
+	 * than lo. O(log n) to find the ends, then the scan follows the leaf links
+	 */
+	template <typename U, typename V>
+	FORCEINLINE KeyRange Range(const U& lo, const V& hi) const
+	{
+		const Iterator first = LowerBound(lo);
+		Iterator last = LowerBound(hi);
+		if (!first.m_Leaf || (last.m_Leaf && m_Compare((*last).First, (*first).First)))
+		{
+			last = first;
+		}
+		return KeyRange(first, last, GetPrevious(last), GetPrevious(first));
+	}
+
+	FORCEINLINE size_t GetCount() const
+	{
+		return m_Count;
+	}
+
+	/**
+	 * Inner levels above the leaves, 0 for a single leaf
+	 */
+	FORCEINLINE uint GetDepth() const
+	{
+		return m_Depth;
+	}
+
+	FORCEINLINE SNode* GetRootNode() const
+	{
+		return m_Root;
+	}
+
+	/**
+	 * Bytes held in nodes
+	 */
+	FORCEINLINE size_t GetAllocatedSize() const
+	{
+		return m_InnerNodeCount * sizeof(SInnerNode) + m_LeafNodeCount * sizeof(SLeafNode);
+	}
+
+	FORCEINLINE TAllocator& GetAllocator()
+	{
+		return m_Allocator;
+	}
+
+	void Clear()
+	{
+		if (m_Root)
+		{
+			DestroyNode(m_Root, 0);
+		}
+		m_Root = nullptr;
+		m_FirstLeaf = nullptr;
+		m_LastLeaf = nullptr;
+		m_Count = 0;
+		m_Depth = 0;
+	}
+
+	FORCEINLINE Iterator begin() const
+	{
+		return Iterator(m_FirstLeaf, 0);
+	}
+
+	FORCEINLINE Iterator end() const
+	{
+		return Iterator(nullptr, 0);
+	}
+
+	FORCEINLINE ReverseIterator rbegin() const
+	{
+		return ReverseIterator(m_LastLeaf, m_LastLeaf ? m_LastLeaf->Count - 1 : 0);
+	}
+
+	FORCEINLINE ReverseIterator rend() const
+	{
+		return ReverseIterator(nullptr, 0);
+	}
+};
@@ -0,0 +1,362 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef PF_UNIT_TEST
+#include "pch.h"
+
+TArray<__SBenchmarkDesc, TRawAllocator<__SBenchmarkDesc, EAllocationPurpose::InternalDynamicInit>> __gBenchmarks;
+
+static const volatile void* volatile gBenchmarkEscapedPointer = nullptr;
+
+void FBenchmark::Escape(const volatile void* pointer)
+{
+	gBenchmarkEscapedPointer = pointer;
+}
+
+/**
+ * Allocations made through FMemory so far, all purposes and threads
+ */
+static uint64 GetBenchmarkAllocCount()
+{
+	uint64 count = 0;
+	for (uint purpose = 0; purpose < (uint)EAllocationPurpose::Max; ++purpose)
+	{
+		count += FMemory::GetPurposeStats((EAllocationPurpose)purpose).AllocCount;
+	}
+	return count;
+}
+
+FBenchmark::FBenchmark(const char* name) : m_Name(name)
+{
+	LARGE_INTEGER frequency;
+	::QueryPerformanceFrequency(&frequency);
+	m_Frequency = frequency.QuadPart;
+}
+
+void FBenchmark::BeginSampling()
+{
+	m_InitialAllocCount = GetBenchmarkAllocCount();
+}
+
+void FBenchmark::EndSampling(const FStringView variant, const uint64 batchSize, const uint sampleCount)
+{
+	const uint64 allocCount = GetBenchmarkAllocCount() - m_InitialAllocCount;
+
+	SBenchmarkResult& result = m_Results.Emplace();
+	result.Name = m_Name;
+	if (!variant.IsEmpty())
+	{
+		result.Name += "/";
+		result.Name += variant;
+	}
+	result.BatchSize = batchSize;
+	result.SampleCount = sampleCount;
+
+	FAlgorithms::Sort(m_Samples, m_Samples + sampleCount);
+	const double nsPerTick = 1e9 / (double)m_Frequency / (double)batchSize;
+	const uint middle = sampleCount / 2;
+	const uint p99 = (sampleCount * 99 + 99) / 100 - 1; // nearest rank
+	result.MinNs = (double)m_Samples[0] * nsPerTick;
+	result.MedianNs = (sampleCount % 2 ? (double)m_Samples[middle] : (double)(m_Samples[middle - 1] + m_Samples[middle]) / 2.0) * nsPerTick;
+	result.P99Ns = (double)m_Samples[p99] * nsPerTick;
+
+#ifdef PF_ENABLE_PROFILING
+	result.AllocsPerIteration = (double)allocCount / (double)(batchSize * sampleCount);
+#else
+	(void)allocCount;
+#endif
+}
+
+struct SBenchmarkBaselineEntry
+{
+	FString Name;
+	double MedianNs = 0.0;
+};
+
+/**
+ * Read the name and median of every entry of a JSON file written by WriteBenchmarkJson.
+ * Not a general JSON parser: it relies on "name" coming before "median_ns" in every entry
+ */
+static void ParseBenchmarkBaseline(const FStringView json, TArray<SBenchmarkBaselineEntry>& outEntries)
+{
+	const FStringView nameKey = "\"name\":";
+	const FStringView medianKey = "\"median_ns\":";
+	const auto skipWhitespace = [&json](size_t& position)
+	{
+		while (position < json.GetLength() && json[position] && strchr(" \t\r\n", json[position]))
+		{
+			++position;
+		}
+	};
+
+	size_t position = 0;
+	while ((position = json.Find(nameKey, position)) != FStringView::kNotFound)
+	{
+		position += nameKey.GetLength();
+		skipWhitespace(position);
+		if (position == json.GetLength() || json[position] != '"')
+		{
+			continue;
+		}
+		++position;
+
+		FString name;
+		while (position < json.GetLength() && json[position] != '"')
+		{
+			if (json[position] == '\\' && position + 1 < json.GetLength())
+			{
+				++position;
+			}
+			name.Append(json.GetData() + position, 1);
+			++position;
+		}
+
+		const size_t medianPosition = json.Find(medianKey, position);
+		if (medianPosition == FStringView::kNotFound)
+		{
+			break;
+		}
+		position = medianPosition + medianKey.GetLength();
+		skipWhitespace(position);
+
+		char number[64];
+		size_t length = 0;
+		while (position < json.GetLength() && length < sizeof(number) - 1 && json[position] && strchr("0123456789.eE+-", json[position]))
+		{
+			number[length++] = json[position++];
+		}
+		number[length] = 0;
+
+		SBenchmarkBaselineEntry& entry = outEntries.Emplace();
+		entry.Name = std::move(name);
+		entry.MedianNs = atof(number);
+	}
+}
+
+static void WriteBenchmarkJson(FString& out, const TArray<SBenchmarkResult>& results, const TArray<const char*>& files)
+{
+	out.Append("{\"benchmarks\":[");
+	for (size_t i = 0; i < results.GetCount(); ++i)
+	{
+		const SBenchmarkResult& result = results[i];
+		out.Append(i ? ",\n{\"name\":" : "\n{\"name\":");
+		FFormat::AppendJsonString(out, result.Name);
+		out.Append(",\"file\":");
+		FFormat::AppendJsonString(out, files[i]);
+		FFormat::Append(out, ",\"iterations\":{},\"samples\":{},\"min_ns\":{:.3f},\"median_ns\":{:.3f},\"p99_ns\":{:.3f},\"allocs_per_iteration\":",
+		                result.BatchSize * result.SampleCount, result.SampleCount, result.MinNs, result.MedianNs, result.P99Ns);
+		if (result.AllocsPerIteration < 0.0)
+		{
+			out.Append("null");
+		}
+		else
+		{
+			FFormat::Append(out, "{:.3f}", result.AllocsPerIteration);
+		}
+		if (result.BytesPerItem >= 0.0)
+		{
+			FFormat::Append(out, ",\"bytes_per_item\":{:.3f}", result.BytesPerItem);
+		}
+		out.Append("}");
+	}
+	out.Append("\n]}\n");
+}
+
+static void FormatBenchmarkTime(char (&buffer)[32], const double ns)
+{
+	if (ns < 1e3)
+		FFormat::ToBuffer(buffer, sizeof(buffer), "{:.2f} ns", ns);
+	else if (ns < 1e6)
+		FFormat::ToBuffer(buffer, sizeof(buffer), "{:.2f} us", ns / 1e3);
+	else
+		FFormat::ToBuffer(buffer, sizeof(buffer), "{:.2f} ms", ns / 1e6);
+}
+
+void RunBenchmarksAndExit(const SBenchmarkOptions& options)
+{
+	if (options.Headless)
+	{
+		FConsole::InitializeHeadless();
+	}
+	else
+	{
+		FConsole::Initialize();
+	}
+	FConsole::WriteLine("Running benchmarks...");
+	FConsole::WriteLine();
+
+	TArray<SBenchmarkBaselineEntry> baseline;
+	if (options.BaselinePath)
+	{
+		FString json;
+		if (__UnitTestReadFile(options.BaselinePath, json))
+		{
+			ParseBenchmarkBaseline(json, baseline);
+		}
+		else
+		{
+			FConsole::WriteLine("Could not read the baseline file");
+		}
+	}
+
+	TArray<SBenchmarkResult> results;
+	TArray<const char*> files;
+	uint regressionCount = 0;
+
+	FConsole::WriteLine(FFormat::Format("{:<48} {:>12} {:>12} {:>12} {:>10} {:>10} {:>10}", "Benchmark", "median", "min", "p99", "allocs", "bytes/item", "baseline"));
+	for (const __SBenchmarkDesc& desc : __gBenchmarks)
+	{
+		if (!MatchesUnitTestFilter(desc.BenchmarkName, options.Filter))
+		{
+			continue;
+		}
+
+		FBenchmark bench(desc.BenchmarkName);
+		desc.BenchmarkBody(bench);
+
+		for (const SBenchmarkResult& result : bench.GetResults())
+		{
+			char median[32], min[32], p99[32], allocs[32], bytes[32] = "-", change[32] = "";
+			FormatBenchmarkTime(median, result.MedianNs);
+			FormatBenchmarkTime(min, result.MinNs);
+			FormatBenchmarkTime(p99, result.P99Ns);
+			if (result.AllocsPerIteration < 0.0)
+				FFormat::ToBuffer(allocs, sizeof(allocs), "-");
+			else
+				FFormat::ToBuffer(allocs, sizeof(allocs), "{:.2f}", result.AllocsPerIteration);
+			if (result.BytesPerItem >= 0.0)
+				FFormat::ToBuffer(bytes, sizeof(bytes), "{:.1f}", result.BytesPerItem);
+
+			bool regressed = false;
+			for (const SBenchmarkBaselineEntry& entry : baseline)
+			{
+				if (entry.Name == result.Name && entry.MedianNs > 0.0)
+				{
+					const double ratio = result.MedianNs / entry.MedianNs - 1.0;
+					FFormat::ToBuffer(change, sizeof(change), "{:+.1f}%", ratio * 100.0);
+					regressed = ratio > options.RegressionThreshold;
+					break;
+				}
+			}
+
+			if (regressed)
+			{
+				++regressionCount;
+				FConsole::SetTextColor(EConsoleTextColor::Red);
+			}
+			FConsole::WriteLine(FFormat::Format("{:<48} {:>12} {:>12} {:>12} {:>10} {:>10} {:>10}", result.Name, median, min, p99, allocs, bytes, change));
+			if (regressed)
+			{
+				FConsole::SetTextColor(EConsoleTextColor::White);
+			}
+
+			results.Add(result);
+			files.Add(desc.BenchmarkFilename);
+		}
+	}
+
+	if (options.JsonPath)
+	{
+		FString json;
+		WriteBenchmarkJson(json, results, files);
+		if (!__UnitTestWriteFile(options.JsonPath, json))
+		{
+			FConsole::WriteLine("Could not write the JSON file");
+		}
+	}
+
+	FConsole::WriteLine();
+	if (!baseline.IsEmpty())
+	{
+		FConsole::WriteLine(FFormat::Format("{} of {} results regressed by more than {:.0f}% against the baseline",
+		                                    regressionCount, results.GetCount(), options.RegressionThreshold * 100.0));
+	}
+	if (options.BeforeExit)
+	{
+		options.BeforeExit();
+	}
+	if (!options.Headless)
+	{
+		FConsole::Write("Press any key to continue...  ");
+		FConsole::WaitForKey();
+	}
+	FConsole::Flush();
+	::ExitProcess(options.FailOnRegression && regressionCount ? 4 : 0);
+}
+
+Benchmark(Benchmark_Overhead)
+{
+	uint64 counter = 0;
+	bench.Measure([&counter]
+	{
+		FBenchmark::DoNotOptimize(++counter);
+	});
+}
+
+UnitTestExclusive(Benchmark_Statistics)
+{
+	FBenchmark bench("Statistics");
+	uint64 iterations = 0;
+	bench.Measure("Hash", [&iterations]
+	{
+		FBenchmark::DoNotOptimize(FUtils::HashBytes(&++iterations, sizeof(iterations)));
+	});
+	bench.SetBytesPerItem(16.0);
+	bench.Measure([]
+	{
+		void* memory = FMemory::Alloc(64);
+		FBenchmark::DoNotOptimize(memory);
+		FMemory::Free(memory);
+	});
+
+	const TArray<SBenchmarkResult>& results = bench.GetResults();
+	tverify(results.GetCount() == 2);
+	tcheck(results[0].Name == "Statistics/Hash");
+	tcheck(results[1].Name == "Statistics");
+	tcheck(results[0].BytesPerItem == 16.0 && results[1].BytesPerItem < 0.0);
+
+	const SBenchmarkResult& result = results[0];
+	tcheck(result.SampleCount >= FBenchmark::kMinSamples && result.SampleCount <= FBenchmark::kMaxSamples);
+	tcheck(iterations >= result.BatchSize * result.SampleCount); // calibration runs come on top
+	tcheck(result.MinNs > 0.0 && result.MinNs <= result.MedianNs && result.MedianNs <= result.P99Ns);
+#ifdef PF_ENABLE_PROFILING
+	tcheck(result.AllocsPerIteration < 0.5); // other threads may allocate meanwhile, never once per iteration
+	tcheck(results[1].AllocsPerIteration >= 1.0);
+#endif
+
+	// the JSON output reads back as a baseline
+	TArray<const char*> files;
+	files.Add("C:\\Source\\\"Quoted\".cpp");
+	files.Add(__FILE__);
+	FString json;
+	WriteBenchmarkJson(json, results, files);
+	tcheck(json.Find("\"bytes_per_item\":16.000") != FStringView::kNotFound);
+	TArray<SBenchmarkBaselineEntry> baseline;
+	ParseBenchmarkBaseline(json, baseline);
+	tverify(baseline.GetCount() == 2);
+	tcheck(baseline[0].Name == "Statistics/Hash");
+	tcheck(baseline[1].Name == "Statistics");
+	tcheck(baseline[0].MedianNs > result.MedianNs * 0.99 && baseline[0].MedianNs < result.MedianNs * 1.01);
+}
+#endif
@@ -0,0 +1,224 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#ifdef PF_UNIT_TEST
+/**
+ * Timing of one measured operation. Times are per iteration, or per item after FBenchmark::SetItemsPerIteration
+ */
+struct SBenchmarkResult
+{
+	FString Name;
+	uint64 BatchSize = 0; // iterations per sample
+	uint SampleCount = 0;
+	double MinNs = 0.0;
+	double MedianNs = 0.0;
+	double P99Ns = 0.0;
+	double AllocsPerIteration = -1.0; // negative without PF_ENABLE_PROFILING
+	double BytesPerItem = -1.0; // negative unless reported with FBenchmark::SetBytesPerItem
+};
+
+/**
+ * Passed to every Benchmark body. Measure times a callable: the batch size is doubled until a batch takes at least
+ * kMinSampleTimeMs (which also warms caches and branch predictors up), then batches are timed until kMinSamples
+ * were taken and kTargetTimeMs passed, or kMaxSamples were taken
+ */
+class FBenchmark
+{
+public:
+	static constexpr uint kMinSamples = 10;
+	static constexpr uint kMaxSamples = 100;
+	static constexpr double kMinSampleTimeMs = 1.0;
+	static constexpr double kTargetTimeMs = 200.0;
+
+private:
+	const char* m_Name;
+	int64 m_Samples[kMaxSamples];
+	int64 m_Frequency;
+	uint64 m_InitialAllocCount = 0;
+	TArray<SBenchmarkResult> m_Results;
+
+	static FORCEINLINE int64 Now()
+	{
+		LARGE_INTEGER counter;
+		::QueryPerformanceCounter(&counter);
+		return counter.QuadPart;
+	}
+
+	void BeginSampling();
+	void EndSampling(FStringView variant, uint64 batchSize, uint sampleCount);
+
+public:
+	explicit FBenchmark(const char* name);
+
+	/**
+	 * Time `iteration`, which should do a small amount of work. Setup done before the call is not measured.
+	 * Each call adds a result, named "<benchmark>/<variant>" if `variant` is not empty
+	 */
+	template <typename F>
+	void Measure(const FStringView variant, F&& iteration)
+	{
+		const int64 minSampleTicks = (int64)(m_Frequency * kMinSampleTimeMs / 1000.0);
+		const int64 targetTicks = (int64)(m_Frequency * kTargetTimeMs / 1000.0);
+
+		uint64 batchSize = 1;
+		while (true)
+		{
+			const int64 start = Now();
+			for (uint64 i = 0; i < batchSize; ++i)
+			{
+				iteration();
+			}
+			if (Now() - start >= minSampleTicks || batchSize >= ((uint64)1 << 32))
+			{
+				break;
+			}
+			batchSize *= 2;
+		}
+
+		BeginSampling();
+		const int64 samplingStart = Now();
+		uint sampleCount = 0;
+		while (sampleCount < kMaxSamples && (sampleCount < kMinSamples || Now() - samplingStart < targetTicks))
+		{
+			const int64 start = Now();
+			for (uint64 i = 0; i < batchSize; ++i)
+			{
+				iteration();
+			}
+			m_Samples[sampleCount++] = Now() - start;
+		}
+		EndSampling(variant, batchSize, sampleCount);
+	}
+
+	template <typename F>
+	FORCEINLINE void Measure(F&& iteration)
+	{
+		Measure(FStringView(), std::forward<F>(iteration));
+	}
+
+	/**
+	 * Keep the compiler from optimizing away the computation of `value`: its address escapes to a function the
+	 * optimizer cannot see through
+	 */
+	template <typename T>
+	static FORCEINLINE void DoNotOptimize(const T& value)
+	{
+		Escape(&value);
+	}
+
+	static NOINLINE void Escape(const volatile void* pointer);
+
+	/**
+	 * Attach the memory footprint of the measured data structure to the last result, e.g. bytes per stored key
+	 */
+	FORCEINLINE void SetBytesPerItem(const double bytes)
+	{
+		check(!m_Results.IsEmpty());
+		m_Results[m_Results.GetCount() - 1].BytesPerItem = bytes;
+	}
+
+	/**
+	 * Report the last result per item when an iteration processes `items` of them, e.g. ns per job: its times and
+	 * allocation count are divided by `items`
+	 */
+	FORCEINLINE void SetItemsPerIteration(const uint64 items)
+	{
+		check(!m_Results.IsEmpty() && items);
+		SBenchmarkResult& result = m_Results[m_Results.GetCount() - 1];
+		result.MinNs /= (double)items;
+		result.MedianNs /= (double)items;
+		result.P99Ns /= (double)items;
+		if (result.AllocsPerIteration >= 0.0)
+		{
+			result.AllocsPerIteration /= (double)items;
+		}
+	}
+
+	FORCEINLINE const TArray<SBenchmarkResult>& GetResults() const
+	{
+		return m_Results;
+	}
+};
+
+struct __SBenchmarkDesc
+{
+	const char* BenchmarkName;
+	const char* BenchmarkFilename;
+	void(*BenchmarkBody)(FBenchmark& bench);
+};
+
+extern TArray<__SBenchmarkDesc, TRawAllocator<__SBenchmarkDesc, EAllocationPurpose::InternalDynamicInit>> __gBenchmarks;
+
+struct __SBenchmarkFactory
+{
+	__SBenchmarkFactory(const char* benchmarkName, const char* benchmarkFilename, void(*benchmarkBody)(FBenchmark&))
+	{
+		__gBenchmarks.Add(__SBenchmarkDesc{ benchmarkName, benchmarkFilename, benchmarkBody });
+	}
+};
+
+#define Benchmark(name) void __Benchmark_##name(FBenchmark& bench); __SBenchmarkFactory __gBenchmarkFactory_##name(#name, __FILE__, &__Benchmark_##name); void __Benchmark_##name (FBenchmark& bench)
+
+struct SBenchmarkOptions
+{
+	/**
+	 * Comma separated parts of benchmark names: a benchmark runs if its name contains any of them, see
+	 * MatchesUnitTestFilter. Empty runs every benchmark
+	 */
+	FString Filter;
+
+	/**
+	 * Write the results as JSON here
+	 */
+	const wchar_t* JsonPath = nullptr;
+
+	/**
+	 * JSON written by an earlier run to compare the medians against
+	 */
+	const wchar_t* BaselinePath = nullptr;
+
+	/**
+	 * Median slowdown against the baseline that counts as a regression
+	 */
+	double RegressionThreshold = 0.1;
+	bool FailOnRegression = false;
+
+	/**
+	 * Write to the standard output and do not wait for a key at the end, see FConsole::InitializeHeadless
+	 */
+	bool Headless = false;
+
+	/**
+	 * Called after the summary, before the process exits: the runner never returns to the caller
+	 */
+	void (*BeforeExit)() = nullptr;
+};
+
+[[noreturn]] void RunBenchmarksAndExit(const SBenchmarkOptions& options);
+
+#else
+#define Benchmark(name) template <typename TBenchmark> void __unused__Benchmark_##name (TBenchmark& bench)
+#endif
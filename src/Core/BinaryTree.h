@@ -24,9 +24,30 @@
 
 #pragma once
 
-template <typename T>
-struct TBinaryTreeNode
+/**
+ * Optional subtree size augmentation of TBinaryTreeNode, enables order statistics queries (Select and Rank)
+ */
+template <bool TOrderStatistics>
+struct TBinaryTreeNodeAugmentation
+{
+};
+
+template <>
+struct TBinaryTreeNodeAugmentation<true>
 {
+	/**
+	 * Number of nodes in the subtree rooted at this node, including the node itself
+	 */
+	size_t SubtreeSize = 1;
+};
+
+template <typename T, bool TOrderStatistics = false>
+struct TBinaryTreeNode : TBinaryTreeNodeAugmentation<TOrderStatistics>
+{
+	using DataType = T;
+
+	const static bool kOrderStatistics = TOrderStatistics;
+
 	TBinaryTreeNode* Left;
 	TBinaryTreeNode* Parent;
 	TBinaryTreeNode* Right;
@@ -34,7 +55,11 @@ struct TBinaryTreeNode
 
 	T Data;
 
-	explicit TBinaryTreeNode(const T& data) : Left(nullptr), Parent(nullptr), Right(nullptr), IsRed(1), Data(data)
+	/**
+	 * Data is constructed in place from `args`
+	 */
+	template <typename...Args>
+	explicit TBinaryTreeNode(Args&&...args) : Left(nullptr), Parent(nullptr), Right(nullptr), IsRed(1), Data(std::forward<Args>(args)...)
 	{
 	}
 
@@ -134,21 +159,60 @@ struct TBinaryTreeNode
 		return x == Left;
 	}
 
+	/**
+	 * Number of nodes below this one. O(1) with order statistics, otherwise a walk over the subtree that follows
+	 * parent links instead of recursing
+	 */
 	size_t GetChildCount() const
 	{
-		size_t count = 0;
-		if (Left)
+		if constexpr (TOrderStatistics)
 		{
-			count += Left->GetChildCount() + 1;
+			return this->SubtreeSize - 1;
 		}
-		if (Right)
+		else
 		{
-			count += Right->GetChildCount() + 1;
+			size_t count = 0;
+			const TBinaryTreeNode* node = this;
+			const TBinaryTreeNode* previous = Parent;
+			while (true)
+			{
+				const TBinaryTreeNode* next;
+				if (previous == node->Parent) // entered from above
+				{
+					++count;
+					next = node->Left ? node->Left : node->Right;
+				}
+				else // back from a child: go right if coming from the left
+				{
+					next = previous == node->Left ? node->Right : nullptr;
+				}
+
+				if (!next)
+				{
+					if (node == this)break;
+					next = node->Parent;
+				}
+				previous = node;
+				node = next;
+			}
+			return count - 1;
 		}
-		return count;
 	}
 };
 
+/**
+ * Detects allocators with Reserve(count), see TPoolAllocator
+ */
+template <typename TAllocator, typename = void>
+struct THasReserve : std::false_type
+{
+};
+
+template <typename TAllocator>
+struct THasReserve<TAllocator, std::void_t<decltype(std::declval<TAllocator&>().Reserve((size_t)0))>> : std::true_type
+{
+};
+
 /**
  * A generic binary tree implementation.
  * It's also a red black tree
@@ -162,14 +226,83 @@ class TBinaryTree
 
 	TNode* m_RootNode = nullptr;
 
+	/**
+	 * Leftmost and rightmost nodes, so that iteration starts in O(1)
+	 */
+	TNode* m_MinNode = nullptr;
+	TNode* m_MaxNode = nullptr;
+
+	/**
+	 * Number of nodes in the tree, maintained by Insert/DeleteNode/Clear
+	 */
+	size_t m_NodeCount = 0;
+
+	FORCEINLINE static bool IsRed(const TNode* node)
+	{
+		return node && node->IsRed; // null leaves are black
+	}
+
+	FORCEINLINE static size_t GetSubtreeSize(const TNode* node)
+	{
+		return node ? node->SubtreeSize : 0;
+	}
+
+	FORCEINLINE static void UpdateSubtreeSize(TNode* node)
+	{
+		if constexpr (TNode::kOrderStatistics)
+		{
+			node->SubtreeSize = GetSubtreeSize(node->Left) + GetSubtreeSize(node->Right) + 1;
+		}
+	}
+
+	/**
+	 * Add `delta` to the subtree size of `node` and all of its ancestors
+	 */
+	FORCEINLINE static void AdjustSubtreeSizes(TNode* node, const size_t delta)
+	{
+		if constexpr (TNode::kOrderStatistics)
+		{
+			for (; node; node = node->Parent)
+			{
+				node->SubtreeSize += delta;
+			}
+		}
+	}
+
 	template <typename...Args>
-	FORCEINLINE TNode* NewNode(Args& ...args)
+	FORCEINLINE TNode* NewNode(Args&&...args)
 	{
 		TNode* res = m_Allocator.Alloc(1);
-		new(res)TNode(args...);
+		new(res)TNode(std::forward<Args>(args)...);
 		return res;
 	}
 
+	/**
+	 * Attach a fresh node at `slot` (a null child pointer of `parent`) and restore the red black properties
+	 */
+	FORCEINLINE void LinkNode(TNode** slot, TNode* parent, TNode* newNode)
+	{
+		if (!parent)
+		{
+			m_MinNode = newNode;
+			m_MaxNode = newNode;
+		}
+		else if (parent == m_MinNode && slot == &parent->Left)
+		{
+			m_MinNode = newNode;
+		}
+		else if (parent == m_MaxNode && slot == &parent->Right)
+		{
+			m_MaxNode = newNode;
+		}
+
+		*slot = newNode;
+		newNode->Parent = parent;
+		++m_NodeCount;
+		AdjustSubtreeSizes(parent, 1);
+		Balance(newNode);
+	}
+
 	FORCEINLINE void RotateRight(TNode* root)
 	{
 		TNode* pivot = root->Left;
@@ -199,6 +332,9 @@ class TBinaryTree
 
 		pivot->Right = root;
 		root->Parent = pivot;
+
+		UpdateSubtreeSize(root);
+		UpdateSubtreeSize(pivot);
 	}
 
 	FORCEINLINE void RotateLeft(TNode* root)
@@ -230,6 +366,9 @@ class TBinaryTree
 
 		pivot->Left = root;
 		root->Parent = pivot;
+
+		UpdateSubtreeSize(root);
+		UpdateSubtreeSize(pivot);
 	}
 
 	/**
@@ -344,10 +483,8 @@ class TBinaryTree
 			}
 		}
 		
-		*node = NewNode(data);
-		(*node)->Parent = parent;
-		Balance(*node);
-		insertedNode = *node;
+		insertedNode = NewNode(data);
+		LinkNode(node, parent, insertedNode);
 		return true;
 	}
 
@@ -371,96 +508,288 @@ class TBinaryTree
 		{
 			orig->Parent->Right = rep;
 		}
-		rep->Parent = orig->Parent;
+
+		if (rep)
+		{
+			rep->Parent = orig->Parent;
+		}
 	}
 
+	/**
+	 * Free every node of a subtree in O(n) without recursion or a stack: a node with a left child is rotated right,
+	 * which moves that child up, until the node at the top has none. Then it is freed and its right subtree follows
+	 */
 	FORCEINLINE void DeleteTree(TNode* n)
 	{
-		if (!n)return;
+		while (n)
+		{
+			if (TNode* left = n->Left)
+			{
+				n->Left = left->Right;
+				left->Right = n;
+				n = left;
+			}
+			else
+			{
+				TNode* right = n->Right;
+				FreeNode(n);
+				n = right;
+			}
+		}
+	}
 
-		TNode* nLeft = n->Left;
-		TNode* nRight = n->Right;
+	/**
+	 * Link `count` nodes returned by `nextNode()` in ascending order into a perfectly balanced subtree.
+	 * Null links end up at two depths only, floor and ceil of log2(count + 1): nodes at the deeper level (leaves) are
+	 * red, all others black, so every path has the same black height
+	 */
+	template <typename TNextNode>
+	TNode* LinkSortedSubtree(const size_t count, const uint depth, const uint redDepth, TNextNode& nextNode)
+	{
+		if (!count)return nullptr;
+
+		const size_t leftCount = count / 2;
+		TNode* left = LinkSortedSubtree(leftCount, depth + 1, redDepth, nextNode);
+		TNode* node = nextNode();
+		TNode* right = LinkSortedSubtree(count - leftCount - 1, depth + 1, redDepth, nextNode);
+
+		node->Left = left;
+		node->Right = right;
+		node->Parent = nullptr;
+		node->IsRed = depth == redDepth;
+		if (left)
+		{
+			left->Parent = node;
+		}
+		if (right)
+		{
+			right->Parent = node;
+		}
+		if constexpr (TNode::kOrderStatistics)
+		{
+			node->SubtreeSize = count;
+		}
+		return node;
+	}
 
-		FreeNode(n);
-		DeleteTree(nLeft);
-		DeleteTree(nRight);
+	/**
+	 * Replace the structure with `count` nodes given in ascending order. The previous nodes must have been freed or
+	 * be among the given ones
+	 */
+	template <typename TNextNode>
+	void LinkSorted(const size_t count, TNextNode&& nextNode)
+	{
+		uint redDepth = 0; // floor(log2(count + 1))
+		while (((size_t)2 << redDepth) <= count + 1)
+		{
+			++redDepth;
+		}
+
+		m_RootNode = LinkSortedSubtree(count, 0, redDepth, nextNode);
+		m_MinNode = m_RootNode ? m_RootNode->GetMinValueNode() : nullptr;
+		m_MaxNode = m_RootNode ? m_RootNode->GetMaxValueNode() : nullptr;
+		m_NodeCount = count;
 	}
 
-	FORCEINLINE void FixDoubleBlack(TNode* x)
+	/**
+	 * Add the elements of `other` whose keys are missing here, moving them out if `TMove`.
+	 * A few elements are inserted one by one. Otherwise both trees are walked in order side by side, existing nodes
+	 * are kept, and the result is relinked balanced: O(n + m) without a single comparison-driven descent or rotation
+	 */
+	template <bool TMove, typename TOtherTree>
+	void UnionInternal(TOtherTree& other)
+	{
+		const size_t otherCount = other.GetNodeCount();
+		if (!otherCount)return;
+
+		uint log2Count = 1;
+		while (((size_t)1 << log2Count) <= m_NodeCount)
+		{
+			++log2Count;
+		}
+
+		if (otherCount * log2Count < m_NodeCount + otherCount)
+		{
+			for (TNode* node = other.GetMinNode(); node; node = node->GetInorderSuccessor())
+			{
+				if constexpr (TMove)
+				{
+					FindOrEmplace(node->Data, std::move(node->Data));
+				}
+				else
+				{
+					FindOrEmplace(node->Data, node->Data);
+				}
+			}
+			return;
+		}
+
+		if constexpr (THasReserve<TAllocator>::value)
+		{
+			m_Allocator.Reserve(otherCount);
+		}
+
+		// the merged sequence is threaded through Left: successors never read the Left link of an already visited node
+		TNode* head = nullptr;
+		TNode* tail = nullptr;
+		size_t count = 0;
+		const auto append = [&head, &tail, &count](TNode* node)
+		{
+			(tail ? tail->Left : head) = node;
+			tail = node;
+			++count;
+		};
+
+		TNode* a = m_MinNode;
+		TNode* b = other.GetMinNode();
+		while (a || b)
+		{
+			if (!b || (a && m_Compare(a->Data, b->Data)))
+			{
+				TNode* next = a->GetInorderSuccessor();
+				append(a);
+				a = next;
+				continue;
+			}
+
+			if (!a || m_Compare(b->Data, a->Data))
+			{
+				if constexpr (TMove)
+				{
+					append(NewNode(std::move(b->Data)));
+				}
+				else
+				{
+					append(NewNode(b->Data));
+				}
+			}
+			else // equal keys: the element already here stays
+			{
+				TNode* next = a->GetInorderSuccessor();
+				append(a);
+				a = next;
+			}
+			b = b->GetInorderSuccessor();
+		}
+
+		LinkSorted(count, [&head]
+		{
+			TNode* node = head;
+			head = head->Left;
+			return node;
+		});
+	}
+
+	/**
+	 * Restore red black properties after a black node was removed.
+	 * x is the node that took its place (null for an empty leaf), so the parent is passed separately
+	 */
+	FORCEINLINE void FixDoubleBlack(TNode* x, TNode* parent)
 	{
 		// double black is fixed once the node is root or red-black
-		while (x != m_RootNode && !x->IsRed)
+		while (x != m_RootNode && !IsRed(x))
 		{
-			if (x->Parent->IsLeftChild(x)) // if x is left child of its parent
+			if (x == parent->Left) // if x is left child of its parent
 			{
-				TNode* w = x->Parent->Right; // w = x's sibling
+				TNode* w = parent->Right; // w = x's sibling, never null: its subtree has a black node more than x's
 
 				if (w->IsRed) // Case I
 				{
 					w->IsRed = 0;
-					x->Parent->IsRed = 1;
-					RotateLeft(x->Parent); // left rotation of the parent
-					w = x->Parent->Right;
+					parent->IsRed = 1;
+					RotateLeft(parent); // left rotation of the parent
+					w = parent->Right;
 				}
 
-				if (!w->Right->IsRed && !w->Left->IsRed) // if both children of w are black, Case II
+				if (!IsRed(w->Right) && !IsRed(w->Left)) // if both children of w are black, Case II
 				{
 					w->IsRed = 1;
-					x = x->Parent;
-				}
-				else if (!w->Right->IsRed) // if w's right child is black, Case III
-				{
-					w->Left->IsRed = 0;
-					w->IsRed = 1;
-					RotateRight(w);
-					w = x->Parent->Right;
+					x = parent;
+					parent = x->Parent;
 				}
 				else
 				{
+					if (!IsRed(w->Right)) // if w's right child is black, Case III
+					{
+						w->Left->IsRed = 0;
+						w->IsRed = 1;
+						RotateRight(w);
+						w = parent->Right;
+					}
+
 					// Case IV
-					w->IsRed = x->Parent->IsRed;
-					x->Parent->IsRed = 0;
+					w->IsRed = parent->IsRed;
+					parent->IsRed = 0;
 					w->Right->IsRed = 0;
-					RotateLeft(x->Parent);
+					RotateLeft(parent);
 					x = m_RootNode;
 				}
 			}
 			else // if x is right child of its parent
 			{
-				TNode* w = x->Parent->Left; // w = x's sibling
+				TNode* w = parent->Left; // w = x's sibling
 
 				if (w->IsRed) // Case I
 				{
 					w->IsRed = 0;
-					x->Parent->IsRed = 1;
-					RotateRight(x->Parent); // right rotation of the parent
-					w = x->Parent->Left;
+					parent->IsRed = 1;
+					RotateRight(parent); // right rotation of the parent
+					w = parent->Left;
 				}
 
-				if (!w->Right->IsRed && !w->Left->IsRed) // if both children of w are black, Case II
-				{
-					w->IsRed = 1;
-					x = x->Parent;
-				}
-				else if (!w->Left->IsRed) // if w's right child is black, Case III
+				if (!IsRed(w->Right) && !IsRed(w->Left)) // if both children of w are black, Case II
 				{
-					w->Right->IsRed = 0;
 					w->IsRed = 1;
-					RotateLeft(w);
-					w = x->Parent->Left;
+					x = parent;
+					parent = x->Parent;
 				}
 				else
 				{
+					if (!IsRed(w->Left)) // if w's left child is black, Case III
+					{
+						w->Right->IsRed = 0;
+						w->IsRed = 1;
+						RotateLeft(w);
+						w = parent->Left;
+					}
+
 					// Case IV
-					w->IsRed = x->Parent->IsRed;
-					x->Parent->IsRed = 0;
+					w->IsRed = parent->IsRed;
+					parent->IsRed = 0;
 					w->Left->IsRed = 0;
-					RotateRight(x->Parent);
+					RotateRight(parent);
 					x = m_RootNode;
 				}
 			}
 		}
-		x->IsRed = 0;
+
+		if (x)
+		{
+			x->IsRed = 0;
+		}
+	}
+
+	void CopyFrom(const TBinaryTree& other)
+	{
+		const TNode* node = other.m_MinNode;
+		BuildFromSorted(other.m_NodeCount, [&node]() -> const T&
+		{
+			const T& data = node->Data;
+			node = const_cast<TNode*>(node)->GetInorderSuccessor();
+			return data;
+		});
+	}
+
+	FORCEINLINE void StealFrom(TBinaryTree& other)
+	{
+		m_RootNode = other.m_RootNode;
+		m_MinNode = other.m_MinNode;
+		m_MaxNode = other.m_MaxNode;
+		m_NodeCount = other.m_NodeCount;
+		other.m_RootNode = nullptr;
+		other.m_MinNode = nullptr;
+		other.m_MaxNode = nullptr;
+		other.m_NodeCount = 0;
 	}
 
 public:
@@ -470,6 +799,48 @@ public:
 		TNode* InsertedNode;
 	};
 
+	FORCEINLINE TBinaryTree() = default;
+
+	explicit FORCEINLINE TBinaryTree(const TAllocator& allocator) : m_Allocator(allocator)
+	{
+	}
+
+	/**
+	 * Copies own their nodes, linked balanced in O(n) from the elements of `other` in order
+	 */
+	TBinaryTree(const TBinaryTree& other) : m_Compare(other.m_Compare), m_Allocator(other.m_Allocator)
+	{
+		CopyFrom(other);
+	}
+
+	TBinaryTree(TBinaryTree&& other) noexcept
+		: m_Compare(std::move(other.m_Compare)), m_Allocator(std::move(other.m_Allocator))
+	{
+		StealFrom(other);
+	}
+
+	TBinaryTree& operator=(const TBinaryTree& other)
+	{
+		if (this != &other)
+		{
+			m_Compare = other.m_Compare;
+			CopyFrom(other);
+		}
+		return *this;
+	}
+
+	TBinaryTree& operator=(TBinaryTree&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Clear(); // the nodes go back to the allocator that is about to be replaced
+			m_Compare = std::move(other.m_Compare);
+			m_Allocator = std::move(other.m_Allocator);
+			StealFrom(other);
+		}
+		return *this;
+	}
+
 	FORCEINLINE ~TBinaryTree()
 	{
 		Clear();
@@ -477,10 +848,46 @@ public:
 
 	FORCEINLINE void Clear()
 	{
-		// recursion, unfortunately
-		// better that using custom dynamic stack on the heap
 		DeleteTree(m_RootNode);
 		m_RootNode = nullptr;
+		m_MinNode = nullptr;
+		m_MaxNode = nullptr;
+		m_NodeCount = 0;
+	}
+
+	/**
+	 * Replace the contents with `count` elements returned by `nextData()` in strictly ascending order, each a value
+	 * the node data can be constructed from. O(n): the tree is linked perfectly balanced without comparisons or
+	 * rotations, and nodes come from one block when the allocator supports Reserve
+	 */
+	template <typename TNextData>
+	void BuildFromSorted(const size_t count, TNextData&& nextData)
+	{
+		Clear();
+		if constexpr (THasReserve<TAllocator>::value)
+		{
+			m_Allocator.Reserve(count);
+		}
+
+		LinkSorted(count, [this, &nextData] { return NewNode(nextData()); });
+	}
+
+	/**
+	 * Add copies of the elements of `other` whose keys are missing from this tree. O(n + m), or O(m log n) for a
+	 * small `other`
+	 */
+	void Union(const TBinaryTree& other)
+	{
+		UnionInternal<false>(const_cast<TBinaryTree&>(other));
+	}
+
+	/**
+	 * Same as Union but elements are moved out of `other`, which is left empty
+	 */
+	void Merge(TBinaryTree&& other)
+	{
+		UnionInternal<true>(other);
+		other.Clear();
 	}
 
 	FORCEINLINE InsertResult Insert(const T& data)
@@ -495,6 +902,39 @@ public:
 		return {InsertInternal<true>(&m_RootNode, data, insertedNode), insertedNode};
 	}
 
+	/**
+	 * Find the node matching `key` or insert a node whose data is constructed from `args`, which must compare equal
+	 * to `key`. Nothing is constructed when the key is already present. Success is true if a node was inserted
+	 */
+	template <typename U, typename...Args>
+	FORCEINLINE InsertResult FindOrEmplace(const U& key, Args&&...args)
+	{
+		TNode** node = &m_RootNode;
+		TNode* parent = nullptr;
+
+		while (*node)
+		{
+			if (m_Compare(key, (*node)->Data)) // presume <
+			{
+				parent = *node;
+				node = &((*node)->Left);
+			}
+			else if (m_Compare((*node)->Data, key)) // presume >
+			{
+				parent = *node;
+				node = &((*node)->Right);
+			}
+			else
+			{
+				return {false, *node};
+			}
+		}
+
+		TNode* insertedNode = NewNode(std::forward<Args>(args)...);
+		LinkNode(node, parent, insertedNode);
+		return {true, insertedNode};
+	}
+
 	template <typename U>
 	FORCEINLINE TNode* FindNode(const U& data, TNode* node)
 	{
@@ -521,21 +961,81 @@ public:
 		return FindNode(data, m_RootNode);
 	}
 
+	/**
+	 * Returns the first node not less than `data`, or null if every node is less. O(log n)
+	 */
+	template <typename U>
+	FORCEINLINE TNode* LowerBoundNode(const U& data) const
+	{
+		TNode* result = nullptr;
+		TNode* node = m_RootNode;
+		while (node)
+		{
+			if (m_Compare(node->Data, data))
+			{
+				node = node->Right;
+			}
+			else
+			{
+				result = node;
+				node = node->Left;
+			}
+		}
+		return result;
+	}
+
+	/**
+	 * Returns the first node greater than `data`, or null if no node is greater. O(log n)
+	 */
+	template <typename U>
+	FORCEINLINE TNode* UpperBoundNode(const U& data) const
+	{
+		TNode* result = nullptr;
+		TNode* node = m_RootNode;
+		while (node)
+		{
+			if (m_Compare(data, node->Data))
+			{
+				result = node;
+				node = node->Left;
+			}
+			else
+			{
+				node = node->Right;
+			}
+		}
+		return result;
+	}
+
 	FORCEINLINE void DeleteNode(TNode* n)
 	{
 		if (!n)return;
 
+		if (n == m_MinNode)
+		{
+			m_MinNode = n->GetInorderSuccessor();
+		}
+		if (n == m_MaxNode)
+		{
+			m_MaxNode = n->GetInorderPredeccessor();
+		}
+
 		char originalIsRed = n->IsRed;
 		TNode* x;
+		TNode* xParent;
 
 		if (!n->Left)
 		{
 			x = n->Right;
+			xParent = n->Parent;
+			AdjustSubtreeSizes(n->Parent, (size_t)-1);
 			TransplantNode(n, x);
 		}
 		else if (!n->Right)
 		{
 			x = n->Left;
+			xParent = n->Parent;
+			AdjustSubtreeSizes(n->Parent, (size_t)-1);
 			TransplantNode(n, x);
 		}
 		else
@@ -543,13 +1043,15 @@ public:
 			TNode* y = n->Right->GetMinValueNode();
 			originalIsRed = y->IsRed;
 			x = y->Right;
+			AdjustSubtreeSizes(y->Parent, (size_t)-1); // y leaves its position, n's ancestors are included
 
 			if (y->Parent == n)
 			{
-				x->Parent = y;
+				xParent = y;
 			}
 			else
 			{
+				xParent = y->Parent;
 				TransplantNode(y, y->Right);
 				y->Right = n->Right;
 				y->Right->Parent = y;
@@ -559,20 +1061,85 @@ public:
 			y->Left = n->Left;
 			y->Left->Parent = y;
 			y->IsRed = n->IsRed;
+			if constexpr (TNode::kOrderStatistics)
+			{
+				y->SubtreeSize = n->SubtreeSize;
+			}
 		}
 
 		FreeNode(n);
+		--m_NodeCount;
 		if (!originalIsRed) // the node is now double-black which violates the rules
 		{
-			FixDoubleBlack(x);
+			FixDoubleBlack(x, xParent);
 		}
 	}
 
 	FORCEINLINE NODISCARD size_t GetNodeCount() const
 	{
-		return m_RootNode ? m_RootNode->GetChildCount() + 1 : 0;
+		return m_NodeCount;
 	}
 
+	/**
+	 * Returns the node at `index` in ascending order (0 is the smallest), or null if index is out of range.
+	 * O(log n), requires a node type with order statistics
+	 */
+	FORCEINLINE TNode* Select(size_t index)
+	{
+		static_assert(TNode::kOrderStatistics, "Select requires a tree node with order statistics");
+
+		TNode* node = m_RootNode;
+		while (node)
+		{
+			const size_t leftSize = GetSubtreeSize(node->Left);
+			if (index < leftSize)
+			{
+				node = node->Left;
+			}
+			else if (index == leftSize)
+			{
+				return node;
+			}
+			else
+			{
+				index -= leftSize + 1;
+				node = node->Right;
+			}
+		}
+		return nullptr;
+	}
+
+	/**
+	 * Returns the number of nodes less than `data`.
+	 * O(log n), requires a node type with order statistics
+	 */
+	template <typename U>
+	FORCEINLINE size_t Rank(const U& data)
+	{
+		static_assert(TNode::kOrderStatistics, "Rank requires a tree node with order statistics");
+
+		size_t rank = 0;
+		TNode* node = m_RootNode;
+		while (node)
+		{
+			if (m_Compare(data, node->Data)) // presume <
+			{
+				node = node->Left;
+			}
+			else if (m_Compare(node->Data, data)) // presume >
+			{
+				rank += GetSubtreeSize(node->Left) + 1;
+				node = node->Right;
+			}
+			else
+			{
+				return rank + GetSubtreeSize(node->Left);
+			}
+		}
+		return rank;
+	}
+
+
 	FORCEINLINE NODISCARD size_t GetBlackHeight() const
 	{
 		TNode* n = m_RootNode;
@@ -600,8 +1167,29 @@ public:
 		return height;
 	}
 
+	FORCEINLINE TAllocator& GetAllocator()
+	{
+		return m_Allocator;
+	}
+
 	FORCEINLINE NODISCARD TNode* GetRootNode() const
 	{
 		return m_RootNode;
 	}
+
+	/**
+	 * Smallest node or null if the tree is empty. O(1)
+	 */
+	FORCEINLINE NODISCARD TNode* GetMinNode() const
+	{
+		return m_MinNode;
+	}
+
+	/**
+	 * Largest node or null if the tree is empty. O(1)
+	 */
+	FORCEINLINE NODISCARD TNode* GetMaxNode() const
+	{
+		return m_MaxNode;
+	}
 };
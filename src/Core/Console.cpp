@@ -27,6 +27,7 @@
 static bool gConsoleInitialized = false;
 static HANDLE gConsoleOutput;
 static HANDLE gConsoleInput;
+static bool gConsoleHeadless = false;
 
 void FConsole::Initialize()
 {
@@ -48,33 +49,448 @@ void FConsole::Initialize()
 	gConsoleInitialized = true;
 }
 
-void FConsole::Write(const FString& text)
+void FConsole::InitializeHeadless()
 {
+	if(gConsoleInitialized){return;}
+
+	gConsoleOutput = ::GetStdHandle(STD_OUTPUT_HANDLE);
+	if (!gConsoleOutput || gConsoleOutput == INVALID_HANDLE_VALUE)
+	{
+		// not redirected: a windowed process has no standard output of its own, borrow the terminal it was started from
+		::AttachConsole(ATTACH_PARENT_PROCESS);
+		::SetConsoleOutputCP(CP_UTF8);
+		gConsoleOutput = ::CreateFileW(L"CONOUT$", GENERIC_WRITE, FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	}
+
+	gConsoleHeadless = true;
+	gConsoleInitialized = true;
+}
+
+bool FConsole::IsHeadless()
+{
+	return gConsoleHeadless;
+}
+
+static void WriteHeadless(const char* text, const size_t length)
+{
+	DWORD written;
+	::WriteFile(gConsoleOutput, text, (DWORD)length, &written, nullptr);
+}
+
+/**
+ * Convert and write in one console call. Short text is converted on the stack: UTF-16 never needs more code units
+ * than UTF-8 needs bytes
+ */
+static void WriteUtf8(const FStringView text, const bool newline)
+{
+	if (gConsoleHeadless)
+	{
+		char stackBuffer[512];
+		if (text.GetLength() + 2 <= 512)
+		{
+			FMemory::Copy(stackBuffer, text.GetData(), text.GetLength());
+			FMemory::Copy(stackBuffer + text.GetLength(), "\r\n", newline ? 2 : 0);
+			WriteHeadless(stackBuffer, text.GetLength() + (newline ? 2 : 0));
+			return;
+		}
+
+		WriteHeadless(text.GetData(), text.GetLength());
+		if (newline)
+		{
+			WriteHeadless("\r\n", 2);
+		}
+		return;
+	}
+
+	wchar_t stackBuffer[512];
+	if (text.GetLength() + 2 <= 512)
+	{
+		uint count = text.IsEmpty() ? 0 : (uint)::MultiByteToWideChar(CP_UTF8, 0, text.GetData(), (int)text.GetLength(), stackBuffer, 512);
+		if (newline)
+		{
+			stackBuffer[count++] = L'\r';
+			stackBuffer[count++] = L'\n';
+		}
+		::WriteConsoleW(gConsoleOutput, stackBuffer, (DWORD)count, nullptr, nullptr);
+		return;
+	}
+
 	TArray<wchar_t> buffer16;
-	FStringConv::ToUtf16(text.GetData(), buffer16);
-	::WriteConsoleW(gConsoleOutput, buffer16.GetData(), (DWORD)(buffer16.GetCount() - 1), nullptr, nullptr);
+	uint count = FStringConv::ToUtf16(text, buffer16);
+	if (newline)
+	{
+		buffer16[count++] = L'\r'; // replaces the terminator
+		buffer16.Add(L'\n');
+		++count;
+	}
+	::WriteConsoleW(gConsoleOutput, buffer16.GetData(), (DWORD)count, nullptr, nullptr);
+}
+
+constexpr size_t kConsoleRingSize = 64 * 1024;
+
+/**
+ * Text written by one thread in asynchronous mode: a single producer, single consumer byte ring.
+ * Rings are never freed, a thread that exits gives its ring up for the next thread to claim
+ */
+struct SConsoleRing
+{
+	alignas(64) std::atomic<size_t> Head{0}; // consumer
+	alignas(64) std::atomic<size_t> Tail{0}; // producer
+	std::atomic<bool> Owned{true};
+	SConsoleRing* Next = nullptr;
+
+	char Data[kConsoleRingSize];
+};
+
+static struct
+{
+	std::atomic<SConsoleRing*> Rings{nullptr};
+	std::atomic<bool> Async{false};
+	std::atomic<bool> WakeRequested{false};
+
+	std::thread Writer;
+	std::mutex Mutex;
+	std::condition_variable WakeCondition;
+	std::condition_variable FlushedCondition;
+	uint64 FlushRequested = 0;
+	uint64 FlushCompleted = 0;
+	bool Quit = false;
+
+	/**
+	 * Held while rings are drained: serializes the writer thread and crash flushes
+	 */
+	FSpinLock DrainLock;
+	TArray<char> Batch;
+	TArray<wchar_t> Batch16;
+
+	/**
+	 * Reserved by SetAsync for one full ring, so that crash flushes don't allocate
+	 */
+	TArray<char> CrashBatch;
+	TArray<wchar_t> CrashBatch16;
+} gConsoleAsync;
+
+struct SConsoleThreadRing
+{
+	SConsoleRing* Ring = nullptr;
+
+	~SConsoleThreadRing()
+	{
+		if (Ring)
+		{
+			Ring->Owned.store(false, std::memory_order_release);
+		}
+	}
+};
+
+static thread_local SConsoleThreadRing gConsoleThreadRing;
+
+static SConsoleRing& GetThreadRing()
+{
+	if (gConsoleThreadRing.Ring)
+	{
+		return *gConsoleThreadRing.Ring;
+	}
+
+	SConsoleRing* ring = gConsoleAsync.Rings.load(std::memory_order_acquire);
+	for (; ring; ring = ring->Next)
+	{
+		bool owned = false;
+		if (!ring->Owned.load(std::memory_order_relaxed) && ring->Owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+		{
+			break;
+		}
+	}
+
+	if (!ring)
+	{
+		ring = new(FMemory::Alloc(sizeof(SConsoleRing), alignof(SConsoleRing))) SConsoleRing();
+		SConsoleRing* head = gConsoleAsync.Rings.load(std::memory_order_relaxed);
+		do
+		{
+			ring->Next = head;
+		}
+		while (!gConsoleAsync.Rings.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	gConsoleThreadRing.Ring = ring;
+	return *ring;
+}
+
+static void WakeWriter()
+{
+	if (!gConsoleAsync.WakeRequested.exchange(true, std::memory_order_relaxed))
+	{
+		gConsoleAsync.WakeCondition.notify_one();
+	}
+}
+
+static void WriteAsync(const FStringView text, const bool newline)
+{
+	SConsoleRing& ring = GetThreadRing();
+	size_t tail = ring.Tail.load(std::memory_order_relaxed);
+
+	// text that fits the ring is published at once, so that lines of different threads don't mix. Longer text goes
+	// out in pieces as the writer makes room
+	const size_t totalLength = text.GetLength() + (newline ? 2 : 0);
+	while (totalLength <= kConsoleRingSize && kConsoleRingSize - (tail - ring.Head.load(std::memory_order_acquire)) < totalLength)
+	{
+		WakeWriter();
+		std::this_thread::yield();
+	}
+
+	const auto append = [&ring, &tail](const char* data, size_t length)
+	{
+		while (length)
+		{
+			const size_t space = kConsoleRingSize - (tail - ring.Head.load(std::memory_order_acquire));
+			if (!space)
+			{
+				ring.Tail.store(tail, std::memory_order_release);
+				WakeWriter();
+				std::this_thread::yield();
+				continue;
+			}
+
+			const size_t offset = tail % kConsoleRingSize;
+			size_t chunk = length < space ? length : space;
+			chunk = chunk < kConsoleRingSize - offset ? chunk : kConsoleRingSize - offset;
+			FMemory::Copy(ring.Data + offset, data, chunk);
+			tail += chunk;
+			data += chunk;
+			length -= chunk;
+		}
+	};
+
+	append(text.GetData(), text.GetLength());
+	if (newline)
+	{
+		append("\r\n", 2);
+	}
+	ring.Tail.store(tail, std::memory_order_release);
+
+	if (tail - ring.Head.load(std::memory_order_relaxed) > kConsoleRingSize / 2)
+	{
+		WakeWriter();
+	}
+}
+
+/**
+ * Number of bytes at the end of `text` that form an incomplete UTF-8 sequence
+ */
+static size_t GetIncompleteUtf8Tail(const char* text, const size_t length)
+{
+	for (size_t back = 1; back <= 3 && back <= length; ++back)
+	{
+		const uint8 byte = (uint8)text[length - back];
+		if ((byte & 0xC0) != 0x80) // lead byte or ASCII
+		{
+			const size_t sequenceLength = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+			return sequenceLength > back ? back : 0;
+		}
+	}
+	return 0;
+}
+
+static void WriteBatch(const TArray<char>& batch, TArray<wchar_t>& batch16)
+{
+	if (batch.GetCount() && gConsoleHeadless)
+	{
+		WriteHeadless(batch.GetData(), batch.GetCount());
+	}
+	else if (batch.GetCount())
+	{
+		const uint count = FStringConv::ToUtf16(FStringView(batch.GetData(), batch.GetCount()), batch16);
+		::WriteConsoleW(gConsoleOutput, batch16.GetData(), (DWORD)count, nullptr, nullptr);
+	}
+}
+
+/**
+ * Move the text of all rings to `batch` and write it with one console call. Caller holds DrainLock.
+ * With `fixedCapacity` the batches never allocate: the batch is written whenever the next ring does not fit its
+ * reservation, which must hold a full ring
+ */
+static void DrainRings(TArray<char>& batch, TArray<wchar_t>& batch16, const bool fixedCapacity = false)
+{
+	batch.Resize(0);
+	for (SConsoleRing* ring = gConsoleAsync.Rings.load(std::memory_order_acquire); ring; ring = ring->Next)
+	{
+		const size_t head = ring->Head.load(std::memory_order_relaxed);
+		const size_t count = ring->Tail.load(std::memory_order_acquire) - head;
+		if (!count)continue;
+
+		if (fixedCapacity && count > batch.GetReservation())
+		{
+			WriteBatch(batch, batch16);
+			batch.Resize(0);
+		}
+
+		const size_t initialCount = batch.GetCount();
+		batch.Resize(initialCount + count);
+
+		const size_t offset = head % kConsoleRingSize;
+		const size_t firstPart = count < kConsoleRingSize - offset ? count : kConsoleRingSize - offset;
+		FMemory::Copy(batch.GetData() + initialCount, ring->Data + offset, firstPart);
+		FMemory::Copy(batch.GetData() + initialCount + firstPart, ring->Data, count - firstPart);
+
+		// a character cut by a full ring stays there until the producer completes it
+		const size_t incomplete = GetIncompleteUtf8Tail(batch.GetData() + initialCount, count);
+		batch.Resize(initialCount + count - incomplete);
+		ring->Head.store(head + count - incomplete, std::memory_order_release);
+	}
+
+	WriteBatch(batch, batch16);
+}
+
+static void ConsoleWriterMain()
+{
+	std::unique_lock<std::mutex> lock(gConsoleAsync.Mutex);
+	while (true)
+	{
+		gConsoleAsync.WakeCondition.wait_for(lock, std::chrono::milliseconds(10), []
+		{
+			return gConsoleAsync.Quit || gConsoleAsync.FlushRequested != gConsoleAsync.FlushCompleted ||
+				gConsoleAsync.WakeRequested.load(std::memory_order_relaxed);
+		});
+
+		const uint64 flushRequested = gConsoleAsync.FlushRequested;
+		const bool quit = gConsoleAsync.Quit;
+		gConsoleAsync.WakeRequested.store(false, std::memory_order_relaxed);
+		lock.unlock();
+
+		{
+			TScopeLock<FSpinLock> drainLock(gConsoleAsync.DrainLock);
+			DrainRings(gConsoleAsync.Batch, gConsoleAsync.Batch16);
+		}
+
+		lock.lock();
+		gConsoleAsync.FlushCompleted = flushRequested;
+		gConsoleAsync.FlushedCondition.notify_all();
+		if (quit)break;
+	}
+}
+
+static LPTOP_LEVEL_EXCEPTION_FILTER gPreviousExceptionFilter = nullptr;
+
+static LONG WINAPI ConsoleExceptionFilter(EXCEPTION_POINTERS* exceptionInfo)
+{
+	FConsole::FlushOnCrash();
+	return gPreviousExceptionFilter ? gPreviousExceptionFilter(exceptionInfo) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+void FConsole::Write(const FStringView text)
+{
+	if (gConsoleAsync.Async.load(std::memory_order_relaxed))
+	{
+		WriteAsync(text, false);
+		return;
+	}
+
+	WriteUtf8(text, false);
 }
 
 void FConsole::WriteLine()
 {
-	::WriteConsoleA(gConsoleOutput, "\r\n", 2, nullptr, nullptr);
+	WriteLine(FStringView());
 }
 
-void FConsole::WriteLine(const FString& line)
+void FConsole::WriteLine(const FStringView line)
 {
-	Write(line);
-	::WriteConsoleA(gConsoleOutput, "\r\n", 2, nullptr, nullptr);
+	if (gConsoleAsync.Async.load(std::memory_order_relaxed))
+	{
+		WriteAsync(line, true);
+		return;
+	}
+
+	WriteUtf8(line, true);
 }
 
 void FConsole::WaitForKey()
 {
+	Flush();
+	if (gConsoleHeadless)return;
+
 	wchar_t buf1;
 	DWORD buf1count;
 	::ReadConsoleW(gConsoleInput, &buf1, 1, &buf1count, nullptr);
 }
 
+void FConsole::SetAsync(const bool async)
+{
+	if (async == gConsoleAsync.Async.load())return;
+
+	if (async)
+	{
+		gConsoleAsync.CrashBatch.Reserve(kConsoleRingSize);
+		gConsoleAsync.CrashBatch16.Reserve(kConsoleRingSize + 1); // UTF-16 never has more code units than UTF-8 bytes, plus a terminator
+		gConsoleAsync.Quit = false;
+		gConsoleAsync.Writer = std::thread(&ConsoleWriterMain);
+		gConsoleAsync.Async.store(true);
+
+		static bool exitHandlerRegistered = false;
+		if (!exitHandlerRegistered)
+		{
+			exitHandlerRegistered = true;
+			std::atexit([] { FConsole::SetAsync(false); });
+			gPreviousExceptionFilter = ::SetUnhandledExceptionFilter(&ConsoleExceptionFilter);
+		}
+		return;
+	}
+
+	gConsoleAsync.Async.store(false); // new writes go straight to the console, the writer drains what is left
+	{
+		std::lock_guard<std::mutex> lock(gConsoleAsync.Mutex);
+		gConsoleAsync.Quit = true;
+	}
+	gConsoleAsync.WakeCondition.notify_one();
+	gConsoleAsync.Writer.join();
+}
+
+bool FConsole::IsAsync()
+{
+	return gConsoleAsync.Async.load(std::memory_order_relaxed);
+}
+
+void FConsole::Flush()
+{
+	if (!gConsoleAsync.Async.load())return;
+
+	std::unique_lock<std::mutex> lock(gConsoleAsync.Mutex);
+	const uint64 flushId = ++gConsoleAsync.FlushRequested;
+	gConsoleAsync.WakeCondition.notify_one();
+	gConsoleAsync.FlushedCondition.wait(lock, [flushId] { return gConsoleAsync.FlushCompleted >= flushId; });
+}
+
+void FConsole::FlushOnCrash()
+{
+	if (!gConsoleAsync.Async.load())return;
+
+	// give a drain in progress some time to finish. If it doesn't, the rings are drained anyway only when the crash
+	// is on the writer thread itself, which stopped in the middle of its drain: a writer that is merely slow would
+	// make a second consumer of the rings and duplicate or garble the text
+	bool locked = false;
+	for (uint i = 0; i < (1u << 20) && !locked; ++i)
+	{
+		locked = gConsoleAsync.DrainLock.TryLock();
+	}
+	if (!locked && std::this_thread::get_id() != gConsoleAsync.Writer.get_id())
+	{
+		return;
+	}
+
+	DrainRings(gConsoleAsync.CrashBatch, gConsoleAsync.CrashBatch16, true);
+
+	if (locked)
+	{
+		gConsoleAsync.DrainLock.Unlock();
+	}
+}
+
 void FConsole::SetTextColor(const EConsoleTextColor color)
 {
+	Flush();
+	if (gConsoleHeadless)return;
+
 	WORD attr;
 
 	switch(color)
@@ -93,3 +509,36 @@ void FConsole::SetTextColor(const EConsoleTextColor color)
 	
 	::SetConsoleTextAttribute(gConsoleOutput, attr);
 }
+
+UnitTestExclusive(Console_Async)
+{
+	tcheck(GetIncompleteUtf8Tail("abc", 3) == 0);
+	tcheck(GetIncompleteUtf8Tail("a\xE2\x82\xAC", 4) == 0); // complete euro sign
+	tcheck(GetIncompleteUtf8Tail("a\xE2\x82", 3) == 2);
+	tcheck(GetIncompleteUtf8Tail("\xF0\x9F\x98", 3) == 3);
+
+	FConsole::SetAsync(true);
+	tcheck(FConsole::IsAsync());
+
+	std::thread threads[4];
+	for (uint i = 0; i < 4; ++i)
+	{
+		threads[i] = std::thread([i] { FConsole::WriteLine(FFormat::Format("    async line from thread {}", i)); });
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	FConsole::Write("    async line ");
+	FConsole::WriteLine("from the test thread");
+	FConsole::Flush();
+
+	FConsole::WriteLine("    async line written by a crash flush");
+	const uint64 allocCount = FMemory::GetThreadAllocCount();
+	FConsole::FlushOnCrash();
+	tcheck(FMemory::GetThreadAllocCount() == allocCount); // the crash path only uses the reserved batches
+
+	FConsole::SetAsync(false);
+	tcheck(!FConsole::IsAsync());
+}
@@ -38,11 +38,45 @@ struct FConsole
 	 */
 	static void Initialize();
 
-	static void Write(const FString& text);
+	/**
+	 * Write to the standard output instead of a console window, for automated runs whose output is redirected.
+	 * Text is written as UTF-8, colors are ignored and WaitForKey returns right away. Call instead of Initialize
+	 */
+	static void InitializeHeadless();
+	static bool IsHeadless();
+
+	static void Write(FStringView text);
 	static void WriteLine();
-	static void WriteLine(const FString& line);
+	static void WriteLine(FStringView line);
 	
+	/**
+	 * Flushes asynchronous output first
+	 */
 	static void WaitForKey();
 
+	/**
+	 * Flushes asynchronous output first, so that the color applies to text written after the call
+	 */
 	static void SetTextColor(EConsoleTextColor color);
+
+	/**
+	 * In asynchronous mode Write and WriteLine copy the text to a ring buffer owned by the calling thread and return
+	 * without allocating or waiting for I/O. A background thread collects the text of all threads and writes it with
+	 * one console call per batch. The output of one thread keeps its order, different threads interleave at Write
+	 * granularity. Switching back to synchronous mode flushes and stops the background thread.
+	 * Switch modes while no other thread is writing
+	 */
+	static void SetAsync(bool async);
+	static bool IsAsync();
+
+	/**
+	 * Wait until all text written before the call reached the console
+	 */
+	static void Flush();
+
+	/**
+	 * Write out buffered text from the calling thread, without relying on the background thread which may be the one
+	 * that crashed. Used by FatalError, failed asserts and the unhandled exception filter
+	 */
+	static void FlushOnCrash();
 };
\ No newline at end of file
@@ -24,6 +24,13 @@
 
 #pragma once
 
+/**
+ * Tag for the TPair constructor that constructs Second in place from the remaining arguments
+ */
+struct FEmplaceSecond
+{
+};
+
 template<typename TFirst, typename TSecond>
 struct TPair
 {
@@ -36,6 +43,11 @@ struct TPair
 	TPair(const TFirst& first, const TSecond& second) : First(first), Second(second)
 	{
 	}
+
+	template<typename...Args>
+	TPair(FEmplaceSecond, const TFirst& first, Args&&...args) : First(first), Second(std::forward<Args>(args)...)
+	{
+	}
 };
 
 template<typename TFirst, typename TSecond, typename TCompare = FUtils::Less<TFirst>>
@@ -45,18 +57,21 @@ struct TPairFirstCompare
 	
 	TCompare Compare;
 	
-	constexpr bool operator()(const PairType& v1, const PairType& v2)
+	constexpr bool operator()(const PairType& v1, const PairType& v2) const
 	{
 		return Compare(v1.First, v2.First);
 	}
 
-	// overloads that allow TMap to find nodes by key only (without the whole pair)
-	constexpr bool operator()(const TFirst& v1, const PairType& v2)
+	// overloads that allow TMap to find nodes by key only (without the whole pair).
+	// The key may be of another type if TCompare accepts it, see FUtils::Less
+	template<typename U>
+	constexpr bool operator()(const U& v1, const PairType& v2) const
 	{
 		return Compare(v1, v2.First);
 	}
 
-	constexpr bool operator()(const PairType& v1, const TFirst& v2)
+	template<typename U>
+	constexpr bool operator()(const PairType& v1, const U& v2) const
 	{
 		return Compare(v1.First, v2);
 	}
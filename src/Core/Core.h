@@ -28,16 +28,31 @@
 #include "Types.h"
 #include "Utils.h"
 #include "Assert.h"
+#include "Sync.h"
 #include "Memory.h"
+#include "MemArena.h"
 
 #include "Containers.h"
 #include "BinaryTree.h"
 #include "Array.h"
+#include "Algorithms.h"
+#include "RadixSort.h"
 #include "Map.h"
+#include "HashMap.h"
+#include "FlatMap.h"
+#include "BTreeMap.h"
+#include "Queue.h"
+#include "StringView.h"
 #include "String.h"
+#include "Format.h"
+#include "MemoryTracking.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "ParallelAlgorithms.h"
 
 #include "StringConv.h"
 
 #include "Console.h"
 #include "FatalError.h"
 #include "UnitTest.h"
+#include "Benchmark.h"
@@ -25,4 +25,5 @@
 #pragma once
 
 #define FORCEINLINE __forceinline
+#define NOINLINE __declspec(noinline)
 #define NODISCARD [[nodiscard]]
\ No newline at end of file
@@ -24,11 +24,23 @@
 
 #pragma once
 
+/**
+ * Show an error message box and exit. `format` uses FFormat syntax, long messages are truncated
+ */
 template<typename...Args>
-[[noreturn]] void FatalError(const char* format, Args...args)
+[[noreturn]] void FatalError(const FStringView format, const Args&...args)
 {
+	FConsole::FlushOnCrash();
+
 	char buffer[1024];
-	sprintf_s(buffer, format, args...);
+	FFormat::ToBuffer(buffer, sizeof(buffer), format, args...);
+
+	if(FConsole::IsHeadless())
+	{
+		FConsole::WriteLine(FFormat::Format("Fatal error: {}", buffer));
+		FConsole::FlushOnCrash();
+		::ExitProcess(1);
+	}
 
 	wchar_t buffer16[1024];
 	if(FStringConv::ToUtf16(buffer, 1024, buffer16))
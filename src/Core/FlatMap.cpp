@@ -0,0 +1,156 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+UnitTest(FlatMap_Basic)
+{
+	TFlatMap<int, int> map;
+	tcheck(map.GetCount() == 0);
+	tcheck(map.begin() == map.end());
+
+	tcheck(map.Insert(3, 10));
+	map.Insert(21, 10);
+	map.Insert(-5, 10);
+	map.Insert(17, 199);
+	tcheck(!map.Insert(17, 1)); // already present: ignored
+	tcheck(map.GetCount() == 4);
+	tcheck(map[17] == 199);
+	tcheck(*map.Find(21) == 10);
+	tcheck(map.Find(22) == nullptr);
+	tcheck(map.Contains(-5));
+	tcheck(!map.Contains(4));
+
+	map.InsertOrUpdate(3, 42);
+	map.InsertOrUpdate(4, 43);
+	tcheck(map[3] == 42);
+	tcheck(map.GetCount() == 5);
+	tcheck(map.Rank(17) == 3);
+	tcheck(map.Select(0)->First == -5);
+	tcheck(map.Select(5) == nullptr);
+
+	int expected[] = {-5, 3, 4, 17, 21};
+	uint i = 0;
+	for (const TPair<int, int>& pair : map)
+	{
+		tcheck(pair.First == expected[i++]);
+	}
+	tcheck(i == 5);
+
+	for (TPair<int, int>& pair : reverse(map))
+	{
+		tcheck(pair.First == expected[--i]);
+	}
+	tcheck(i == 0);
+
+	map.Remove(4);
+	map.Remove(1000); // not present
+	tcheck(map.GetCount() == 4);
+	tcheck(map[4] == 0); // operator[] inserts a default value
+	tcheck(map.GetCount() == 5);
+
+	map.Clear();
+	tcheck(map.GetCount() == 0);
+}
+
+UnitTest(FlatMap_Build)
+{
+	TArray<TPair<uint, uint>> pairs;
+	TMap<uint, uint> reference;
+
+	uint seed = 777;
+	for (uint i = 0; i < 4000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		const uint key = (seed >> 8) % 1500;
+		pairs.Add(TPair<uint, uint>(key, i));
+		reference.Insert(key, i); // first insertion wins
+	}
+
+	TFlatMap<uint, uint> map;
+	map.Build(pairs.GetData(), pairs.GetCount());
+	tcheck(map.GetCount() == reference.GetCount());
+
+	bool valid = true;
+	TPair<uint, uint>* flatPair = map.begin();
+	for (const TPair<uint, uint>& pair : reference)
+	{
+		valid &= flatPair->First == pair.First && flatPair->Second == pair.Second;
+		++flatPair;
+	}
+	tcheck(valid);
+	tcheck(flatPair == map.end());
+
+	TFlatMap<uint, uint> movedMap;
+	movedMap.Build(std::move(pairs));
+	tcheck(movedMap.GetCount() == reference.GetCount());
+	tcheck(*movedMap.Find(map.Select(10)->First) == map.Select(10)->Second);
+}
+
+UnitTest(FlatMap_ObjectLifetime)
+{
+	struct SKeyCompare
+	{
+		bool operator()(const FString& a, const FString& b) const
+		{
+			return strcmp(a.GetData(), b.GetData()) < 0;
+		}
+	};
+
+	TFlatMap<FString, FString, SKeyCompare> map;
+	map.Insert("b", "a value long enough to live on the heap");
+	map.Insert("a", "short");
+	map.Insert("c", "another value long enough to live on the heap");
+	map.Remove("a");
+	map["a"] = "yet another value long enough to live on the heap";
+
+	tcheck(map.GetCount() == 3);
+	tcheck(strcmp(map.Select(0)->Second.GetData(), "yet another value long enough to live on the heap") == 0);
+	tcheck(strcmp(map.Find("c")->GetData(), "another value long enough to live on the heap") == 0);
+
+	TFlatMap<FString, int> defaultCompareMap;
+	defaultCompareMap.FindOrAdd("b", 2);
+	defaultCompareMap.FindOrAdd("a", 1);
+	tcheck(defaultCompareMap.FindOrAdd("b", 3) == 2);
+	tcheck(defaultCompareMap.Contains("a")); // looked up by const char*
+	tcheck(defaultCompareMap.Select(0)->Second == 1);
+}
+
+Benchmark(FlatMap_Find)
+{
+	constexpr uint kCount = 65536;
+	TArray<TPair<uint, uint>> pairs;
+	for (uint i = 0; i < kCount; ++i)
+	{
+		pairs.Add(TPair<uint, uint>(i * 2654435761u, i));
+	}
+	TFlatMap<uint, uint> map;
+	map.Build(std::move(pairs));
+
+	uint i = 0;
+	bench.Measure("65536", [&map, &i]
+	{
+		FBenchmark::DoNotOptimize(map.Find((i++ % kCount) * 2654435761u));
+	});
+}
@@ -0,0 +1,291 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * A map stored as a sorted array of pairs.
+ * Lookups are a branchless binary search over contiguous memory and iteration is a linear scan, which makes it a better
+ * fit than TMap for read-mostly tables. Insert and Remove shift the tail of the array: O(n), prefer Build for bulk loads
+ */
+template <typename TKey, typename TValue, typename TCompare = FUtils::Less<const TKey>, typename TPair = TPair<TKey, TValue>, typename TAllocator =
+          TRawAllocator<TPair>>
+class TFlatMap
+{
+public:
+	using ArrayType = TArray<TPair, TAllocator>;
+	using AllocatorType = TAllocator;
+
+	class ReverseIterator
+	{
+		friend TFlatMap;
+
+		TPair* m_Pair;
+
+		explicit ReverseIterator(TPair* pair) : m_Pair(pair) {}
+
+	public:
+		void operator++()
+		{
+			--m_Pair;
+		}
+
+		TPair& operator*()
+		{
+			return *(m_Pair - 1);
+		}
+
+		const TPair& operator*() const
+		{
+			return *(m_Pair - 1);
+		}
+
+		bool operator==(const ReverseIterator& other) const
+		{
+			return m_Pair == other.m_Pair;
+		}
+
+		bool operator!=(const ReverseIterator& other) const
+		{
+			return m_Pair != other.m_Pair;
+		}
+	};
+
+private:
+	ArrayType m_Data;
+	TCompare m_Compare;
+
+	/**
+	 * Index of the first pair whose key is not less than `key`
+	 */
+	template <typename U>
+	FORCEINLINE size_t LowerBoundIndex(const U& key) const
+	{
+		const TPair* first = m_Data.GetData();
+		const TPair* pair = FAlgorithms::LowerBound(first, first + m_Data.GetCount(), key,
+		                                            [this](const TPair& p, const U& k) { return m_Compare(p.First, k); });
+		return pair - first;
+	}
+
+	template <typename U>
+	FORCEINLINE bool IsMatch(const size_t index, const U& key) const
+	{
+		return index < m_Data.GetCount() && !m_Compare(key, m_Data[index].First);
+	}
+
+public:
+	FORCEINLINE TFlatMap() = default;
+
+	explicit FORCEINLINE TFlatMap(const TAllocator& allocator) : m_Data(allocator)
+	{
+	}
+
+	/**
+	 * Replace the contents with `count` pairs in any order. O(n log n).
+	 * For duplicate keys the first occurrence wins, same as calling Insert for each pair
+	 */
+	void Build(const TPair* pairs, const size_t count)
+	{
+		m_Data.Clear();
+		m_Data.Reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_Data.Add(pairs[i]);
+		}
+		SortAndRemoveDuplicates();
+	}
+
+	/**
+	 * Replace the contents with `pairs` in any order, reusing its memory
+	 */
+	void Build(ArrayType&& pairs)
+	{
+		m_Data = std::move(pairs);
+		SortAndRemoveDuplicates();
+	}
+
+	FORCEINLINE bool Insert(const TKey& key, const TValue& value)
+	{
+		const size_t index = LowerBoundIndex(key);
+		if (IsMatch(index, key))
+		{
+			return false;
+		}
+
+		m_Data.EmplaceAt(index, key, value);
+		return true;
+	}
+
+	FORCEINLINE void InsertOrUpdate(const TKey& key, const TValue& value)
+	{
+		const size_t index = LowerBoundIndex(key);
+		if (IsMatch(index, key))
+		{
+			m_Data[index].Second = value;
+			return;
+		}
+
+		m_Data.EmplaceAt(index, key, value);
+	}
+
+	template <typename U>
+	FORCEINLINE void Remove(const U& key)
+	{
+		const size_t index = LowerBoundIndex(key);
+		if (IsMatch(index, key))
+		{
+			m_Data.RemoveAt(index);
+		}
+	}
+
+	/**
+	 * Returns the value of `key` or null. `key` may be of any type TCompare can compare with TKey
+	 */
+	template <typename U>
+	FORCEINLINE TValue* Find(const U& key)
+	{
+		const size_t index = LowerBoundIndex(key);
+		return IsMatch(index, key) ? &m_Data[index].Second : nullptr;
+	}
+
+	template <typename U>
+	FORCEINLINE const TValue* Find(const U& key) const
+	{
+		const size_t index = LowerBoundIndex(key);
+		return IsMatch(index, key) ? &m_Data[index].Second : nullptr;
+	}
+
+	template <typename U>
+	FORCEINLINE bool Contains(const U& key) const
+	{
+		return IsMatch(LowerBoundIndex(key), key);
+	}
+
+	FORCEINLINE size_t GetCount() const
+	{
+		return m_Data.GetCount();
+	}
+
+	/**
+	 * Returns the pair at `index` in key order or null if out of range. O(1)
+	 */
+	FORCEINLINE TPair* Select(const size_t index)
+	{
+		return index < m_Data.GetCount() ? &m_Data[index] : nullptr;
+	}
+
+	/**
+	 * Returns the number of keys less than `key`. O(log n)
+	 */
+	template <typename U>
+	FORCEINLINE size_t Rank(const U& key) const
+	{
+		return LowerBoundIndex(key);
+	}
+
+	FORCEINLINE void Reserve(const size_t count)
+	{
+		m_Data.Reserve(count);
+	}
+
+	FORCEINLINE void Clear()
+	{
+		m_Data.Clear();
+	}
+
+	/**
+	 * Returns the value of `key`, inserting one constructed in place from `args` if the key is missing
+	 */
+	template <typename...Args>
+	FORCEINLINE TValue& FindOrAdd(const TKey& key, Args&&...args)
+	{
+		const size_t index = LowerBoundIndex(key);
+		if (!IsMatch(index, key))
+		{
+			m_Data.EmplaceAt(index, FEmplaceSecond(), key, std::forward<Args>(args)...);
+		}
+
+		return m_Data[index].Second;
+	}
+
+	FORCEINLINE TValue& operator[](const TKey& key)
+	{
+		return FindOrAdd(key);
+	}
+
+	FORCEINLINE TPair* begin()
+	{
+		return m_Data.begin();
+	}
+
+	FORCEINLINE TPair* end()
+	{
+		return m_Data.end();
+	}
+
+	FORCEINLINE const TPair* begin() const
+	{
+		return m_Data.begin();
+	}
+
+	FORCEINLINE const TPair* end() const
+	{
+		return m_Data.end();
+	}
+
+	FORCEINLINE ReverseIterator rbegin()
+	{
+		return ReverseIterator(m_Data.end());
+	}
+
+	FORCEINLINE ReverseIterator rend()
+	{
+		return ReverseIterator(m_Data.begin());
+	}
+
+private:
+	void SortAndRemoveDuplicates()
+	{
+		const size_t count = m_Data.GetCount();
+		if (count < 2)return;
+
+		FAlgorithms::StableSort(m_Data.GetData(), m_Data.GetData() + count,
+		                        [this](const TPair& p1, const TPair& p2) { return m_Compare(p1.First, p2.First); });
+
+		size_t last = 0;
+		for (size_t i = 1; i < count; ++i)
+		{
+			if (m_Compare(m_Data[last].First, m_Data[i].First))
+			{
+				++last;
+				if (last != i)
+				{
+					m_Data[last] = std::move(m_Data[i]);
+				}
+			}
+		}
+
+		m_Data.RemoveAt(last + 1, count - last - 1);
+	}
+};
@@ -0,0 +1,453 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+void FFormat::WritePadded(FFormatWriter& writer, const FFormatSpec& spec, const char defaultAlign, const FStringView prefix, const FStringView body)
+{
+	const size_t length = prefix.GetLength() + body.GetLength();
+	const size_t padding = spec.Width > length ? spec.Width - length : 0;
+
+	if (spec.ZeroPad && !spec.Align)
+	{
+		writer.Write(prefix.GetData(), prefix.GetLength());
+		writer.Write('0', padding);
+		writer.Write(body.GetData(), body.GetLength());
+		return;
+	}
+
+	const char align = spec.Align ? spec.Align : defaultAlign;
+	const size_t before = align == '>' ? padding : (align == '^' ? padding / 2 : 0);
+
+	writer.Write(spec.Fill, before);
+	writer.Write(prefix.GetData(), prefix.GetLength());
+	writer.Write(body.GetData(), body.GetLength());
+	writer.Write(spec.Fill, padding - before);
+}
+
+static void FormatInteger(FFormatWriter& writer, const uint64 magnitude, const bool negative, const FFormatSpec& spec)
+{
+	uint base = 10;
+	const char* digits = "0123456789abcdef";
+	const char* radixPrefix = "";
+	switch (spec.Type)
+	{
+	case 'x':
+		base = 16;
+		radixPrefix = "0x";
+		break;
+	case 'X':
+		base = 16;
+		digits = "0123456789ABCDEF";
+		radixPrefix = "0X";
+		break;
+	case 'b':
+		base = 2;
+		radixPrefix = "0b";
+		break;
+	case 'o':
+		base = 8;
+		radixPrefix = "0";
+		break;
+	case 'c':
+	{
+		const char c = (char)magnitude;
+		FFormat::WritePadded(writer, spec, '<', FStringView(), FStringView(&c, 1));
+		return;
+	}
+	default:
+		check(!spec.Type || spec.Type == 'd');
+		break;
+	}
+
+	char buffer[64];
+	char* const end = buffer + sizeof(buffer);
+	char* p = end;
+	uint64 v = magnitude;
+	do
+	{
+		*--p = digits[v % base];
+		v /= base;
+	}
+	while (v);
+
+	char prefix[4];
+	size_t prefixLength = 0;
+	if (negative)
+		prefix[prefixLength++] = '-';
+	else if (spec.ForceSign)
+		prefix[prefixLength++] = '+';
+	if (spec.AlternateForm)
+	{
+		for (const char* r = radixPrefix; *r; ++r)
+			prefix[prefixLength++] = *r;
+	}
+
+	FFormat::WritePadded(writer, spec, '>', FStringView(prefix, prefixLength), FStringView(p, end - p));
+}
+
+static void FormatDouble(FFormatWriter& writer, const double value, const FFormatSpec& spec)
+{
+	char buffer[512]; // large enough for the longest %f of a double (309 digits) plus precision
+	const int precision = spec.Precision < 0 ? -1 : (spec.Precision > 100 ? 100 : spec.Precision);
+	int length;
+
+	switch (spec.Type)
+	{
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+	{
+		const char format[] = {'%', '.', '*', spec.Type, 0};
+		length = snprintf(buffer, sizeof(buffer), format, precision < 0 ? 6 : precision, value);
+		break;
+	}
+	case '%':
+		length = snprintf(buffer, sizeof(buffer), "%.*f%%", precision < 0 ? 6 : precision, value * 100.0);
+		break;
+	default:
+		check(!spec.Type);
+		if (precision >= 0)
+		{
+			length = snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+		}
+		else
+		{
+			// the first of 15, 16 and 17 significant digits that reads back exactly is the shortest representation:
+			// 15 digits covers most values and %g drops trailing zeros, 17 always round-trips
+			for (int digits = 15; digits <= 17; ++digits)
+			{
+				length = snprintf(buffer, sizeof(buffer), "%.*g", digits, value);
+				if (digits == 17 || strtod(buffer, nullptr) == value)break;
+			}
+		}
+		break;
+	}
+
+	if (length < 0)return;
+	if ((size_t)length >= sizeof(buffer))
+		length = sizeof(buffer) - 1;
+
+	const char* body = buffer;
+	char sign[1];
+	size_t signLength = 0;
+	if (*body == '-')
+	{
+		sign[signLength++] = '-';
+		++body;
+		--length;
+	}
+	else if (spec.ForceSign)
+	{
+		sign[signLength++] = '+';
+	}
+
+	FFormat::WritePadded(writer, spec, '>', FStringView(sign, signLength), FStringView(body, length));
+}
+
+static void FormatArg(FFormatWriter& writer, const FFormatArg& arg, const FFormatSpec& spec)
+{
+	switch (arg.Type)
+	{
+	case FFormatArg::EType::Int:
+		FormatInteger(writer, arg.Int < 0 ? 0 - (uint64)arg.Int : (uint64)arg.Int, arg.Int < 0, spec);
+		break;
+	case FFormatArg::EType::UInt:
+		FormatInteger(writer, arg.UInt, false, spec);
+		break;
+	case FFormatArg::EType::Bool:
+		if (spec.Type)
+			FormatInteger(writer, arg.Bool ? 1 : 0, false, spec);
+		else
+			FFormat::WritePadded(writer, spec, '<', FStringView(), arg.Bool ? FStringView("true", 4) : FStringView("false", 5));
+		break;
+	case FFormatArg::EType::Char:
+		if (spec.Type && spec.Type != 'c')
+			FormatInteger(writer, (uint8)arg.Char, false, spec);
+		else
+			FFormat::WritePadded(writer, spec, '<', FStringView(), FStringView(&arg.Char, 1));
+		break;
+	case FFormatArg::EType::Double:
+		FormatDouble(writer, arg.Double, spec);
+		break;
+	case FFormatArg::EType::String:
+	{
+		check(!spec.Type || spec.Type == 's');
+		const size_t length = spec.Precision >= 0 && (size_t)spec.Precision < arg.String.Length ? spec.Precision : arg.String.Length;
+		FFormat::WritePadded(writer, spec, '<', FStringView(), FStringView(arg.String.Data, length));
+		break;
+	}
+	case FFormatArg::EType::Pointer:
+	{
+		FFormatSpec pointerSpec = spec;
+		pointerSpec.Type = 'x';
+		pointerSpec.AlternateForm = true;
+		FormatInteger(writer, (uint64)(size_t)arg.Pointer, false, pointerSpec);
+		break;
+	}
+	case FFormatArg::EType::Custom:
+		arg.Custom.Write(writer, arg.Custom.Value, spec);
+		break;
+	}
+}
+
+/**
+ * Parse a replacement field between the braces. Returns false if it is malformed
+ */
+static bool ParseReplacementField(const char* p, const char* const end, size_t& index, bool& hasIndex, FFormatSpec& spec)
+{
+	hasIndex = false;
+	if (p < end && *p >= '0' && *p <= '9')
+	{
+		hasIndex = true;
+		index = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+			index = index * 10 + (*p++ - '0');
+	}
+
+	if (p == end)return true;
+	if (*p++ != ':')return false;
+
+	const auto isAlign = [](const char c) { return c == '<' || c == '>' || c == '^'; };
+	if (p + 1 < end && isAlign(p[1]))
+	{
+		spec.Fill = p[0];
+		spec.Align = p[1];
+		p += 2;
+	}
+	else if (p < end && isAlign(*p))
+	{
+		spec.Align = *p++;
+	}
+
+	if (p < end && *p == '+')
+	{
+		spec.ForceSign = true;
+		++p;
+	}
+	if (p < end && *p == '#')
+	{
+		spec.AlternateForm = true;
+		++p;
+	}
+	if (p < end && *p == '0')
+	{
+		spec.ZeroPad = true;
+		++p;
+	}
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		spec.Width = spec.Width * 10 + (*p++ - '0');
+	}
+	if (p < end && *p == '.')
+	{
+		++p;
+		spec.Precision = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+			spec.Precision = spec.Precision * 10 + (*p++ - '0');
+	}
+	if (p < end)
+	{
+		spec.Type = *p++;
+	}
+
+	return p == end;
+}
+
+void FFormat::FormatTo(FFormatWriter& writer, const FStringView format, const FFormatArg* args, const size_t argCount)
+{
+	const char* p = format.GetData();
+	const char* const end = p + format.GetLength();
+	size_t nextArg = 0;
+
+	while (p < end)
+	{
+		const char* literalEnd = p;
+		while (literalEnd < end && *literalEnd != '{' && *literalEnd != '}')
+			++literalEnd;
+		writer.Write(p, literalEnd - p);
+		p = literalEnd;
+		if (p == end)break;
+
+		if (p + 1 < end && p[1] == *p) // escaped brace
+		{
+			writer.Write(*p);
+			p += 2;
+			continue;
+		}
+
+		if (*p == '}')
+		{
+			check(!"Unmatched '}' in format string");
+			writer.Write('}');
+			++p;
+			continue;
+		}
+
+		const char* const fieldEnd = (const char*)memchr(p, '}', end - p);
+		size_t index = 0;
+		bool hasIndex;
+		FFormatSpec spec;
+		if (!fieldEnd || !ParseReplacementField(p + 1, fieldEnd, index, hasIndex, spec))
+		{
+			check(!"Malformed replacement field in format string");
+			const char* const verbatimEnd = fieldEnd ? fieldEnd + 1 : end;
+			writer.Write(p, verbatimEnd - p);
+			p = verbatimEnd;
+			continue;
+		}
+
+		if (!hasIndex)
+		{
+			index = nextArg++;
+		}
+
+		if (index >= argCount)
+		{
+			check(!"Format string references a missing argument");
+			writer.Write(p, fieldEnd + 1 - p);
+		}
+		else
+		{
+			FormatArg(writer, args[index], spec);
+		}
+		p = fieldEnd + 1;
+	}
+}
+
+void FFormat::AppendJsonString(FString& out, const FStringView str)
+{
+	out.Append("\"", 1);
+	for (const char* p = str.GetData(); p < str.GetData() + str.GetLength(); ++p)
+	{
+		const char c = *p;
+		if (c == '"' || c == '\\')
+		{
+			const char escaped[2] = {'\\', c};
+			out.Append(escaped, 2);
+		}
+		else if ((uint8)c < 0x20)
+		{
+			Append(out, "\\u{:04x}", (uint)(uint8)c);
+		}
+		else
+		{
+			out.Append(p, 1);
+		}
+	}
+	out.Append("\"", 1);
+}
+
+enum class EFormatTestEnum
+{
+	First,
+	Second
+};
+
+struct SFormatTestPoint
+{
+	int X;
+	int Y;
+};
+
+template <>
+struct TFormatter<SFormatTestPoint>
+{
+	static void Write(FFormatWriter& writer, const SFormatTestPoint& value, const FFormatSpec&)
+	{
+		FFormat::FormatTo(writer, "({}, {})", value.X, value.Y);
+	}
+};
+
+UnitTest(Format_Basic)
+{
+	tcheck(FFormat::Format("plain text") == "plain text");
+	tcheck(FFormat::Format("{} {} {}", 1, -2, 3u) == "1 -2 3");
+	tcheck(FFormat::Format("{1} {0} {1}", "a", "b") == "b a b");
+	tcheck(FFormat::Format("{{}} {{{}}}", 5) == "{} {5}");
+	tcheck(FFormat::Format("{} {}", true, 'c') == "true c");
+	tcheck(FFormat::Format("{}", EFormatTestEnum::Second) == "1");
+	tcheck(FFormat::Format("{}", (int64)-9223372036854775807 - 1) == "-9223372036854775808");
+	tcheck(FFormat::Format("{}", (uint64)18446744073709551615ull) == "18446744073709551615");
+
+	tcheck(FFormat::Format("{:x} {:X} {:#x} {:b} {:o}", 255, 255, 255, 5, 8) == "ff FF 0xff 101 10");
+	tcheck(FFormat::Format("[{:5}] [{:<5}] [{:^5}] [{:*>5}]", 42, 42, 42, 42) == "[   42] [42   ] [ 42  ] [***42]");
+	tcheck(FFormat::Format("[{:05}] [{:+05}] [{:#06x}]", -42, 42, 255) == "[-0042] [+0042] [0x00ff]");
+	tcheck(FFormat::Format("[{:6}] [{:>6}] [{:.3}]", "ab", "ab", "abcdef") == "[ab    ] [    ab] [abc]");
+
+	tcheck(FFormat::Format("{} {} {}", 0.5, 0.1, 1e100) == "0.5 0.1 1e+100");
+	tcheck(FFormat::Format("{:.2f} {:.1e} {:08.3f}", 3.14159, 12345.0, -3.14159) == "3.14 1.2e+04 -003.142");
+	tcheck(FFormat::Format("{:.1%}", 0.256) == "25.6%");
+	tcheck(FFormat::Format("{}", 0.1 + 0.2) == "0.30000000000000004"); // round-trips exactly
+	tcheck(FFormat::Format("{}", 0.1 + 0.7) == "0.7999999999999999"); // 16 digits are enough, 17 would print ...93
+
+	const FString string("a string");
+	const FStringView view = string.SubString(2);
+	tcheck(FFormat::Format("{} | {}", string, view) == "a string | string");
+	tcheck(FFormat::Format("{}", SFormatTestPoint{1, -2}) == "(1, -2)");
+	tcheck(FFormat::Format("{}", (const char*)nullptr) == "(null)");
+	tcheck(FFormat::Format("{}", (void*)0x1234) == "0x1234");
+}
+
+UnitTestExclusive(Format_Destinations)
+{
+	char buffer[8];
+	tcheck(FFormat::ToBuffer(buffer, sizeof(buffer), "{}-{}", 12, 34) == 5);
+	tcheck(strcmp(buffer, "12-34") == 0);
+	tcheck(FFormat::ToBuffer(buffer, sizeof(buffer), "{} and more", 1234567) == 16); // truncated, returns the full length
+	tcheck(strcmp(buffer, "1234567") == 0);
+	tcheck(FFormat::ToBuffer(buffer, 0, "{}", 1) == 1);
+	tcheck(FFormat::GetLength("{:>100}", 1) == 100);
+
+	const size_t initialMemory = FMemory::GetPurposeMemory(EAllocationPurpose::InternalString);
+	{
+		FString message = FFormat::Format("[{}] {}", "test", 42u);
+		tcheck(message == "[test] 42");
+		tcheck(message.IsInline());
+		tcheck(FMemory::GetPurposeMemory(EAllocationPurpose::InternalString) == initialMemory); // short results never allocate
+
+		FString longMessage("prefix:");
+		FFormat::Append(longMessage, "{:>1000}|", "padded"); // several flushes of the stack buffer
+		tcheck(longMessage.GetLength() == 7 + 1000 + 1);
+		tcheck(longMessage.SubString(1001) == "padded|");
+	}
+	tcheck(FMemory::GetPurposeMemory(EAllocationPurpose::InternalString) == initialMemory);
+}
+
+Benchmark(Format_ToBuffer)
+{
+	char buffer[128];
+	uint i = 0;
+	bench.Measure("FFormat", [&buffer, &i]
+	{
+		FBenchmark::DoNotOptimize(FFormat::ToBuffer(buffer, sizeof(buffer), "{} items, {:.2f} ms, {}", i++, 1.5, "done"));
+	});
+	bench.Measure("snprintf", [&buffer, &i]
+	{
+		FBenchmark::DoNotOptimize(snprintf(buffer, sizeof(buffer), "%u items, %.2f ms, %s", i++, 1.5, "done"));
+	});
+}
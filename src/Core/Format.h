@@ -0,0 +1,310 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Parsed replacement field options: {[index][:[[fill]align][+][#][0][width][.precision][type]]}
+ */
+struct FFormatSpec
+{
+	char Fill = ' ';
+	char Align = 0; // '<', '>', '^' or 0 for the type's default
+	char Type = 0;
+	bool ForceSign = false;
+	bool AlternateForm = false; // 0x / 0b / 0 prefixes for integers
+	bool ZeroPad = false;
+	uint Width = 0;
+	int Precision = -1;
+};
+
+/**
+ * Output of the formatter: a window of characters flushed to the actual destination when full.
+ * Without a flush function the overflow is dropped, TotalLength still counts it
+ */
+struct FFormatWriter
+{
+	using FFlushFunction = void(*)(FFormatWriter& writer);
+
+	char* Data = nullptr;
+	size_t Capacity = 0;
+	size_t Length = 0;
+
+	/**
+	 * Number of characters the complete output takes, written or not
+	 */
+	size_t TotalLength = 0;
+
+	void* Context = nullptr;
+	FFlushFunction Flush = nullptr; // must empty the window (set Length to 0)
+
+	FORCEINLINE void Write(const char* str, size_t length)
+	{
+		TotalLength += length;
+		while (length)
+		{
+			if (Length == Capacity)
+			{
+				if (!Flush || !Capacity)return;
+				Flush(*this);
+			}
+
+			const size_t available = Capacity - Length;
+			const size_t count = length < available ? length : available;
+			FMemory::Copy(Data + Length, str, count);
+			Length += count;
+			str += count;
+			length -= count;
+		}
+	}
+
+	FORCEINLINE void Write(const char c, size_t count = 1)
+	{
+		TotalLength += count;
+		while (count)
+		{
+			if (Length == Capacity)
+			{
+				if (!Flush || !Capacity)return;
+				Flush(*this);
+			}
+
+			const size_t available = Capacity - Length;
+			const size_t n = count < available ? count : available;
+			memset(Data + Length, c, n);
+			Length += n;
+			count -= n;
+		}
+	}
+};
+
+/**
+ * Specialize with `static void Write(FFormatWriter& writer, const T& value, const FFormatSpec& spec)` to make T
+ * formattable. Arithmetic types, enums, pointers, raw strings and anything convertible to FStringView are built in
+ */
+template <typename T>
+struct TFormatter;
+
+/**
+ * A type-erased format argument. Arguments are captured by value or by pointer: they must outlive the format call
+ */
+struct FFormatArg
+{
+	enum class EType : uint8
+	{
+		Int,
+		UInt,
+		Bool,
+		Char,
+		Double,
+		String,
+		Pointer,
+		Custom
+	};
+
+	using FCustomWriteFunction = void(*)(FFormatWriter& writer, const void* value, const FFormatSpec& spec);
+
+	struct SString
+	{
+		const char* Data;
+		size_t Length;
+	};
+
+	struct SCustom
+	{
+		const void* Value;
+		FCustomWriteFunction Write;
+	};
+
+	EType Type = EType::Int;
+
+	union
+	{
+		int64 Int = 0;
+		uint64 UInt;
+		bool Bool;
+		char Char;
+		double Double;
+		SString String;
+		const void* Pointer;
+		SCustom Custom;
+	};
+
+	template <typename T>
+	FORCEINLINE static FFormatArg Make(const T& value)
+	{
+		FFormatArg arg;
+		if constexpr (std::is_same<T, bool>::value)
+		{
+			arg.Type = EType::Bool;
+			arg.Bool = value;
+		}
+		else if constexpr (std::is_same<T, char>::value)
+		{
+			arg.Type = EType::Char;
+			arg.Char = value;
+		}
+		else if constexpr (std::is_enum<T>::value)
+		{
+			return Make((typename std::underlying_type<T>::type)value);
+		}
+		else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+		{
+			arg.Type = EType::Int;
+			arg.Int = value;
+		}
+		else if constexpr (std::is_integral<T>::value)
+		{
+			arg.Type = EType::UInt;
+			arg.UInt = value;
+		}
+		else if constexpr (std::is_floating_point<T>::value)
+		{
+			arg.Type = EType::Double;
+			arg.Double = value;
+		}
+		else if constexpr (std::is_array<T>::value && std::is_same<typename std::remove_cv<typename std::remove_extent<T>::type>::type, char>::value)
+		{
+			arg.Type = EType::String;
+			arg.String = {value, strnlen(value, std::extent<T>::value)};
+		}
+		else if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value)
+		{
+			arg.Type = EType::String;
+			arg.String = value ? SString{value, strlen(value)} : SString{"(null)", 6};
+		}
+		else if constexpr (std::is_pointer<T>::value || std::is_null_pointer<T>::value)
+		{
+			arg.Type = EType::Pointer;
+			arg.Pointer = (const void*)value;
+		}
+		else if constexpr (std::is_convertible<const T&, FStringView>::value)
+		{
+			const FStringView view = value;
+			arg.Type = EType::String;
+			arg.String = {view.GetData(), view.GetLength()};
+		}
+		else
+		{
+			arg.Type = EType::Custom;
+			arg.Custom = {&value, [](FFormatWriter& writer, const void* v, const FFormatSpec& spec) { TFormatter<T>::Write(writer, *(const T*)v, spec); }};
+		}
+		return arg;
+	}
+};
+
+/**
+ * Type-safe {}-style formatting:
+ * FFormat::Format("{} of {:>8} ({:.1f}%)", done, total, percent)
+ *
+ * Replacement fields take arguments in order unless an explicit index is given ({0}, {1:x}), "{{" and "}}" are
+ * literal braces. Integer types: d, x, X, b, o, c. Floating point: f, e, g (and upper case), default is the shortest
+ * representation that reads back exactly. Invalid format strings assert in debug builds and are copied verbatim.
+ * Output is bounded by the destination: fixed buffers truncate, strings grow
+ */
+struct FFormat
+{
+	/**
+	 * Format `args` into `writer`. The non-template core of all the helpers below
+	 */
+	static void FormatTo(FFormatWriter& writer, FStringView format, const FFormatArg* args, size_t argCount);
+
+	template <typename...Args>
+	FORCEINLINE static void FormatTo(FFormatWriter& writer, const FStringView format, const Args&...args)
+	{
+		const FFormatArg packedArgs[] = {FFormatArg::Make(args)..., FFormatArg()}; // trailing element allows empty packs
+		FormatTo(writer, format, packedArgs, sizeof...(Args));
+	}
+
+	/**
+	 * Append to `string`. Output goes through a stack buffer, the string grows at most once per 256 characters
+	 */
+	template <typename TAllocator, typename...Args>
+	static TString<TAllocator>& Append(TString<TAllocator>& string, const FStringView format, const Args&...args)
+	{
+		char buffer[256];
+		FFormatWriter writer;
+		writer.Data = buffer;
+		writer.Capacity = sizeof(buffer);
+		writer.Context = &string;
+		writer.Flush = [](FFormatWriter& w)
+		{
+			((TString<TAllocator>*)w.Context)->Append(w.Data, w.Length);
+			w.Length = 0;
+		};
+
+		FormatTo(writer, format, args...);
+		string.Append(buffer, writer.Length);
+		return string;
+	}
+
+	template <typename...Args>
+	FORCEINLINE static FString Format(const FStringView format, const Args&...args)
+	{
+		FString result;
+		Append(result, format, args...);
+		return result;
+	}
+
+	/**
+	 * Format into a caller-provided buffer, always zero terminated unless `bufferSize` is 0.
+	 * Returns the length of the complete output: a result >= bufferSize means the output was truncated
+	 */
+	template <typename...Args>
+	static size_t ToBuffer(char* buffer, const size_t bufferSize, const FStringView format, const Args&...args)
+	{
+		FFormatWriter writer;
+		writer.Data = buffer;
+		writer.Capacity = bufferSize ? bufferSize - 1 : 0;
+
+		FormatTo(writer, format, args...);
+		if (bufferSize)
+		{
+			buffer[writer.Length] = 0;
+		}
+		return writer.TotalLength;
+	}
+
+	/**
+	 * Length of the output without writing it anywhere
+	 */
+	template <typename...Args>
+	FORCEINLINE static size_t GetLength(const FStringView format, const Args&...args)
+	{
+		FFormatWriter writer;
+		FormatTo(writer, format, args...);
+		return writer.TotalLength;
+	}
+
+	/**
+	 * Write `body` with the padding and alignment of `spec`. `prefix` (sign, radix prefix) stays in front of zero padding.
+	 * Helper for TFormatter specializations
+	 */
+	static void WritePadded(FFormatWriter& writer, const FFormatSpec& spec, char defaultAlign, FStringView prefix, FStringView body);
+
+	/**
+	 * Append `str` as a quoted JSON string, escaping quotes, backslashes and control characters
+	 */
+	static void AppendJsonString(FString& out, FStringView str);
+};
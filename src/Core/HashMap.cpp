@@ -0,0 +1,278 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+UnitTest(HashMap_Basic)
+{
+	THashMap<int, int> map;
+	tcheck(map.GetCount() == 0);
+	tcheck(map.begin() == map.end());
+
+	map.Insert(3, 10);
+	map.Insert(21, 10);
+	map.Insert(32, 10);
+	map.Insert(17, 199);
+	map.Insert(7, 10444);
+	map.Insert(7, 1); // already present: ignored
+	tcheck(map.GetCount() == 5);
+	tcheck(map[17] == 199);
+	tcheck(map[7] == 10444);
+	map[7] = 99;
+	tcheck(map[7] == 99);
+
+	map.InsertOrUpdate(3, 42);
+	map.InsertOrUpdate(4, 43);
+	tcheck(map[3] == 42);
+	tcheck(map[4] == 43);
+	tcheck(map.GetCount() == 6);
+
+	int keySum = 0;
+	uint iterated = 0;
+	for (TPair<int, int>& pair : map)
+	{
+		keySum += pair.First;
+		++iterated;
+	}
+	tcheck(iterated == 6);
+	tcheck(keySum == 3 + 4 + 7 + 17 + 21 + 32);
+
+	const THashMap<int, int>& constMap = map;
+	int valueSum = 0;
+	for (const TPair<int, int>& pair : constMap)
+	{
+		valueSum += pair.Second;
+	}
+	tcheck(valueSum == 42 + 43 + 99 + 199 + 10 + 10);
+
+	map.Remove(21);
+	map.Remove(1000); // not present
+	tcheck(map.GetCount() == 5);
+	tcheck(map[21] == 0); // operator[] inserts a default value
+	tcheck(map.GetCount() == 6);
+
+	map.Clear();
+	tcheck(map.GetCount() == 0);
+	tcheck(map.begin() == map.end());
+}
+
+UnitTest(HashMap_Churn)
+{
+	THashMap<uint, uint> map;
+	bool present[4096]{};
+	size_t expectedCount = 0;
+
+	uint seed = 4242;
+	for (uint i = 0; i < 100000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223; // LCG
+		const uint key = (seed >> 8) % 4096;
+		if (present[key])
+		{
+			map.Remove(key);
+			--expectedCount;
+		}
+		else
+		{
+			map.Insert(key, key ^ 0x5555);
+			++expectedCount;
+		}
+		present[key] = !present[key];
+	}
+	tcheck(map.GetCount() == expectedCount);
+	tcheck(map.GetCapacity() <= 8192); // deleted markers don't make the table grow without bound
+
+	size_t iterated = 0;
+	bool valid = true;
+	for (TPair<uint, uint>& pair : map)
+	{
+		valid &= present[pair.First] && pair.Second == (pair.First ^ 0x5555);
+		++iterated;
+	}
+	tcheck(valid);
+	tcheck(iterated == expectedCount);
+
+	THashMap<uint, uint> copy = map;
+	tcheck(copy.GetCount() == expectedCount);
+	bool copyValid = true;
+	for (uint key = 0; key < 4096; ++key)
+	{
+		if (present[key])
+		{
+			copyValid &= copy[key] == (key ^ 0x5555);
+		}
+	}
+	tcheck(copyValid);
+	tcheck(copy.GetCount() == expectedCount); // operator[] didn't insert anything
+
+	THashMap<uint, uint> assigned;
+	assigned.Insert(5000, 1);
+	assigned = map;
+	tcheck(assigned.GetCount() == expectedCount && !assigned.Contains(5000u));
+	assigned.Remove((*map.begin()).First); // the copy owns its slots
+	tcheck(assigned.GetCount() == expectedCount - 1 && map.GetCount() == expectedCount);
+
+	assigned = std::move(copy);
+	tcheck(copy.GetCount() == 0 && copy.begin() == copy.end());
+	bool movedValid = assigned.GetCount() == expectedCount;
+	for (uint key = 0; key < 4096; ++key)
+	{
+		const uint* value = assigned.Find(key);
+		movedValid &= present[key] ? value && *value == (key ^ 0x5555) : !value;
+	}
+	tcheck(movedValid);
+	copy.Insert(1, 1); // moved-from maps stay usable
+	tcheck(copy.GetCount() == 1);
+}
+
+UnitTest(HashMap_ObjectLifetime)
+{
+	static int liveCount = 0;
+
+	struct SLifetimeMock
+	{
+		SLifetimeMock()
+		{
+			++liveCount;
+		}
+
+		SLifetimeMock(const SLifetimeMock&)
+		{
+			++liveCount;
+		}
+
+		SLifetimeMock(SLifetimeMock&&) noexcept
+		{
+			++liveCount;
+		}
+
+		SLifetimeMock& operator=(const SLifetimeMock&) = default;
+
+		~SLifetimeMock()
+		{
+			--liveCount;
+		}
+	};
+
+	{
+		THashMap<int, SLifetimeMock> map;
+		for (int i = 0; i < 1000; ++i)
+		{
+			map[i] = SLifetimeMock();
+		}
+		tcheck(liveCount == 1000); // rehashing moved and destroyed the old slots
+		for (int i = 0; i < 500; ++i)
+		{
+			map.Remove(i);
+		}
+		tcheck(liveCount == 500);
+
+		THashMap<int, SLifetimeMock> moved = std::move(map);
+		tcheck(liveCount == 500);
+		tcheck(moved.GetCount() == 500);
+		tcheck(map.GetCount() == 0);
+
+		map = moved;
+		tcheck(liveCount == 1000);
+		map = std::move(moved);
+		tcheck(liveCount == 500); // the previous contents of `map` were destroyed
+		tcheck(map.GetCount() == 500);
+	}
+	tcheck(liveCount == 0);
+}
+
+UnitTest(HashMap_StringKeys)
+{
+	THashMap<FString, int> map;
+	map.Insert("short", 1);
+	map.Insert("a key that is long enough to live on the heap", 2);
+	map["third"] = 3;
+
+	tcheck(map.GetCount() == 3);
+	tcheck(map["short"] == 1);
+	tcheck(map["a key that is long enough to live on the heap"] == 2);
+	tcheck(map["third"] == 3);
+
+	map.Remove("short");
+	tcheck(map.GetCount() == 2);
+}
+
+UnitTest(HashMap_Find)
+{
+	THashMap<FString, FString> map;
+	map.FindOrAdd("key", "a value that is long enough to live on the heap");
+	map.Insert("another key", "value");
+
+	tcheck(map.Contains("key")); // looked up by const char*, no FString is built
+	tcheck(!map.Contains("missing"));
+	tcheck(map.GetCount() == 2);
+	tcheck(strcmp(map.Find("another key")->GetData(), "value") == 0);
+	tcheck(strcmp(map.FindOrAdd("key", "ignored").GetData(), "a value that is long enough to live on the heap") == 0);
+
+	const THashMap<FString, FString>& constMap = map;
+	tcheck(constMap.Find("key") != nullptr);
+}
+
+Benchmark(HashMap_Insert)
+{
+	bench.Measure("1000", []
+	{
+		THashMap<uint, uint> map;
+		uint seed = 12345;
+		for (uint i = 0; i < 1000; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			map.Insert(seed, i);
+		}
+		FBenchmark::DoNotOptimize(map.GetCount());
+	});
+}
+
+Benchmark(HashMap_Find)
+{
+	constexpr uint kCount = 65536;
+	THashMap<uint, uint> map;
+	for (uint i = 0; i < kCount; ++i)
+	{
+		map.Insert(i * 2654435761u, i);
+	}
+
+	uint i = 0;
+	bench.Measure("65536", [&map, &i]
+	{
+		FBenchmark::DoNotOptimize(map.Find((i++ % kCount) * 2654435761u));
+	});
+
+	THashMap<FString, uint> stringMap;
+	TArray<FString> keys;
+	for (uint k = 0; k < 1024; ++k)
+	{
+		keys.Add(FFormat::Format("key number {}", k));
+		stringMap.Insert(keys[k], k);
+	}
+	bench.Measure("String", [&stringMap, &keys, &i]
+	{
+		FBenchmark::DoNotOptimize(stringMap.Find(keys[i++ % 1024].ToView()));
+	});
+}
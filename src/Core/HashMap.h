@@ -0,0 +1,559 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * A group of 16 control bytes, probed at once with SSE2
+ */
+struct FHashMapGroup
+{
+	static constexpr size_t kWidth = 16;
+
+	/*
+	 * Control byte values: full slots store the 7 low bits of the key hash (0..127), the rest have the top bit set
+	 */
+	static constexpr int8 kEmpty = -128;
+	static constexpr int8 kDeleted = -2;
+
+	__m128i Ctrl;
+
+	explicit FORCEINLINE FHashMapGroup(const int8* ctrl) : Ctrl(_mm_load_si128((const __m128i*)ctrl))
+	{
+	}
+
+	/**
+	 * Bit mask of slots whose control byte is `h2`
+	 */
+	FORCEINLINE uint32 Match(const int8 h2) const
+	{
+		return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), Ctrl));
+	}
+
+	FORCEINLINE uint32 MatchEmpty() const
+	{
+		return Match(kEmpty);
+	}
+
+	FORCEINLINE uint32 MatchEmptyOrDeleted() const
+	{
+		return (uint32)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), Ctrl));
+	}
+};
+
+/**
+ * An unordered map with open addressing in the SwissTable layout: a control byte array probed 16 slots at a time
+ * with SIMD, and a separate slot array of pairs. Lookups touch one or two cache lines instead of a tree path.
+ * Exposes the same interface as TMap, but iteration order is unspecified
+ */
+template <typename TKey, typename TValue, typename THash = FUtils::Hash<TKey>, typename TEq = FUtils::Equal<TKey>,
+          typename TAllocator = TRawAllocator<uint8>>
+class THashMap
+{
+	static_assert(TAllocator::kCanAllocateMany, "THashMap requires an allocator with kCanAllocateMany");
+	static_assert(std::is_same<typename TAllocator::ElementType, uint8>::value, "THashMap allocates raw bytes");
+
+public:
+	using PairType = TPair<TKey, TValue>;
+	using AllocatorType = TAllocator;
+
+private:
+	static constexpr size_t kMinCapacity = FHashMapGroup::kWidth;
+	static constexpr size_t kInvalidIndex = (size_t)-1;
+
+	THash m_Hash{};
+	TEq m_Eq{};
+	TAllocator m_Allocator{};
+
+	/**
+	 * Control bytes followed by the slots, in a single allocation
+	 */
+	int8* m_Ctrl = nullptr;
+	PairType* m_Slots = nullptr;
+
+	/**
+	 * Number of slots, a power of two and a multiple of the group width
+	 */
+	size_t m_Capacity = 0;
+	size_t m_Count = 0;
+
+	/**
+	 * Number of empty slots that can be filled before the map exceeds its maximum load factor
+	 */
+	size_t m_GrowthLeft = 0;
+
+	FORCEINLINE static size_t GetMaxLoad(const size_t capacity)
+	{
+		return capacity - capacity / 8; // 7/8
+	}
+
+	FORCEINLINE static size_t GetSlotsOffset(const size_t capacity)
+	{
+		return (capacity + alignof(PairType) - 1) & ~(alignof(PairType) - 1);
+	}
+
+	FORCEINLINE static constexpr size_t GetAlignment()
+	{
+		return alignof(PairType) > FHashMapGroup::kWidth ? alignof(PairType) : FHashMapGroup::kWidth;
+	}
+
+	FORCEINLINE static int8 GetH2(const size_t hash)
+	{
+		return (int8)(hash & 0x7f);
+	}
+
+	FORCEINLINE bool IsFull(const size_t index) const
+	{
+		return m_Ctrl[index] >= 0;
+	}
+
+	/**
+	 * Returns the slot index of `key` or kInvalidIndex.
+	 * Groups are probed quadratically (triangular numbers), which visits every group when their count is a power of two
+	 */
+	template <typename U>
+	FORCEINLINE size_t FindIndex(const U& key, const size_t hash) const
+	{
+		if (!m_Capacity)
+		{
+			return kInvalidIndex;
+		}
+
+		const size_t mask = m_Capacity - 1;
+		const int8 h2 = GetH2(hash);
+		size_t pos = (hash >> 7) & mask & ~(FHashMapGroup::kWidth - 1);
+
+		for (size_t step = FHashMapGroup::kWidth;; step += FHashMapGroup::kWidth)
+		{
+			const FHashMapGroup group(m_Ctrl + pos);
+			for (uint32 matches = group.Match(h2); matches; matches &= matches - 1)
+			{
+				const size_t index = pos + FUtils::CountTrailingZeros(matches);
+				if (m_Eq(m_Slots[index].First, key))
+				{
+					return index;
+				}
+			}
+
+			if (group.MatchEmpty()) // an empty slot ends the probe sequence
+			{
+				return kInvalidIndex;
+			}
+
+			pos = (pos + step) & mask;
+		}
+	}
+
+	/**
+	 * Returns the first empty or deleted slot in the probe sequence of `hash`
+	 */
+	FORCEINLINE size_t FindInsertIndex(const size_t hash) const
+	{
+		const size_t mask = m_Capacity - 1;
+		size_t pos = (hash >> 7) & mask & ~(FHashMapGroup::kWidth - 1);
+
+		for (size_t step = FHashMapGroup::kWidth;; step += FHashMapGroup::kWidth)
+		{
+			const uint32 matches = FHashMapGroup(m_Ctrl + pos).MatchEmptyOrDeleted();
+			if (matches)
+			{
+				return pos + FUtils::CountTrailingZeros(matches);
+			}
+
+			pos = (pos + step) & mask;
+		}
+	}
+
+	/**
+	 * Move all elements into a new table of `capacity` slots. Also drops deleted markers
+	 */
+	void Rehash(const size_t capacity)
+	{
+		check(capacity >= kMinCapacity && (capacity & (capacity - 1)) == 0);
+
+		int8* oldCtrl = m_Ctrl;
+		PairType* oldSlots = m_Slots;
+		const size_t oldCapacity = m_Capacity;
+
+		m_Ctrl = (int8*)m_Allocator.Alloc(GetSlotsOffset(capacity) + capacity * sizeof(PairType), GetAlignment());
+		m_Slots = (PairType*)(m_Ctrl + GetSlotsOffset(capacity));
+		m_Capacity = capacity;
+		m_GrowthLeft = GetMaxLoad(capacity) - m_Count;
+		memset(m_Ctrl, FHashMapGroup::kEmpty, capacity);
+
+		for (size_t i = 0; i < oldCapacity; ++i)
+		{
+			if (oldCtrl[i] >= 0)
+			{
+				const size_t hash = m_Hash(oldSlots[i].First);
+				const size_t index = FindInsertIndex(hash);
+				m_Ctrl[index] = GetH2(hash);
+
+				if constexpr (TIsTriviallyRelocatable<PairType>::kValue)
+				{
+					FMemory::Copy(m_Slots + index, oldSlots + i, sizeof(PairType));
+				}
+				else
+				{
+					new(m_Slots + index) PairType(std::move(oldSlots[i]));
+					oldSlots[i].~PairType();
+				}
+			}
+		}
+
+		if (oldCtrl)
+		{
+			m_Allocator.Free((uint8*)oldCtrl);
+		}
+	}
+
+	FORCEINLINE static size_t GetCapacityFor(const size_t count)
+	{
+		size_t capacity = kMinCapacity;
+		while (GetMaxLoad(capacity) < count)
+		{
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+	/**
+	 * Claim a slot for a new key, growing the table if needed. The pair is constructed by the caller
+	 */
+	FORCEINLINE size_t PrepareInsert(const size_t hash)
+	{
+		size_t index = m_Capacity ? FindInsertIndex(hash) : kInvalidIndex;
+
+		if (index == kInvalidIndex || (!m_GrowthLeft && m_Ctrl[index] != FHashMapGroup::kDeleted))
+		{
+			if (!m_Capacity)
+			{
+				Rehash(kMinCapacity);
+			}
+			else if (m_Count * 2 < GetMaxLoad(m_Capacity)) // mostly deleted markers: rehashing at the same size is enough
+			{
+				Rehash(m_Capacity);
+			}
+			else
+			{
+				Rehash(m_Capacity * 2);
+			}
+			index = FindInsertIndex(hash);
+		}
+
+		if (m_Ctrl[index] == FHashMapGroup::kEmpty)
+		{
+			--m_GrowthLeft;
+		}
+		m_Ctrl[index] = GetH2(hash);
+		++m_Count;
+		return index;
+	}
+
+	FORCEINLINE void EraseIndex(const size_t index)
+	{
+		m_Slots[index].~PairType();
+		--m_Count;
+
+		// if the group still has an empty slot, no probe sequence ever went past it: the slot can become empty again
+		if (FHashMapGroup(m_Ctrl + (index & ~(FHashMapGroup::kWidth - 1))).MatchEmpty())
+		{
+			m_Ctrl[index] = FHashMapGroup::kEmpty;
+			++m_GrowthLeft;
+		}
+		else
+		{
+			m_Ctrl[index] = FHashMapGroup::kDeleted;
+		}
+	}
+
+	FORCEINLINE void DestroyAll()
+	{
+		if constexpr (!std::is_trivially_destructible<PairType>::value)
+		{
+			for (size_t i = 0; i < m_Capacity; ++i)
+			{
+				if (IsFull(i))
+				{
+					m_Slots[i].~PairType();
+				}
+			}
+		}
+	}
+
+public:
+	class Iterator
+	{
+		friend THashMap;
+
+		const THashMap* m_Map;
+		size_t m_Index;
+
+		FORCEINLINE Iterator(const THashMap* map, const size_t index) : m_Map(map), m_Index(index)
+		{
+			SkipFree();
+		}
+
+		FORCEINLINE void SkipFree()
+		{
+			while (m_Index < m_Map->m_Capacity && !m_Map->IsFull(m_Index))
+			{
+				++m_Index;
+			}
+		}
+
+	public:
+		void operator++()
+		{
+			++m_Index;
+			SkipFree();
+		}
+
+		PairType& operator*()
+		{
+			return m_Map->m_Slots[m_Index];
+		}
+
+		const PairType& operator*() const
+		{
+			return m_Map->m_Slots[m_Index];
+		}
+
+		bool operator==(const Iterator& other) const
+		{
+			return m_Index == other.m_Index;
+		}
+
+		bool operator!=(const Iterator& other) const
+		{
+			return m_Index != other.m_Index;
+		}
+	};
+
+	FORCEINLINE THashMap() = default;
+
+	explicit FORCEINLINE THashMap(const TAllocator& allocator) : m_Allocator(allocator)
+	{
+	}
+
+	FORCEINLINE THashMap(const THashMap& other) : m_Hash(other.m_Hash), m_Eq(other.m_Eq), m_Allocator(other.m_Allocator)
+	{
+		Reserve(other.m_Count);
+		for (size_t i = 0; i < other.m_Capacity; ++i)
+		{
+			if (other.IsFull(i))
+			{
+				const size_t index = PrepareInsert(m_Hash(other.m_Slots[i].First));
+				new(m_Slots + index) PairType(other.m_Slots[i]);
+			}
+		}
+	}
+
+	FORCEINLINE THashMap(THashMap&& other) noexcept : m_Hash(std::move(other.m_Hash)), m_Eq(std::move(other.m_Eq)),
+	                                                   m_Allocator(std::move(other.m_Allocator)),
+	                                                   m_Ctrl(other.m_Ctrl), m_Slots(other.m_Slots),
+	                                                   m_Capacity(other.m_Capacity), m_Count(other.m_Count),
+	                                                   m_GrowthLeft(other.m_GrowthLeft)
+	{
+		other.m_Ctrl = nullptr;
+		other.m_Slots = nullptr;
+		other.m_Capacity = 0;
+		other.m_Count = 0;
+		other.m_GrowthLeft = 0;
+	}
+
+	THashMap& operator=(const THashMap& other)
+	{
+		if (this != &other)
+		{
+			THashMap copy(other);
+			Swap(copy);
+		}
+		return *this;
+	}
+
+	/**
+	 * The old contents are destroyed by the temporary they are swapped into, with the allocator that made them
+	 */
+	THashMap& operator=(THashMap&& other) noexcept
+	{
+		if (this != &other)
+		{
+			THashMap moved(std::move(other));
+			Swap(moved);
+		}
+		return *this;
+	}
+
+	FORCEINLINE void Swap(THashMap& other) noexcept
+	{
+		FUtils::Swap(m_Hash, other.m_Hash);
+		FUtils::Swap(m_Eq, other.m_Eq);
+		FUtils::Swap(m_Allocator, other.m_Allocator);
+		FUtils::Swap(m_Ctrl, other.m_Ctrl);
+		FUtils::Swap(m_Slots, other.m_Slots);
+		FUtils::Swap(m_Capacity, other.m_Capacity);
+		FUtils::Swap(m_Count, other.m_Count);
+		FUtils::Swap(m_GrowthLeft, other.m_GrowthLeft);
+	}
+
+	FORCEINLINE ~THashMap()
+	{
+		DestroyAll();
+		if (m_Ctrl)
+		{
+			m_Allocator.Free((uint8*)m_Ctrl);
+		}
+	}
+
+	/**
+	 * Make room for `count` elements without rehashing
+	 */
+	FORCEINLINE void Reserve(const size_t count)
+	{
+		if (count > GetMaxLoad(m_Capacity))
+		{
+			Rehash(GetCapacityFor(count));
+		}
+	}
+
+	FORCEINLINE void Insert(const TKey& key, const TValue& value)
+	{
+		const size_t hash = m_Hash(key);
+		if (FindIndex(key, hash) == kInvalidIndex)
+		{
+			const size_t index = PrepareInsert(hash); // may rehash: must run before m_Slots is read
+			new(m_Slots + index) PairType(key, value);
+		}
+	}
+
+	FORCEINLINE void InsertOrUpdate(const TKey& key, const TValue& value)
+	{
+		const size_t hash = m_Hash(key);
+		const size_t index = FindIndex(key, hash);
+		if (index != kInvalidIndex)
+		{
+			m_Slots[index].Second = value;
+		}
+		else
+		{
+			const size_t insertIndex = PrepareInsert(hash);
+			new(m_Slots + insertIndex) PairType(key, value);
+		}
+	}
+
+	/**
+	 * Returns the value of `key` or null. Never allocates.
+	 * `key` may be of any type THash and TEq accept, e.g. const char* for FString keys
+	 */
+	template <typename U>
+	FORCEINLINE TValue* Find(const U& key)
+	{
+		const size_t index = FindIndex(key, m_Hash(key));
+		return index != kInvalidIndex ? &m_Slots[index].Second : nullptr;
+	}
+
+	template <typename U>
+	FORCEINLINE const TValue* Find(const U& key) const
+	{
+		return const_cast<THashMap*>(this)->Find(key);
+	}
+
+	template <typename U>
+	FORCEINLINE bool Contains(const U& key) const
+	{
+		return Find(key) != nullptr;
+	}
+
+	/**
+	 * Returns the value of `key`, inserting one constructed in place from `args` if the key is missing
+	 */
+	template <typename...Args>
+	FORCEINLINE TValue& FindOrAdd(const TKey& key, Args&&...args)
+	{
+		const size_t hash = m_Hash(key);
+		size_t index = FindIndex(key, hash);
+		if (index == kInvalidIndex)
+		{
+			index = PrepareInsert(hash);
+			new(m_Slots + index) PairType(FEmplaceSecond(), key, std::forward<Args>(args)...);
+		}
+
+		return m_Slots[index].Second;
+	}
+
+	template <typename U>
+	FORCEINLINE void Remove(const U& key)
+	{
+		const size_t index = FindIndex(key, m_Hash(key));
+		if (index != kInvalidIndex)
+		{
+			EraseIndex(index);
+		}
+	}
+
+	FORCEINLINE TValue& operator[](const TKey& key)
+	{
+		return FindOrAdd(key);
+	}
+
+	FORCEINLINE size_t GetCount() const
+	{
+		return m_Count;
+	}
+
+	FORCEINLINE size_t GetCapacity() const
+	{
+		return m_Capacity;
+	}
+
+	/**
+	 * Destroy all elements, the memory is kept
+	 */
+	FORCEINLINE void Clear()
+	{
+		DestroyAll();
+		if (m_Ctrl)
+		{
+			memset(m_Ctrl, FHashMapGroup::kEmpty, m_Capacity);
+		}
+		m_Count = 0;
+		m_GrowthLeft = GetMaxLoad(m_Capacity);
+	}
+
+	FORCEINLINE TAllocator& GetAllocator()
+	{
+		return m_Allocator;
+	}
+
+	FORCEINLINE Iterator begin() const
+	{
+		return Iterator(this, 0);
+	}
+
+	FORCEINLINE Iterator end() const
+	{
+		return Iterator(this, m_Capacity);
+	}
+};
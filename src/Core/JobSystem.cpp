@@ -0,0 +1,404 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+struct alignas(64) SJobWorker
+{
+	FJobDeque Deque;
+
+	/**
+	 * Job records created by this worker, reused round robin
+	 */
+	SJob* Jobs;
+	uint64 NextJob = 0;
+
+	uint64 RandomState;
+	std::thread Thread;
+};
+
+static struct
+{
+	SJobWorker* Workers = nullptr;
+	uint WorkerCount = 0;
+
+	std::atomic<bool> Quit{false};
+
+	/**
+	 * Jobs pushed and not taken yet, lets idle workers sleep
+	 */
+	std::atomic<int64> QueuedCount{0};
+	std::atomic<uint> SleepingCount{0};
+	std::mutex SleepMutex;
+	std::condition_variable SleepCondition;
+} gJobSystem;
+
+static thread_local int gCurrentWorkerIndex = -1;
+
+/**
+ * Take a job from the own deque or steal one from another worker, starting at a random victim
+ */
+static SJob* GetJob(SJobWorker& worker)
+{
+	SJob* job = worker.Deque.Pop();
+	if (!job)
+	{
+		uint64& x = worker.RandomState; // xorshift64
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+
+		const uint count = gJobSystem.WorkerCount;
+		const uint start = (uint)(x % count);
+		for (uint i = 0; i < count && !job; ++i)
+		{
+			SJobWorker& victim = gJobSystem.Workers[(start + i) % count];
+			if (&victim != &worker)
+			{
+				job = victim.Deque.Steal();
+			}
+		}
+	}
+
+	if (job)
+	{
+		gJobSystem.QueuedCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+void FJobSystem::WorkerMain(const uint index)
+{
+	gCurrentWorkerIndex = (int)index;
+	SJobWorker& worker = gJobSystem.Workers[index];
+
+	char name[32];
+	FFormat::ToBuffer(name, sizeof(name), "Job worker {}", index);
+	FProfiler::SetThreadName(name);
+
+	uint idleSpins = 0;
+	while (!gJobSystem.Quit.load(std::memory_order_relaxed))
+	{
+		if (SJob* job = GetJob(worker))
+		{
+			ExecuteJob(job);
+			idleSpins = 0;
+			continue;
+		}
+
+		if (++idleSpins < 256)
+		{
+			_mm_pause();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(gJobSystem.SleepMutex);
+		gJobSystem.SleepingCount.fetch_add(1, std::memory_order_seq_cst);
+		gJobSystem.SleepCondition.wait_for(lock, std::chrono::milliseconds(1), []
+		{
+			return gJobSystem.QueuedCount.load(std::memory_order_seq_cst) > 0 || gJobSystem.Quit.load(std::memory_order_relaxed);
+		});
+		gJobSystem.SleepingCount.fetch_sub(1, std::memory_order_relaxed);
+		idleSpins = 0;
+	}
+
+	gCurrentWorkerIndex = -1;
+}
+
+void FJobSystem::Initialize(uint workerCount)
+{
+	check(!gJobSystem.Workers);
+
+	if (!workerCount)
+	{
+		workerCount = std::thread::hardware_concurrency();
+	}
+	workerCount = workerCount < 1 ? 1 : (workerCount > kMaxWorkers ? kMaxWorkers : workerCount);
+
+	gJobSystem.Quit.store(false);
+	gJobSystem.QueuedCount.store(0);
+	gJobSystem.WorkerCount = workerCount;
+	gJobSystem.Workers = (SJobWorker*)FMemory::Alloc(sizeof(SJobWorker) * workerCount, alignof(SJobWorker));
+
+	for (uint i = 0; i < workerCount; ++i)
+	{
+		SJobWorker* worker = new(gJobSystem.Workers + i) SJobWorker();
+		worker->Jobs = (SJob*)FMemory::Alloc(sizeof(SJob) * kJobRingSize, alignof(SJob));
+		for (uint j = 0; j < kJobRingSize; ++j)
+		{
+			new(worker->Jobs + j) SJob();
+			worker->Jobs[j].Pending.store(false, std::memory_order_relaxed);
+		}
+		worker->RandomState = 0x9E3779B97F4A7C15ull * (i + 1);
+	}
+
+	gCurrentWorkerIndex = 0;
+	for (uint i = 1; i < workerCount; ++i)
+	{
+		gJobSystem.Workers[i].Thread = std::thread(&FJobSystem::WorkerMain, i);
+	}
+}
+
+void FJobSystem::Shutdown()
+{
+	if (!gJobSystem.Workers)return;
+
+	{
+		std::lock_guard<std::mutex> lock(gJobSystem.SleepMutex);
+		gJobSystem.Quit.store(true);
+	}
+	gJobSystem.SleepCondition.notify_all();
+
+	for (uint i = 0; i < gJobSystem.WorkerCount; ++i)
+	{
+		SJobWorker& worker = gJobSystem.Workers[i];
+		if (worker.Thread.joinable())
+		{
+			worker.Thread.join();
+		}
+		FMemory::Free(worker.Jobs);
+		worker.~SJobWorker();
+	}
+
+	FMemory::Free(gJobSystem.Workers);
+	gJobSystem.Workers = nullptr;
+	gJobSystem.WorkerCount = 0;
+	gCurrentWorkerIndex = -1;
+}
+
+bool FJobSystem::IsInitialized()
+{
+	return gJobSystem.Workers != nullptr;
+}
+
+uint FJobSystem::GetWorkerCount()
+{
+	return gJobSystem.WorkerCount ? gJobSystem.WorkerCount : 1;
+}
+
+int FJobSystem::GetCurrentWorkerIndex()
+{
+	return gCurrentWorkerIndex;
+}
+
+void FJobSystem::ExecuteJob(SJob* job)
+{
+	job->Function(*job);
+
+	FJobCounter* counter = job->Counter; // the counter may go away as soon as it reaches zero
+	job->Pending.store(false, std::memory_order_release);
+	if (counter)
+	{
+		counter->m_Value.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+SJob* FJobSystem::AllocateJob()
+{
+	if (gCurrentWorkerIndex < 0)
+	{
+		return nullptr;
+	}
+
+	// busy records are skipped rather than waited for: the job holding one may be running further up this very stack
+	SJobWorker& worker = gJobSystem.Workers[gCurrentWorkerIndex];
+	for (uint attempt = 0; attempt < kJobRingSize; ++attempt)
+	{
+		SJob* job = &worker.Jobs[worker.NextJob++ % kJobRingSize];
+		if (!job->Pending.load(std::memory_order_acquire))
+		{
+			job->Pending.store(true, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	return nullptr; // every record is in flight: the caller runs the job inline
+}
+
+void FJobSystem::Submit(SJob* job, FJobCounter* counter)
+{
+	job->Counter = counter;
+	if (counter)
+	{
+		counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	SJobWorker& worker = gJobSystem.Workers[gCurrentWorkerIndex];
+	if (!worker.Deque.Push(job))
+	{
+		ExecuteJob(job); // deque full: run inline rather than block
+		return;
+	}
+
+	gJobSystem.QueuedCount.fetch_add(1, std::memory_order_seq_cst);
+	if (gJobSystem.SleepingCount.load(std::memory_order_seq_cst))
+	{
+		gJobSystem.SleepCondition.notify_one();
+	}
+}
+
+void FJobSystem::Wait(const FJobCounter& counter)
+{
+	if (gCurrentWorkerIndex < 0)
+	{
+		while (!counter.IsDone())
+		{
+			std::this_thread::yield();
+		}
+		return;
+	}
+
+	SJobWorker& worker = gJobSystem.Workers[gCurrentWorkerIndex];
+	while (!counter.IsDone())
+	{
+		if (SJob* job = GetJob(worker))
+		{
+			ExecuteJob(job);
+		}
+		else
+		{
+			_mm_pause();
+		}
+	}
+}
+
+UnitTestExclusive(JobSystem_Basic)
+{
+	FJobSystem::Initialize(4);
+	tcheck(FJobSystem::GetWorkerCount() == 4);
+	tcheck(FJobSystem::GetCurrentWorkerIndex() == 0);
+
+	std::atomic<uint> executed{0};
+	FJobCounter counter;
+	for (uint i = 0; i < 20000; ++i) // more than fits the job ring and the deque
+	{
+		FJobSystem::Run([&executed] { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+	}
+	FJobSystem::Wait(counter);
+	tcheck(counter.IsDone());
+	tcheck(executed.load() == 20000);
+
+	// nested jobs that wait on their own children
+	std::atomic<uint> leaves{0};
+	FJobCounter parents;
+	for (uint i = 0; i < 64; ++i)
+	{
+		FJobSystem::Run([&leaves]
+		{
+			FJobCounter children;
+			for (uint j = 0; j < 64; ++j)
+			{
+				FJobSystem::Run([&leaves] { leaves.fetch_add(1, std::memory_order_relaxed); }, &children);
+			}
+			FJobSystem::Wait(children);
+		}, &parents);
+	}
+	FJobSystem::Wait(parents);
+	tcheck(leaves.load() == 64 * 64);
+
+	FJobSystem::Shutdown();
+	tcheck(!FJobSystem::IsInitialized());
+}
+
+UnitTestExclusive(JobSystem_ParallelFor)
+{
+	FJobSystem::Initialize(4);
+
+	TArray<uint> values;
+	values.Resize(100000);
+	FJobSystem::ParallelFor(values.GetCount(), 0, [&values](const size_t begin, const size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			values[i] = (uint)i * 2;
+		}
+	});
+
+	bool valid = true;
+	for (size_t i = 0; i < values.GetCount(); ++i)
+	{
+		valid &= values[i] == i * 2;
+	}
+	tcheck(valid);
+
+	std::atomic<uint64> sum{0};
+	FJobSystem::ParallelFor(1000, 7, [&sum](const size_t begin, const size_t end)
+	{
+		uint64 local = 0;
+		for (size_t i = begin; i < end; ++i)
+		{
+			local += i;
+		}
+		sum.fetch_add(local, std::memory_order_relaxed);
+	});
+	tcheck(sum.load() == 999 * 1000 / 2);
+
+	FJobSystem::Shutdown();
+}
+
+Benchmark(JobSystem_ParallelFor)
+{
+	TArray<uint> values;
+	values.Resize(1 << 20, 1);
+
+	const uint maxWorkers = std::thread::hardware_concurrency() < FJobSystem::kMaxWorkers ? std::thread::hardware_concurrency() : FJobSystem::kMaxWorkers;
+	for (uint workerCount = 1; workerCount <= maxWorkers; ++workerCount)
+	{
+		FJobSystem::Initialize(workerCount);
+
+		char variant[16];
+		FFormat::ToBuffer(variant, sizeof(variant), "{}", workerCount);
+		bench.Measure(variant, [&values]
+		{
+			std::atomic<uint64> sum{0};
+			FJobSystem::ParallelFor(values.GetCount(), 0, [&values, &sum](const size_t begin, const size_t end)
+			{
+				uint64 local = 0;
+				for (size_t i = begin; i < end; ++i)
+				{
+					local += values[i] * values[i];
+				}
+				sum.fetch_add(local, std::memory_order_relaxed);
+			});
+			FBenchmark::DoNotOptimize(sum);
+		});
+
+		// cost of one fine-grained job: allocation from the ring, push, pop or steal, run and counter update.
+		// The batch stays below kJobRingSize so no job falls back to running inline
+		constexpr uint kJobCount = 1024;
+		FFormat::ToBuffer(variant, sizeof(variant), "Job/{}", workerCount);
+		bench.Measure(variant, []
+		{
+			FJobCounter counter;
+			for (uint i = 0; i < kJobCount; ++i)
+			{
+				FJobSystem::Run([] {}, &counter);
+			}
+			FJobSystem::Wait(counter);
+		});
+		bench.SetItemsPerIteration(kJobCount);
+
+		FJobSystem::Shutdown();
+	}
+}
@@ -0,0 +1,243 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * A fixed size job record. The callable is stored inline, records come from a per-thread ring: creating a job never
+ * allocates
+ */
+struct alignas(64) SJob
+{
+	static constexpr size_t kDataSize = 48;
+
+	void(*Function)(SJob& job);
+	class FJobCounter* Counter;
+	std::atomic<bool> Pending;
+
+	alignas(16) uint8 Data[kDataSize];
+};
+
+/**
+ * Number of unfinished jobs in a group. Jobs submitted with a counter increment it and decrement it when done,
+ * FJobSystem::Wait runs other jobs until it drops to zero
+ */
+class FJobCounter
+{
+	friend struct FJobSystem;
+
+	std::atomic<uint> m_Value{0};
+
+public:
+	FORCEINLINE bool IsDone() const
+	{
+		return m_Value.load(std::memory_order_acquire) == 0;
+	}
+};
+
+/**
+ * Chase-Lev work stealing deque of bounded capacity (Le et al., "Correct and Efficient Work-Stealing for Weak Memory
+ * Models"). The owning worker pushes and pops at the bottom, other workers steal from the top
+ */
+class FJobDeque
+{
+public:
+	static constexpr int64 kCapacity = 4096;
+
+private:
+	alignas(64) std::atomic<int64> m_Top{0};
+	alignas(64) std::atomic<int64> m_Bottom{0};
+	alignas(64) std::atomic<SJob*> m_Jobs[kCapacity]{};
+
+public:
+	/**
+	 * Owner only. Returns false if the deque is full
+	 */
+	FORCEINLINE bool Push(SJob* job)
+	{
+		const int64 bottom = m_Bottom.load(std::memory_order_relaxed);
+		const int64 top = m_Top.load(std::memory_order_acquire);
+		if (bottom - top >= kCapacity)
+		{
+			return false;
+		}
+
+		m_Jobs[bottom & (kCapacity - 1)].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * Owner only. Newest job first
+	 */
+	FORCEINLINE SJob* Pop()
+	{
+		const int64 bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		m_Bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64 top = m_Top.load(std::memory_order_relaxed);
+
+		if (top > bottom) // empty
+		{
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		SJob* job = m_Jobs[bottom & (kCapacity - 1)].load(std::memory_order_relaxed);
+		if (top == bottom) // last job: race against thieves
+		{
+			if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	/**
+	 * Any thread. Oldest job first, null if empty or if another thread won the race
+	 */
+	FORCEINLINE SJob* Steal()
+	{
+		int64 top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64 bottom = m_Bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+		{
+			return nullptr;
+		}
+
+		SJob* job = m_Jobs[top & (kCapacity - 1)].load(std::memory_order_relaxed);
+		if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return job;
+	}
+};
+
+/**
+ * Work stealing job scheduler. The thread calling Initialize becomes worker 0 and participates while it waits,
+ * the other workers are dedicated threads. Jobs may be submitted from any worker, including from inside jobs;
+ * threads that are not workers run submitted jobs inline, as do workers whose job ring or deque is full
+ */
+struct FJobSystem
+{
+	static constexpr uint kMaxWorkers = 64;
+
+	/**
+	 * Number of jobs a worker can have in flight, further jobs run inline
+	 */
+	static constexpr uint kJobRingSize = 4096;
+
+	/**
+	 * `workerCount` includes the calling thread, 0 uses one worker per hardware thread
+	 */
+	static void Initialize(uint workerCount = 0);
+
+	/**
+	 * Stops and joins the worker threads. Submitted jobs must have been waited for
+	 */
+	static void Shutdown();
+
+	static bool IsInitialized();
+	static uint GetWorkerCount();
+
+	/**
+	 * Index of the calling worker or -1 if the thread is not a worker
+	 */
+	static int GetCurrentWorkerIndex();
+
+	/**
+	 * Schedule `function` (any callable of up to SJob::kDataSize bytes). `counter` tracks its completion
+	 */
+	template <typename F>
+	static void Run(F&& function, FJobCounter* counter = nullptr)
+	{
+		using TFunction = typename std::decay<F>::type;
+		static_assert(sizeof(TFunction) <= SJob::kDataSize, "Job callable is too big, capture pointers instead of values");
+		static_assert(alignof(TFunction) <= 16, "Job callable is overaligned");
+
+		SJob* job = AllocateJob();
+		if (!job)
+		{
+			function();
+			return;
+		}
+
+		new(job->Data) TFunction(std::forward<F>(function));
+		job->Function = [](SJob& j)
+		{
+			TFunction& f = *(TFunction*)j.Data;
+			f();
+			f.~TFunction();
+		};
+		Submit(job, counter);
+	}
+
+	/**
+	 * Run jobs until `counter` reaches zero
+	 */
+	static void Wait(const FJobCounter& counter);
+
+	/**
+	 * Call `body(begin, end)` for consecutive ranges covering [0, count) in parallel and wait for all of them.
+	 * `batchSize` 0 picks a size that gives every worker a few ranges
+	 */
+	template <typename F>
+	static void ParallelFor(const size_t count, size_t batchSize, const F& body)
+	{
+		if (!count)return;
+
+		if (!batchSize)
+		{
+			const size_t batches = (size_t)GetWorkerCount() * 4;
+			batchSize = count > batches ? (count + batches - 1) / batches : 1;
+		}
+
+		if (batchSize >= count)
+		{
+			body((size_t)0, count);
+			return;
+		}
+
+		FJobCounter counter;
+		for (size_t begin = batchSize; begin < count; begin += batchSize)
+		{
+			const size_t end = count - begin > batchSize ? begin + batchSize : count;
+			Run([&body, begin, end] { body(begin, end); }, &counter);
+		}
+		body((size_t)0, batchSize); // the first range on the calling thread
+		Wait(counter);
+	}
+
+private:
+	static SJob* AllocateJob();
+	static void Submit(SJob* job, FJobCounter* counter);
+	static void ExecuteJob(SJob* job);
+	static void WorkerMain(uint index);
+};
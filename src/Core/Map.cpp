@@ -24,6 +24,56 @@
 
 #include "pch.h"
 
+/**
+ * Checks red black tree properties of a subtree and returns its black height, or -1 if the subtree is invalid
+ */
+template <typename TNode>
+static int ValidateRedBlackSubtree(const TNode* node, const TNode* parent)
+{
+	if (!node)
+	{
+		return 1;
+	}
+
+	if (node->Parent != parent || (node->IsRed && parent && parent->IsRed))
+	{
+		return -1;
+	}
+
+	if constexpr (TNode::kOrderStatistics)
+	{
+		const size_t leftSize = node->Left ? node->Left->SubtreeSize : 0;
+		const size_t rightSize = node->Right ? node->Right->SubtreeSize : 0;
+		if (node->SubtreeSize != leftSize + rightSize + 1)
+		{
+			return -1;
+		}
+	}
+
+	const int leftHeight = ValidateRedBlackSubtree(node->Left, node);
+	const int rightHeight = ValidateRedBlackSubtree(node->Right, node);
+	if (leftHeight < 0 || leftHeight != rightHeight)
+	{
+		return -1;
+	}
+
+	return leftHeight + (node->IsRed ? 0 : 1);
+}
+
+template <typename TTree>
+static bool ValidateRedBlackTree(TTree& tree)
+{
+	auto* root = tree.GetRootNode();
+	if (!root)
+	{
+		return !tree.GetMinNode() && !tree.GetMaxNode() && tree.GetNodeCount() == 0;
+	}
+
+	return !root->IsRed && ValidateRedBlackSubtree(root, decltype(root)(nullptr)) > 0 &&
+		tree.GetMinNode() == root->GetMinValueNode() && tree.GetMaxNode() == root->GetMaxValueNode() &&
+		root->GetChildCount() + 1 == tree.GetNodeCount();
+}
+
 UnitTest(Map_Basic)
 {
 	{
@@ -77,11 +127,147 @@ UnitTest(Map_Basic)
 	}
 }
 
+UnitTest(Map_Traversal)
+{
+	TMap<uint, uint> map;
+	tcheck(map.begin() == map.end()); // empty: no root to descend from
+	tcheck(map.rbegin() == map.rend());
+	tcheck(ValidateRedBlackTree(map.GetTree()));
+
+	uint seed = 4242;
+	for (uint i = 0; i < 3000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		const uint key = (seed >> 8) % 2000;
+		if (i % 3 == 2)
+		{
+			map.Remove(key);
+		}
+		else
+		{
+			map.Insert(key, i);
+		}
+	}
+	tcheck(ValidateRedBlackTree(map.GetTree())); // cached min/max and child counts agree with the tree
+
+	// removing the smallest and largest keys moves the cached ends
+	while (map.GetCount() > 2)
+	{
+		map.Remove((*map.begin()).First);
+		map.Remove((*map.rbegin()).First);
+	}
+	tverify(ValidateRedBlackTree(map.GetTree()));
+	tcheck(map.GetCount() <= 2);
+
+	const TMap<uint, uint>& constMap = map;
+	uint iterated = 0;
+	for (auto it = constMap.begin(); it != constMap.end(); ++it)
+	{
+		++iterated;
+	}
+	tcheck(iterated == map.GetCount());
+
+	TOrderStatisticsMap<uint, uint> statisticsMap;
+	TMap<uint, uint> plainMap;
+	for (uint i = 0; i < 1000; ++i)
+	{
+		statisticsMap.Insert(i * 7 % 1000, i);
+		plainMap.Insert(i * 7 % 1000, i);
+	}
+	const auto* statisticsRoot = statisticsMap.GetTree().GetRootNode();
+	const auto* plainRoot = plainMap.GetTree().GetRootNode();
+	tcheck(statisticsRoot->GetChildCount() == 999);
+	tcheck(plainRoot->Left->GetChildCount() == statisticsRoot->Left->GetChildCount()); // same shape, same insertions
+
+	map.Clear();
+	tcheck(map.begin() == map.end());
+	tcheck(ValidateRedBlackTree(map.GetTree()));
+
+	// teardown needs no stack proportional to the tree height
+	for (uint i = 0; i < 100000; ++i)
+	{
+		map.Insert(i, i);
+	}
+	map.Clear();
+	tcheck(map.GetCount() == 0);
+}
+
+UnitTest(Map_Bounds)
+{
+	TMap<uint, uint> map;
+	tcheck(map.LowerBound(5u) == map.end());
+	tcheck(map.Range(0u, 100u).IsEmpty());
+
+	for (uint i = 0; i < 100; ++i)
+	{
+		map.Insert(i * 10, i);
+	}
+
+	tcheck((*map.LowerBound(30u)).First == 30);
+	tcheck((*map.LowerBound(31u)).First == 40);
+	tcheck((*map.UpperBound(30u)).First == 40);
+	tcheck(map.LowerBound(991u) == map.end());
+	tcheck(map.UpperBound(990u) == map.end());
+
+	const TPair<TMap<uint, uint>::Iterator, TMap<uint, uint>::Iterator> found = map.EqualRange(50u);
+	tcheck((*found.First).First == 50 && (*found.Second).First == 60);
+	const TPair<TMap<uint, uint>::Iterator, TMap<uint, uint>::Iterator> missing = map.EqualRange(55u);
+	tcheck(missing.First == missing.Second && (*missing.First).First == 60);
+
+	// every range against a filtered full scan, both directions, including empty, inverted and out of bounds ones
+	bool forwardValid = true;
+	bool reverseValid = true;
+	for (uint lo = 0; lo < 1020; lo += 7)
+	{
+		for (uint hi = 0; hi < 1020; hi += 13)
+		{
+			TArray<uint> expected;
+			for (const TPair<uint, uint>& pair : map)
+			{
+				if (pair.First >= lo && pair.First < hi)
+				{
+					expected.Add(pair.First);
+				}
+			}
+
+			size_t index = 0;
+			for (const TPair<uint, uint>& pair : map.Range(lo, hi))
+			{
+				forwardValid &= index < expected.GetCount() && pair.First == expected[index++];
+			}
+			forwardValid &= index == expected.GetCount() && map.Range(lo, hi).IsEmpty() == expected.IsEmpty();
+
+			for (const TPair<uint, uint>& pair : reverse(map.Range(lo, hi)))
+			{
+				reverseValid &= index > 0 && pair.First == expected[--index];
+			}
+			reverseValid &= index == 0;
+		}
+	}
+	tcheck(forwardValid);
+	tcheck(reverseValid);
+
+	TMap<FString, uint> stringMap;
+	stringMap.Insert("apple", 1);
+	stringMap.Insert("banana", 2);
+	stringMap.Insert("cherry", 3);
+	stringMap.Insert("date", 4);
+	uint sum = 0;
+	for (const TPair<FString, uint>& pair : stringMap.Range("b", "d")) // looked up by const char*
+	{
+		sum += pair.Second;
+	}
+	tcheck(sum == 2 + 3);
+}
+
 UnitTest(Map_ObjectLifetime)
 {
 	static uint constructCount = 0;
 	static uint copyConstructCount = 0;
 	static uint destructCount = 0;
+	constructCount = 0; // the counters are static, start over on repeated runs
+	copyConstructCount = 0;
+	destructCount = 0;
 
 	struct SConstructorMock
 	{
@@ -108,9 +294,414 @@ UnitTest(Map_ObjectLifetime)
 
 	map[5] = SConstructorMock();
 	tcheck(map.GetCount() == 1);
-	tcheck(constructCount == 2); // 1 in the test body, 1 in operator[] (initial value)
-	tcheck(copyConstructCount == 2); // 1 when creating TPair, 1 when copying TPair to 
-	tcheck(destructCount == 3); // destroyed instances: 1 in the test body, 1 in operator[] (initial value), 1 when creating TPair
+	tcheck(constructCount == 2); // 1 in the test body, 1 in operator[] (initial value, constructed in place in the node)
+	tcheck(copyConstructCount == 0);
+	tcheck(destructCount == 1); // destroyed instance: 1 in the test body
 	map.Clear();
-	tcheck(destructCount == 4); // destroyed instance: actual data in the tree
-}
\ No newline at end of file
+	tcheck(destructCount == 2); // destroyed instance: actual data in the tree
+}
+
+UnitTest(Map_CopyMove)
+{
+	TMap<uint, FString> map;
+	for (uint i = 0; i < 100; ++i)
+	{
+		map.Insert(i * 3, FFormat::Format("value {}", i));
+	}
+
+	TMap<uint, FString> copy(map);
+	tcheck(ValidateRedBlackTree(copy.GetTree()));
+	tcheck(copy.GetCount() == map.GetCount());
+	copy.Remove(0u);
+	*copy.Find(3u) = "changed";
+	tcheck(map.GetCount() == 100);
+	tcheck(*map.Find(0u) == "value 0");
+	tcheck(*map.Find(3u) == "value 1");
+
+	copy = map;
+	tcheck(ValidateRedBlackTree(copy.GetTree()));
+	bool equal = copy.GetCount() == map.GetCount();
+	for (uint i = 0; i < 100; ++i)
+	{
+		equal &= *copy.Find(i * 3) == *map.Find(i * 3);
+	}
+	tcheck(equal);
+
+	TMap<uint, FString> moved(std::move(copy));
+	tcheck(copy.GetCount() == 0);
+	tcheck(copy.begin() == copy.end());
+	tcheck(moved.GetCount() == 100);
+	tcheck(ValidateRedBlackTree(moved.GetTree()));
+
+	TMap<uint, FString> target;
+	target.Insert(1u, "dropped");
+	target = std::move(moved);
+	tcheck(moved.GetCount() == 0);
+	tcheck(target.GetCount() == 100 && !target.Find(1u));
+	tcheck(*target.Find(297u) == "value 99");
+
+	copy.Insert(7u, "reused"); // moved-from maps stay usable
+	tcheck(copy.GetCount() == 1);
+}
+
+UnitTest(Map_Churn)
+{
+	using FNodeType = TMap<uint, uint>::TreeNodeType;
+	using FMockAllocator = TAllocatorMock<FNodeType, TPoolAllocator<FNodeType>>;
+
+	TMap<uint, uint, FUtils::Less<const uint>, TPair<uint, uint>, FMockAllocator> map;
+	FMockAllocator& allocator = map.GetTree().GetAllocator();
+
+	uint seed = 12345;
+	bool present[1024]{};
+	size_t expectedCount = 0;
+	for (uint i = 0; i < 20000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223; // LCG
+		const uint key = (seed >> 8) % 1024;
+		if (present[key])
+		{
+			map.Remove(key);
+			--expectedCount;
+		}
+		else
+		{
+			map.Insert(key, key * 3);
+			++expectedCount;
+		}
+		present[key] = !present[key];
+	}
+	tcheck(map.GetCount() == expectedCount);
+	tcheck(ValidateRedBlackTree(map.GetTree()));
+	tcheck(allocator.Allocator.GetBlockCount() <= 1024 / 64 + 1); // freed nodes were reused
+
+	uint previousKey = 0;
+	bool ordered = true;
+	bool valid = true;
+	for (const TPair<uint, uint>& pair : map)
+	{
+		ordered &= pair.First >= previousKey;
+		valid &= present[pair.First] && pair.Second == pair.First * 3;
+		previousKey = pair.First;
+	}
+	tcheck(ordered);
+	tcheck(valid);
+}
+
+UnitTest(Map_OrderStatistics)
+{
+	TOrderStatisticsMap<uint, uint> map;
+	bool present[512]{};
+
+	uint seed = 777;
+	for (uint i = 0; i < 5000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223; // LCG
+		const uint key = (seed >> 8) % 512;
+		if (present[key])
+		{
+			map.Remove(key);
+		}
+		else
+		{
+			map.Insert(key, key);
+		}
+		present[key] = !present[key];
+	}
+	tcheck(ValidateRedBlackTree(map.GetTree()));
+
+	size_t expectedRank = 0;
+	bool ranksValid = true;
+	bool selectValid = true;
+	for (uint key = 0; key < 512; ++key)
+	{
+		ranksValid &= map.Rank(key) == expectedRank;
+		if (present[key])
+		{
+			const TPair<uint, uint>* pair = map.Select(expectedRank);
+			selectValid &= pair && pair->First == key;
+			++expectedRank;
+		}
+	}
+	tcheck(ranksValid);
+	tcheck(selectValid);
+	tcheck(map.GetCount() == expectedRank);
+	tcheck(map.Select(expectedRank) == nullptr);
+
+	map.Clear();
+	tcheck(map.GetCount() == 0);
+	tcheck(map.Rank(100) == 0);
+}
+
+UnitTest(Map_Find)
+{
+	using FNodeAllocator = TAllocatorMock<TBinaryTreeNode<TPair<int, int>>>;
+	TMap<int, int, FUtils::Less<const int>, TPair<int, int>, FNodeAllocator> map;
+	FNodeAllocator& allocator = map.GetTree().GetAllocator();
+
+	map.Insert(1, 10);
+	map.Insert(2, 20);
+	tcheck(allocator.AllocCount == 2);
+
+	tcheck(*map.Find(1) == 10);
+	tcheck(map.Find(3) == nullptr);
+	tcheck(map.Contains(2));
+	tcheck(!map.Contains(3));
+	tcheck(allocator.AllocCount == 2); // misses do not insert
+
+	tcheck(map.FindOrAdd(2, 99) == 20); // present: argument ignored
+	tcheck(allocator.AllocCount == 2);
+	tcheck(map.FindOrAdd(3, 30) == 30);
+	tcheck(allocator.AllocCount == 3);
+	tcheck(map.GetCount() == 3);
+	tcheck(ValidateRedBlackTree(map.GetTree()));
+
+	TMap<FString, FString> stringMap;
+	stringMap.FindOrAdd("key", "a value that is long enough to live on the heap");
+	stringMap.Insert("another key", "value");
+	tcheck(stringMap.Contains("key")); // looked up by const char*, no FString is built
+	tcheck(!stringMap.Contains("missing"));
+	tcheck(strcmp(stringMap.Find("another key")->GetData(), "value") == 0);
+	stringMap.Remove("key");
+	tcheck(stringMap.GetCount() == 1);
+}
+
+UnitTest(Map_BuildFromSorted)
+{
+	bool orderValid = true;
+	bool selectValid = true;
+	for (uint count = 0; count < 70; ++count) // every shape of the last level
+	{
+		TArray<TPair<uint, uint>> pairs;
+		for (uint i = 0; i < count; ++i)
+		{
+			pairs.Add(TPair<uint, uint>(i * 3, i));
+		}
+
+		TOrderStatisticsMap<uint, uint> map;
+		map.Insert(1, 1); // replaced
+		map.BuildFromSorted(pairs.GetData(), pairs.GetCount());
+		tverify(ValidateRedBlackTree(map.GetTree()));
+		tverify(map.GetCount() == count);
+
+		uint expected = 0;
+		for (const TPair<uint, uint>& pair : map)
+		{
+			orderValid &= pair.First == expected * 3 && pair.Second == expected;
+			++expected;
+		}
+		orderValid &= expected == count;
+		for (uint i = 0; i < count; ++i)
+		{
+			selectValid &= map.Select(i)->Second == i && map.Rank(i * 3) == i;
+		}
+	}
+	tcheck(orderValid);
+	tcheck(selectValid); // subtree sizes are set
+
+	TArray<TPair<uint, FString>> pairs;
+	for (uint i = 0; i < 100; ++i)
+	{
+		pairs.Add(TPair<uint, FString>(i, "a value that is long enough to live on the heap"));
+	}
+	TMap<uint, FString> stringMap;
+	stringMap.BuildFromSorted(std::move(pairs));
+	tcheck(pairs.GetCount() == 0);
+	tcheck(stringMap.GetCount() == 100);
+	tcheck(*stringMap.Find(42u) == "a value that is long enough to live on the heap");
+	tcheck(stringMap.GetTree().GetAllocator().GetBlockCount() == 1); // all nodes in one block
+
+	bool contiguous = true;
+	for (uint i = 1; i < 100; ++i)
+	{
+		contiguous &= (const char*)stringMap.Find(i) - (const char*)stringMap.Find(i - 1) == sizeof(TMap<uint, FString>::TreeNodeType);
+	}
+	tcheck(contiguous);
+}
+
+UnitTest(Map_Union)
+{
+	for (const uint otherCount : {3u, 300u}) // inserted one by one, merged linearly
+	{
+		TOrderStatisticsMap<uint, uint> map;
+		TOrderStatisticsMap<uint, uint> other;
+		for (uint i = 0; i < 500; i += 2)
+		{
+			map.Insert(i, 0);
+		}
+		for (uint i = 0; i < otherCount; ++i)
+		{
+			other.Insert(i * 5, 1);
+		}
+
+		const size_t initialCount = map.GetCount();
+		map.Union(other);
+		tcheck(ValidateRedBlackTree(map.GetTree()));
+		tcheck(other.GetCount() == otherCount);
+
+		size_t expectedCount = initialCount;
+		bool valuesValid = true;
+		for (uint i = 0; i < otherCount; ++i)
+		{
+			const uint key = i * 5;
+			expectedCount += key % 2 == 1 || key >= 500;
+			valuesValid &= *map.Find(key) == (key % 2 == 0 && key < 500 ? 0u : 1u); // values already here win
+		}
+		tcheck(valuesValid);
+		tcheck(map.GetCount() == expectedCount);
+
+		bool selectValid = true;
+		for (uint i = 0; i < map.GetCount(); ++i)
+		{
+			selectValid &= map.Rank(map.Select(i)->First) == i;
+		}
+		tcheck(selectValid);
+	}
+
+	TMap<uint, FString> map;
+	TMap<uint, FString> other;
+	for (uint i = 0; i < 50; ++i)
+	{
+		map.Insert(i * 2, "here");
+		other.Insert(i * 3, "a value that is long enough to live on the heap");
+	}
+	map.Merge(std::move(other));
+	tcheck(ValidateRedBlackTree(map.GetTree()));
+	tcheck(other.GetCount() == 0);
+	tcheck(map.GetCount() == 50 + 50 - 17);
+	tcheck(*map.Find(6) == "here");
+	tcheck(*map.Find(9) == "a value that is long enough to live on the heap");
+
+	map.Merge(TMap<uint, FString>()); // no-op
+	tcheck(map.GetCount() == 83);
+}
+
+Benchmark(Map_Insert)
+{
+	bench.Measure("1000", []
+	{
+		TMap<uint, uint> map;
+		uint seed = 12345;
+		for (uint i = 0; i < 1000; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			map.Insert(seed, i);
+		}
+		FBenchmark::DoNotOptimize(map.GetCount());
+	});
+}
+
+Benchmark(Map_Find)
+{
+	constexpr uint kCount = 65536;
+	TMap<uint, uint> map;
+	for (uint i = 0; i < kCount; ++i)
+	{
+		map.Insert(i * 2654435761u, i);
+	}
+
+	uint i = 0;
+	bench.Measure("65536", [&map, &i]
+	{
+		FBenchmark::DoNotOptimize(map.Find((i++ % kCount) * 2654435761u));
+	});
+}
+
+Benchmark(Map_Build)
+{
+	constexpr uint kCount = 100000;
+	TArray<TPair<uint, uint>> pairs;
+	for (uint i = 0; i < kCount; ++i)
+	{
+		pairs.Add(TPair<uint, uint>(i, i));
+	}
+
+	bench.Measure("Insert", [&pairs]
+	{
+		TMap<uint, uint> map;
+		for (const TPair<uint, uint>& pair : pairs)
+		{
+			map.Insert(pair.First, pair.Second);
+		}
+		FBenchmark::DoNotOptimize(map.GetCount());
+	});
+
+	bench.Measure("BuildFromSorted", [&pairs]
+	{
+		TMap<uint, uint> map;
+		map.BuildFromSorted(pairs.GetData(), pairs.GetCount());
+		FBenchmark::DoNotOptimize(map.GetCount());
+	});
+}
+
+Benchmark(Map_Union)
+{
+	constexpr uint kCount = 100000;
+	TMap<uint, uint> odd;
+	for (uint i = 1; i < kCount; i += 2)
+	{
+		odd.Insert(i, i);
+	}
+
+	bench.Measure("Insert", [&odd]
+	{
+		TMap<uint, uint> map;
+		for (uint i = 0; i < kCount; i += 2)
+		{
+			map.Insert(i, i);
+		}
+		for (const TPair<uint, uint>& pair : odd)
+		{
+			map.Insert(pair.First, pair.Second);
+		}
+		FBenchmark::DoNotOptimize(map.GetCount());
+	});
+
+	bench.Measure("Union", [&odd]
+	{
+		TMap<uint, uint> map;
+		for (uint i = 0; i < kCount; i += 2)
+		{
+			map.Insert(i, i);
+		}
+		map.Union(odd);
+		FBenchmark::DoNotOptimize(map.GetCount());
+	});
+}
+
+Benchmark(Map_Range)
+{
+	constexpr uint kCount = 100000;
+	TMap<uint, uint> map;
+	for (uint i = 0; i < kCount; ++i)
+	{
+		map.Insert(i, i);
+	}
+
+	// 100 keys out of 100K
+	uint lo = 0;
+	bench.Measure("FullScan", [&map, &lo]
+	{
+		uint64 sum = 0;
+		for (const TPair<uint, uint>& pair : map)
+		{
+			if (pair.First >= lo && pair.First < lo + 100)
+			{
+				sum += pair.Second;
+			}
+		}
+		lo = (lo + 997) % (kCount - 100);
+		FBenchmark::DoNotOptimize(sum);
+	});
+
+	bench.Measure("Range", [&map, &lo]
+	{
+		uint64 sum = 0;
+		for (const TPair<uint, uint>& pair : map.Range(lo, lo + 100))
+		{
+			sum += pair.Second;
+		}
+		lo = (lo + 997) % (kCount - 100);
+		FBenchmark::DoNotOptimize(sum);
+	});
+}
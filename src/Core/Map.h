@@ -25,17 +25,22 @@
 #pragma once
 
 /**
- * A simple map implementation based on red black binary search tree
+ * A simple map implementation based on red black binary search tree.
+ * Tree nodes come from a pool by default: insert/remove churn reuses node memory instead of going through the heap.
+ * The tree node type is the element type of the allocator (see TOrderStatisticsMap)
  */
 template <typename TKey, typename TValue, typename TCompare = FUtils::Less<const TKey>, typename TPair = TPair<TKey, TValue>, typename TAllocator =
-          TRawAllocator<TBinaryTreeNode<TPair>>>
+          TPoolAllocator<TBinaryTreeNode<TPair>>>
 class TMap
 {
 	using CompareType = TPairFirstCompare<TKey, TValue, TCompare>;
 
 public: // make tree type public for external tree inspection
-	using TreeNodeType = TBinaryTreeNode<TPair>;
+	using TreeNodeType = typename TAllocator::ElementType;
 	using TreeType = TBinaryTree<TPair, TreeNodeType, CompareType, TAllocator>;
+	using AllocatorType = TAllocator;
+
+	static_assert(std::is_same<typename TreeNodeType::DataType, TPair>::value, "TMap allocator must allocate tree nodes of TPair");
 
 	class Iterator
 	{
@@ -113,12 +118,74 @@ public: // make tree type public for external tree inspection
 		}
 	};
 
+	/**
+	 * The pairs with keys in [lo, hi), see TMap::Range. Forward and reverse iteration visit only these pairs
+	 */
+	class KeyRange
+	{
+		friend TMap;
+
+		TreeNodeType* m_First; // null when every key is less than lo
+		TreeNodeType* m_End; // first node past the range, null at the end of the map
+		TreeNodeType* m_Last; // last node in the range, or the node before an empty range
+		TreeNodeType* m_BeforeFirst;
+
+		KeyRange(TreeNodeType* first, TreeNodeType* end, TreeNodeType* maxNode) : m_First(first), m_End(end)
+		{
+			m_Last = end ? end->GetInorderPredeccessor() : maxNode;
+			m_BeforeFirst = first ? first->GetInorderPredeccessor() : maxNode;
+		}
+
+	public:
+		FORCEINLINE bool IsEmpty() const
+		{
+			return m_First == m_End;
+		}
+
+		FORCEINLINE Iterator begin() const
+		{
+			return Iterator(m_First);
+		}
+
+		FORCEINLINE Iterator end() const
+		{
+			return Iterator(m_End);
+		}
+
+		FORCEINLINE ReverseIterator rbegin() const
+		{
+			return ReverseIterator(m_Last);
+		}
+
+		FORCEINLINE ReverseIterator rend() const
+		{
+			return ReverseIterator(m_BeforeFirst);
+		}
+	};
+
 private:
 	TreeType m_Tree;
 
+	static FORCEINLINE void CheckSorted(const TPair* pairs, const size_t count)
+	{
+#ifdef PF_DEBUG
+		for (size_t i = 1; i < count; ++i)
+		{
+			check(CompareType()(pairs[i - 1], pairs[i])); // keys must be unique and ascending
+		}
+#else
+		(void)pairs;
+		(void)count;
+#endif
+	}
+
 public:
 	FORCEINLINE TMap() = default;
 
+	explicit FORCEINLINE TMap(const TAllocator& allocator) : m_Tree(allocator)
+	{
+	}
+
 	FORCEINLINE void Insert(const TKey& key, const TValue& value)
 	{
 		m_Tree.Insert(TPair(key, value));
@@ -129,7 +196,8 @@ public:
 		m_Tree.InsertOrUpdate(TPair(key, value));
 	}
 
-	FORCEINLINE void Remove(const TKey& key)
+	template <typename U>
+	FORCEINLINE void Remove(const U& key)
 	{
 		TreeNodeType* node = m_Tree.FindNode(key);
 		if (node) {
@@ -137,70 +205,189 @@ public:
 		}
 	}
 
-	FORCEINLINE size_t GetCount() const
+	/**
+	 * Returns the value of `key` or null. Never allocates.
+	 * `key` may be of any type TCompare can compare with TKey, e.g. const char* for FString keys
+	 */
+	template <typename U>
+	FORCEINLINE TValue* Find(const U& key)
 	{
-		return m_Tree.GetNodeCount();
+		TreeNodeType* node = m_Tree.FindNode(key);
+		return node ? &node->Data.Second : nullptr;
 	}
 
-	FORCEINLINE TreeType& GetTree()
+	template <typename U>
+	FORCEINLINE const TValue* Find(const U& key) const
 	{
-		return m_Tree;
+		return const_cast<TMap*>(this)->Find(key);
 	}
 
-	FORCEINLINE void Clear()
+	template <typename U>
+	FORCEINLINE bool Contains(const U& key) const
 	{
-		m_Tree.Clear();
+		return Find(key) != nullptr;
 	}
 
-	FORCEINLINE TValue& operator[](const TKey& key)
+	/**
+	 * Returns the value of `key`, inserting one constructed in place from `args` if the key is missing
+	 */
+	template <typename...Args>
+	FORCEINLINE TValue& FindOrAdd(const TKey& key, Args&&...args)
 	{
-		TreeNodeType* node = m_Tree.FindNode(key);
-		if(!node)
+		return m_Tree.FindOrEmplace(key, FEmplaceSecond(), key, std::forward<Args>(args)...).InsertedNode->Data.Second;
+	}
+
+	/**
+	 * Replace the contents with `count` pairs whose keys are strictly ascending. O(n) instead of O(n log n) inserts:
+	 * the tree is linked perfectly balanced in one pass and, with the default pool allocator, all nodes come from a
+	 * single block
+	 */
+	void BuildFromSorted(const TPair* pairs, const size_t count)
+	{
+		CheckSorted(pairs, count);
+		m_Tree.BuildFromSorted(count, [&pairs]() -> const TPair& { return *pairs++; });
+	}
+
+	/**
+	 * Same as above, the pairs are moved out of `pairs`
+	 */
+	template <typename TArrayAllocator>
+	void BuildFromSorted(TArray<TPair, TArrayAllocator>&& pairs)
+	{
+		TPair* pair = pairs.GetData();
+		CheckSorted(pair, pairs.GetCount());
+		m_Tree.BuildFromSorted(pairs.GetCount(), [&pair]() -> TPair&& { return std::move(*pair++); });
+		pairs.Clear();
+	}
+
+	/**
+	 * Add copies of the pairs of `other` whose keys are missing here, values already here win.
+	 * O(n + m), or O(m log n) when `other` is small
+	 */
+	void Union(const TMap& other)
+	{
+		check(&other != this);
+		m_Tree.Union(other.m_Tree);
+	}
+
+	/**
+	 * Same as Union but pairs are moved out of `other`, which is left empty
+	 */
+	void Merge(TMap&& other)
+	{
+		check(&other != this);
+		m_Tree.Merge(std::move(other.m_Tree));
+	}
+
+	/**
+	 * Returns the first pair whose key is not less than `key`, or end(). O(log n)
+	 */
+	template <typename U>
+	FORCEINLINE Iterator LowerBound(const U& key) const
+	{
+		return Iterator(m_Tree.LowerBoundNode(key));
+	}
+
+	/**
+	 * Returns the first pair whose key is greater than `key`, or end(). O(log n)
+	 */
+	template <typename U>
+	FORCEINLINE Iterator UpperBound(const U& key) const
+	{
+		return Iterator(m_Tree.UpperBoundNode(key));
+	}
+
+	/**
+	 * Returns LowerBound and UpperBound of `key`: the pair with that key, or an empty range where it would be.
+	 * Keys are unique, so a single descent does
+	 */
+	template <typename U>
+	FORCEINLINE ::TPair<Iterator, Iterator> EqualRange(const U& key) const
+	{
+		TreeNodeType* first = m_Tree.LowerBoundNode(key);
+		TreeNodeType* last = first && !CompareType()(key, first->Data) ? first->GetInorderSuccessor() : first;
+		return ::TPair<Iterator, Iterator>(Iterator(first), Iterator(last));
+	}
+
+	/**
+	 * The pairs with keys in [lo, hi) in ascending order, or descending through reverse(). Empty if hi is not greater
+	 * than lo. O(log n) to find the ends, then only the pairs in range are visited
+	 */
+	template <typename U, typename V>
+	FORCEINLINE KeyRange Range(const U& lo, const V& hi) const
+	{
+		TreeNodeType* first = m_Tree.LowerBoundNode(lo);
+		TreeNodeType* end = m_Tree.LowerBoundNode(hi);
+		if (!first || (end && CompareType()(end->Data, first->Data)))
 		{
-			node = m_Tree.Insert(TPair(key, TValue())).InsertedNode;
+			end = first;
 		}
-		
-		return node->Data.Second;
+		return KeyRange(first, end, m_Tree.GetMaxNode());
 	}
 
-	FORCEINLINE Iterator begin()
+	FORCEINLINE size_t GetCount() const
 	{
-		return Iterator(m_Tree.GetRootNode()->GetMinValueNode());
+		return m_Tree.GetNodeCount();
 	}
 
-	FORCEINLINE Iterator end()
+	/**
+	 * Returns the pair at `index` in key order or null if out of range. O(log n), see TOrderStatisticsMap
+	 */
+	FORCEINLINE TPair* Select(const size_t index)
 	{
-		return Iterator(nullptr);
+		TreeNodeType* node = m_Tree.Select(index);
+		return node ? &node->Data : nullptr;
 	}
 
-	FORCEINLINE const Iterator& begin() const
+	/**
+	 * Returns the number of keys less than `key`. O(log n), see TOrderStatisticsMap
+	 */
+	FORCEINLINE size_t Rank(const TKey& key)
 	{
-		return Iterator(m_Tree.GetRootNode()->GetMinValueNode());
+		return m_Tree.Rank(key);
 	}
 
-	FORCEINLINE const Iterator& end() const
+	FORCEINLINE TreeType& GetTree()
 	{
-		return Iterator(nullptr);
+		return m_Tree;
 	}
-	
 
-	FORCEINLINE ReverseIterator rbegin()
+	FORCEINLINE void Clear()
 	{
-		return ReverseIterator(m_Tree.GetRootNode()->GetMaxValueNode());
+		m_Tree.Clear();
 	}
 
-	FORCEINLINE ReverseIterator rend()
+	FORCEINLINE TValue& operator[](const TKey& key)
 	{
-		return ReverseIterator(nullptr);
+		return FindOrAdd(key);
 	}
 
-	FORCEINLINE const ReverseIterator& rbegin() const
+	/**
+	 * Iteration starts at the cached leftmost (rightmost) node: O(1), an empty map gives begin() == end()
+	 */
+	FORCEINLINE Iterator begin() const
 	{
-		return ReverseIterator(m_Tree.GetRootNode()->GetMaxValueNode());
+		return Iterator(m_Tree.GetMinNode());
 	}
 
-	FORCEINLINE const ReverseIterator& rend() const
+	FORCEINLINE Iterator end() const
+	{
+		return Iterator(nullptr);
+	}
+
+	FORCEINLINE ReverseIterator rbegin() const
+	{
+		return ReverseIterator(m_Tree.GetMaxNode());
+	}
+
+	FORCEINLINE ReverseIterator rend() const
 	{
 		return ReverseIterator(nullptr);
 	}
 };
+
+/**
+ * TMap with subtree sizes in the tree nodes: enables O(log n) Select and Rank at the cost of a size_t per node
+ */
+template <typename TKey, typename TValue, typename TCompare = FUtils::Less<const TKey>>
+using TOrderStatisticsMap = TMap<TKey, TValue, TCompare, TPair<TKey, TValue>, TPoolAllocator<TBinaryTreeNode<TPair<TKey, TValue>, true>>>;
@@ -0,0 +1,320 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+FMemArena::FMemArena(const size_t chunkSize, const EAllocationPurpose purpose) : m_ChunkSize(chunkSize),
+                                                                                 m_Purpose(purpose)
+{
+}
+
+FMemArena::~FMemArena()
+{
+	SChunk* chunk = m_FirstChunk;
+	while (chunk)
+	{
+		SChunk* next = chunk->Next;
+		FMemory::Free(chunk, m_Purpose);
+		chunk = next;
+	}
+}
+
+uint8* FMemArena::AllocFromChunk(const size_t size, const size_t alignment)
+{
+	if (!m_CurrentChunk)
+	{
+		return nullptr;
+	}
+
+	uintptr_t res = (uintptr_t)m_Cursor + sizeof(SAllocationHeader);
+	res = (res + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+	if (res + size > (uintptr_t)m_CurrentChunk->End)
+	{
+		return nullptr;
+	}
+
+	((SAllocationHeader*)res - 1)->Size = size;
+	m_Cursor = (uint8*)res + size;
+	m_LastAllocation = (uint8*)res;
+	return (uint8*)res;
+}
+
+void FMemArena::NextChunk(const size_t size, const size_t alignment)
+{
+	const size_t requiredSize = sizeof(SAllocationHeader) + size + alignment;
+	SChunk* next = m_CurrentChunk ? m_CurrentChunk->Next : m_FirstChunk;
+
+	if (next && (size_t)(next->End - next->GetBegin()) >= requiredSize) // reuse a chunk kept by Rewind/Reset
+	{
+		m_CurrentChunk = next;
+	}
+	else
+	{
+		const size_t dataSize = requiredSize > m_ChunkSize ? requiredSize : m_ChunkSize;
+		SChunk* chunk = (SChunk*)FMemory::Alloc(sizeof(SChunk) + dataSize, alignof(SChunk), m_Purpose);
+		chunk->End = chunk->GetBegin() + dataSize;
+		chunk->Next = next;
+
+		if (m_CurrentChunk)
+		{
+			m_CurrentChunk->Next = chunk;
+		}
+		else
+		{
+			m_FirstChunk = chunk;
+		}
+		m_CurrentChunk = chunk;
+	}
+
+	m_Cursor = m_CurrentChunk->GetBegin();
+}
+
+void* FMemArena::Alloc(const size_t size, size_t alignment)
+{
+	check((alignment & (alignment - 1)) == 0);
+	if (alignment < alignof(SAllocationHeader))
+	{
+		alignment = alignof(SAllocationHeader);
+	}
+
+	uint8* res = AllocFromChunk(size, alignment);
+	if (!res)
+	{
+		NextChunk(size, alignment);
+		res = AllocFromChunk(size, alignment);
+	}
+	return res;
+}
+
+void* FMemArena::ReAlloc(void* memory, const size_t size, const size_t alignment)
+{
+	if (!memory)
+	{
+		return Alloc(size, alignment);
+	}
+
+	SAllocationHeader* header = (SAllocationHeader*)memory - 1;
+	const bool aligned = ((uintptr_t)memory & (alignment - 1)) == 0;
+
+	if (memory == m_LastAllocation && aligned && (uint8*)memory + size <= m_CurrentChunk->End) // resize in place
+	{
+		header->Size = size;
+		m_Cursor = (uint8*)memory + size;
+		return memory;
+	}
+
+	if (size <= header->Size && aligned) // shrinking: the block stays where it is
+	{
+		header->Size = size;
+		return memory;
+	}
+
+	void* res = Alloc(size, alignment);
+	FMemory::Copy(res, memory, size < header->Size ? size : header->Size); // may be a shrink to a stricter alignment
+	return res;
+}
+
+void FMemArena::Free(void* memory)
+{
+	if (memory && memory == m_LastAllocation)
+	{
+		m_Cursor = (uint8*)((SAllocationHeader*)memory - 1);
+		m_LastAllocation = nullptr;
+	}
+}
+
+void FMemArena::Rewind(const SMark& mark)
+{
+	if (!mark.Chunk)
+	{
+		Reset();
+		return;
+	}
+
+	m_CurrentChunk = mark.Chunk;
+	m_Cursor = mark.Cursor;
+	m_LastAllocation = nullptr;
+}
+
+void FMemArena::Reset()
+{
+	m_CurrentChunk = m_FirstChunk;
+	m_Cursor = m_FirstChunk ? m_FirstChunk->GetBegin() : nullptr;
+	m_LastAllocation = nullptr;
+}
+
+void FMemArena::Trim()
+{
+	SChunk* chunk = m_CurrentChunk ? m_CurrentChunk->Next : m_FirstChunk;
+	while (chunk)
+	{
+		SChunk* next = chunk->Next;
+		FMemory::Free(chunk, m_Purpose);
+		chunk = next;
+	}
+
+	if (m_CurrentChunk)
+	{
+		m_CurrentChunk->Next = nullptr;
+	}
+	else
+	{
+		m_FirstChunk = nullptr;
+	}
+}
+
+size_t FMemArena::GetUsedMemory() const
+{
+	size_t used = 0;
+	for (SChunk* chunk = m_FirstChunk; chunk && chunk != m_CurrentChunk; chunk = chunk->Next)
+	{
+		used += chunk->End - chunk->GetBegin();
+	}
+
+	if (m_CurrentChunk)
+	{
+		used += m_Cursor - m_CurrentChunk->GetBegin();
+	}
+	return used;
+}
+
+size_t FMemArena::GetReservedMemory() const
+{
+	size_t reserved = 0;
+	for (SChunk* chunk = m_FirstChunk; chunk; chunk = chunk->Next)
+	{
+		reserved += chunk->End - chunk->GetBegin();
+	}
+	return reserved;
+}
+
+UnitTest(MemArena_Basic)
+{
+	FMemArena arena(1024);
+	tcheck(arena.GetReservedMemory() == 0);
+
+	void* first = arena.Alloc(10);
+	tcheck(first != nullptr);
+	tcheck(arena.GetReservedMemory() == 1024);
+
+	void* aligned = arena.Alloc(64, 64);
+	tcheck(((uintptr_t)aligned & 63) == 0);
+
+	void* grown = arena.ReAlloc(aligned, 128, 64); // last allocation grows in place
+	tcheck(grown == aligned);
+
+	void* big = arena.Alloc(4096); // oversized allocation gets a dedicated chunk
+	tcheck(big != nullptr);
+	tcheck(arena.GetReservedMemory() > 1024 + 4096);
+
+	void* moved = arena.ReAlloc(first, 20); // not the last allocation: copied
+	tcheck(moved != first);
+
+	const size_t reserved = arena.GetReservedMemory();
+	arena.Reset();
+	tcheck(arena.GetUsedMemory() == 0);
+	tcheck(arena.Alloc(10) == first); // memory is reused after reset
+	arena.Alloc(4000);
+	tcheck(arena.GetReservedMemory() == reserved); // chunks are reused after reset
+
+	arena.Reset();
+	arena.Trim();
+	tcheck(arena.GetReservedMemory() == 1024);
+
+	// shrinking to a stricter alignment moves the block and copies only what fits: the moved block lands on memory
+	// filled with a pattern first, which must survive past its end
+	FMemArena alignArena(4096);
+	tcheck(alignArena.Alloc(1, 256) != nullptr);
+	uint8* wide = (uint8*)alignArena.Alloc(48); // right after a 256 aligned block: not 256 aligned
+	tverify(((uintptr_t)wide & 255) != 0);
+	for (uint8 i = 0; i < 48; ++i)
+	{
+		wide[i] = i;
+	}
+	const FMemArena::SMark mark = alignArena.GetMark();
+	memset(alignArena.Alloc(1024), 0xAB, 1024);
+	alignArena.Rewind(mark);
+
+	const uint8* narrow = (const uint8*)alignArena.ReAlloc(wide, 8, 256);
+	tcheck(((uintptr_t)narrow & 255) == 0);
+	tcheck(narrow[0] == 0 && narrow[7] == 7);
+	tcheck(narrow[8] == 0xAB && narrow[39] == 0xAB);
+}
+
+UnitTest(MemArena_Mark)
+{
+	FMemArena arena(256);
+	arena.Alloc(16);
+
+	const FMemArena::SMark mark = arena.GetMark();
+	const size_t usedAtMark = arena.GetUsedMemory();
+	void* afterMark = arena.Alloc(16);
+	for (int i = 0; i < 32; ++i)
+	{
+		arena.Alloc(64);
+	}
+	tcheck(arena.GetUsedMemory() > 256);
+
+	arena.Rewind(mark);
+	tcheck(arena.GetUsedMemory() == usedAtMark);
+	tcheck(arena.Alloc(16) == afterMark);
+
+	void* last = arena.Alloc(32);
+	arena.Free(last); // freeing the last allocation releases it
+	tcheck(arena.Alloc(32) == last);
+}
+
+UnitTestExclusive(MemArena_Containers)
+{
+	FMemArena arena;
+	const size_t initialMemory = FMemory::GetPurposeMemory(EAllocationPurpose::General);
+
+	{
+		TArray<int, TArenaAllocator<int>> intArray{TArenaAllocator<int>(arena)};
+		for (int i = 0; i < 1000; ++i)
+		{
+			intArray.Add(i);
+		}
+		tcheck(intArray.GetCount() == 1000);
+		tcheck(intArray[999] == 999);
+
+		using FArenaMap = TMap<int, int, FUtils::Less<const int>, TPair<int, int>, TArenaAllocator<TBinaryTreeNode<TPair<int, int>>>>;
+		FArenaMap map{FArenaMap::AllocatorType(arena)};
+		for (int i = 0; i < 100; ++i)
+		{
+			map.Insert(i, i * 2);
+		}
+		tcheck(map.GetCount() == 100);
+		tcheck(map[50] == 100);
+
+		TString<TArenaAllocator<char>> string("arena string", TArenaAllocator<char>(arena));
+		string += TString<TArenaAllocator<char>>(" appended", TArenaAllocator<char>(arena));
+		tcheck(strcmp(string.GetData(), "arena string appended") == 0);
+	}
+
+	tcheck(arena.GetReservedMemory() == 64 * 1024); // everything fit in a single chunk
+	tcheck(FMemory::GetPurposeMemory(EAllocationPurpose::General) - initialMemory < 64 * 1024 + 256); // no per-container heap allocations
+	arena.Reset();
+}
@@ -0,0 +1,168 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Linear (bump pointer) allocator for request or frame scoped memory.
+ * Memory is taken from chunks allocated through FMemory and is only given back in bulk, with Rewind or Reset.
+ * Destructors are not called by the arena: containers destroy their elements before freeing the memory as usual
+ */
+class FMemArena
+{
+	struct SChunk
+	{
+		SChunk* Next;
+		uint8* End;
+
+		FORCEINLINE uint8* GetBegin()
+		{
+			return (uint8*)(this + 1);
+		}
+	};
+
+	/**
+	 * Every allocation is prefixed by its size, ReAlloc needs it to copy the data
+	 */
+	struct SAllocationHeader
+	{
+		size_t Size;
+	};
+
+	SChunk* m_FirstChunk = nullptr;
+	SChunk* m_CurrentChunk = nullptr;
+	uint8* m_Cursor = nullptr;
+
+	/**
+	 * The last allocation: the only one that can be resized in place or freed
+	 */
+	uint8* m_LastAllocation = nullptr;
+
+	size_t m_ChunkSize;
+	EAllocationPurpose m_Purpose;
+
+	uint8* AllocFromChunk(size_t size, size_t alignment);
+	void NextChunk(size_t size, size_t alignment);
+
+public:
+	struct SMark
+	{
+		SChunk* Chunk;
+		uint8* Cursor;
+	};
+
+	explicit FMemArena(size_t chunkSize = 64 * 1024, EAllocationPurpose purpose = EAllocationPurpose::General);
+	~FMemArena();
+
+	FMemArena(const FMemArena& other) = delete;
+	FMemArena(FMemArena&& other) = delete;
+	FMemArena& operator=(const FMemArena& other) = delete;
+	FMemArena& operator=(FMemArena&& other) = delete;
+
+	void* Alloc(size_t size, size_t alignment = 1);
+
+	/**
+	 * Grows or shrinks the last allocation in place, other allocations are copied to a new block
+	 */
+	void* ReAlloc(void* memory, size_t size, size_t alignment = 1);
+
+	/**
+	 * Only the last allocation is actually released, other memory is reclaimed by Rewind or Reset
+	 */
+	void Free(void* memory);
+
+	FORCEINLINE SMark GetMark() const
+	{
+		return {m_CurrentChunk, m_Cursor};
+	}
+
+	/**
+	 * Release everything allocated after the mark was taken. Chunks are kept for reuse
+	 */
+	void Rewind(const SMark& mark);
+
+	/**
+	 * Release all allocations in O(1). Chunks are kept for reuse
+	 */
+	void Reset();
+
+	/**
+	 * Free the chunks that are not used at the moment
+	 */
+	void Trim();
+
+	NODISCARD size_t GetUsedMemory() const;
+	NODISCARD size_t GetReservedMemory() const;
+};
+
+/**
+ * Allocator adapter that plugs an FMemArena into containers through their TAllocator parameter
+ */
+template<typename T>
+struct TArenaAllocator
+{
+	const static bool kCanAllocateMany = true;
+	const static size_t kInlineCount = 0;
+
+	using ElementType = T;
+
+	FMemArena* Arena = nullptr;
+
+	FORCEINLINE TArenaAllocator() = default;
+
+	explicit FORCEINLINE TArenaAllocator(FMemArena& arena) : Arena(&arena)
+	{
+	}
+
+	/**
+	 * Allows passing an arena allocator of a different element type, e.g. to a TMap which allocates tree nodes
+	 */
+	template<typename U>
+	explicit FORCEINLINE TArenaAllocator(const TArenaAllocator<U>& other) : Arena(other.Arena)
+	{
+	}
+
+	FORCEINLINE T* Alloc(const size_t n, const size_t alignment = 1)
+	{
+		check(Arena);
+		return (T*)Arena->Alloc(sizeof(T) * n, alignment > alignof(T) ? alignment : alignof(T));
+	}
+
+	FORCEINLINE T* ReAlloc(T* obj, const size_t n, const size_t alignment = 1)
+	{
+		check(Arena);
+		return (T*)Arena->ReAlloc(obj, sizeof(T) * n, alignment > alignof(T) ? alignment : alignof(T));
+	}
+
+	FORCEINLINE void Free(T* obj)
+	{
+		check(Arena);
+		Arena->Free(obj);
+	}
+
+	FORCEINLINE static constexpr bool IsInline(const T*)
+	{
+		return false;
+	}
+};
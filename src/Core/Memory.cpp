@@ -28,46 +28,174 @@
 #include <mimalloc.h>
 
 #ifdef PF_ENABLE_PROFILING
+/**
+ * Profiling counters are sharded: threads get a shard round robin on first use, so threads only contend when there
+ * are more of them than shards. Totals are aggregated on read
+ */
+constexpr uint kMemoryProfilingShardCount = 32;
+
+/**
+ * Size changes accumulate in the shard until they exceed this, then they are folded into the global size, which is
+ * what the peak is tracked on
+ */
+constexpr int64 kMemoryProfilingPublishThreshold = 64 * 1024;
+
+struct alignas(64) SMemoryProfilingShard
+{
+	std::atomic<int64> UnpublishedSize[(uint)EAllocationPurpose::Max]{};
+	std::atomic<uint64> AllocCount[(uint)EAllocationPurpose::Max]{};
+	std::atomic<uint64> FreeCount[(uint)EAllocationPurpose::Max]{};
+};
+
 static struct
 {
-	size_t PurposeMemorySize[(uint)EAllocationPurpose::Max]{};
+	SMemoryProfilingShard Shards[kMemoryProfilingShardCount];
+
+	alignas(64) std::atomic<int64> PublishedSize[(uint)EAllocationPurpose::Max]{};
+	std::atomic<int64> PeakSize[(uint)EAllocationPurpose::Max]{};
+	std::atomic<uint> NextShard{0};
 } gMemoryProfilingData;
+
+static thread_local uint64 gThreadAllocCount = 0;
+
+static FORCEINLINE void UpdatePeakSize(const uint purpose, const int64 size)
+{
+	std::atomic<int64>& peak = gMemoryProfilingData.PeakSize[purpose];
+	int64 currentPeak = peak.load(std::memory_order_relaxed);
+	while (size > currentPeak && !peak.compare_exchange_weak(currentPeak, size, std::memory_order_relaxed))
+	{
+	}
+}
+
+static FORCEINLINE SMemoryProfilingShard& GetMemoryProfilingShard()
+{
+	static thread_local SMemoryProfilingShard* tShard =
+		&gMemoryProfilingData.Shards[gMemoryProfilingData.NextShard.fetch_add(1, std::memory_order_relaxed) % kMemoryProfilingShardCount];
+	return *tShard;
+}
+
+static FORCEINLINE void ProfileMemory(const EAllocationPurpose purpose, const int64 sizeDelta, const uint allocCount, const uint freeCount)
+{
+	SMemoryProfilingShard& shard = GetMemoryProfilingShard();
+	const uint index = (uint)purpose;
+
+	if (allocCount)
+		shard.AllocCount[index].fetch_add(allocCount, std::memory_order_relaxed);
+	if (freeCount)
+		shard.FreeCount[index].fetch_add(freeCount, std::memory_order_relaxed);
+	gThreadAllocCount += allocCount;
+
+	const int64 unpublished = shard.UnpublishedSize[index].fetch_add(sizeDelta, std::memory_order_relaxed) + sizeDelta;
+	if (unpublished >= kMemoryProfilingPublishThreshold || unpublished <= -kMemoryProfilingPublishThreshold)
+	{
+		const int64 taken = shard.UnpublishedSize[index].exchange(0, std::memory_order_relaxed);
+		const int64 published = gMemoryProfilingData.PublishedSize[index].fetch_add(taken, std::memory_order_relaxed) + taken;
+		UpdatePeakSize(index, published);
+	}
+}
 #endif
 
 void* FMemory::Alloc(const size_t size, const size_t alignment, const EAllocationPurpose purpose)
 {
 #ifdef PF_ENABLE_PROFILING
-	gMemoryProfilingData.PurposeMemorySize[(uint)purpose] += mi_good_size(size);
-#endif
+	ProfileMemory(purpose, (int64)mi_good_size(size), 1, 0);
+	void* memory = mi_malloc_aligned(size, alignment);
+	FMemoryTracking::OnAlloc(memory, size, purpose);
+	return memory;
+#else
 	return mi_malloc_aligned(size, alignment);
+#endif
 }
 
 void* FMemory::ReAlloc(void* initialMemory, const size_t size, const size_t alignment, const EAllocationPurpose purpose)
 {
 #ifdef PF_ENABLE_PROFILING
-	gMemoryProfilingData.PurposeMemorySize[(uint)purpose] -= mi_usable_size(initialMemory);
-	gMemoryProfilingData.PurposeMemorySize[(uint)purpose] += mi_good_size(size);
-#endif
+	ProfileMemory(purpose, (int64)mi_good_size(size) - (int64)mi_usable_size(initialMemory), initialMemory ? 0 : 1, 0);
+	FMemoryTracking::OnFree(initialMemory); // before the block can be handed out again
+	void* memory = mi_realloc_aligned(initialMemory, size, alignment);
+	FMemoryTracking::OnAlloc(memory, size, purpose);
+	return memory;
+#else
 	return mi_realloc_aligned(initialMemory, size, alignment);
+#endif
 }
 
 void FMemory::Free(void* memory, EAllocationPurpose purpose)
 {
 #ifdef PF_ENABLE_PROFILING
-	gMemoryProfilingData.PurposeMemorySize[(uint)purpose] -= mi_usable_size(memory);
+	if (memory)
+	{
+		ProfileMemory(purpose, -(int64)mi_usable_size(memory), 0, 1);
+		FMemoryTracking::OnFree(memory); // before the block can be handed out again
+	}
 #endif
 	mi_free(memory);
 }
 
 size_t FMemory::GetPurposeMemory(EAllocationPurpose purpose)
+{
+	return GetPurposeStats(purpose).CurrentSize;
+}
+
+SMemoryPurposeStats FMemory::GetPurposeStats(EAllocationPurpose purpose)
+{
+	SMemoryPurposeStats stats;
+#ifdef PF_ENABLE_PROFILING
+	const uint index = (uint)purpose;
+	int64 size = gMemoryProfilingData.PublishedSize[index].load(std::memory_order_relaxed);
+	for (const SMemoryProfilingShard& shard : gMemoryProfilingData.Shards)
+	{
+		size += shard.UnpublishedSize[index].load(std::memory_order_relaxed);
+		stats.AllocCount += shard.AllocCount[index].load(std::memory_order_relaxed);
+		stats.FreeCount += shard.FreeCount[index].load(std::memory_order_relaxed);
+	}
+
+	// concurrent updates may be seen partially, clamp a transiently negative sum
+	stats.CurrentSize = size > 0 ? (size_t)size : 0;
+	UpdatePeakSize(index, (int64)stats.CurrentSize);
+	stats.PeakSize = (size_t)gMemoryProfilingData.PeakSize[index].load(std::memory_order_relaxed);
+#else
+	(void)purpose;
+#endif
+	return stats;
+}
+
+uint64 FMemory::GetThreadAllocCount()
 {
 #ifdef PF_ENABLE_PROFILING
-	return gMemoryProfilingData.PurposeMemorySize[(uint)purpose];
+	return gThreadAllocCount;
 #else
 	return 0;
 #endif
 }
 
+UnitTest(Memory_PoolAllocator)
+{
+	struct SNode
+	{
+		uint64 Data[3];
+	};
+
+	TPoolAllocator<SNode, 16> pool;
+	SNode* nodes[40];
+	for (SNode*& node : nodes)
+	{
+		node = pool.Alloc(1);
+	}
+	tcheck(pool.GetBlockCount() == 3);
+	tcheck(nodes[1] == nodes[0] + 1); // slots of a block are contiguous
+
+	pool.Free(nodes[5]);
+	pool.Free(nodes[20]);
+	tcheck(pool.Alloc(1) == nodes[20]); // freed slots are reused first, most recent first
+	tcheck(pool.Alloc(1) == nodes[5]);
+	tcheck(pool.GetBlockCount() == 3);
+
+	TPoolAllocator<SNode, 16> movedPool = std::move(pool);
+	tcheck(movedPool.GetBlockCount() == 3);
+	tcheck(pool.GetBlockCount() == 0);
+}
+
 void* operator new(const size_t size)
 {
 	return FMemory::Alloc(size);
@@ -87,3 +215,92 @@ void operator delete[](void* p) noexcept
 {
 	return FMemory::Free(p);
 }
+
+void operator delete(void* p, size_t) noexcept
+{
+	return FMemory::Free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	return FMemory::Free(p);
+}
+
+UnitTestExclusive(Memory_ProfilingCounters)
+{
+#ifdef PF_ENABLE_PROFILING
+	// a purpose of its own: std::thread allocates its state through the global operator new (General)
+	const SMemoryPurposeStats initialStats = FMemory::GetPurposeStats(EAllocationPurpose::InternalString);
+
+	constexpr uint kThreadCount = 8;
+	constexpr uint kIterations = 10000;
+	std::thread threads[kThreadCount];
+	for (std::thread& thread : threads)
+	{
+		thread = std::thread([]
+		{
+			void* blocks[16];
+			for (uint i = 0; i < kIterations; ++i)
+			{
+				void*& block = blocks[i % 16];
+				if (i >= 16)
+				{
+					FMemory::Free(block, EAllocationPurpose::InternalString);
+				}
+				block = FMemory::Alloc(64 + i % 512, 1, EAllocationPurpose::InternalString);
+			}
+			for (void* block : blocks)
+			{
+				FMemory::Free(block, EAllocationPurpose::InternalString);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	const SMemoryPurposeStats stats = FMemory::GetPurposeStats(EAllocationPurpose::InternalString);
+	tcheck(stats.AllocCount - initialStats.AllocCount == kThreadCount * kIterations);
+	tcheck(stats.FreeCount - initialStats.FreeCount == kThreadCount * kIterations);
+	tcheck(stats.CurrentSize == initialStats.CurrentSize); // every update accounted for, none lost to races
+	tcheck(stats.PeakSize >= initialStats.PeakSize);
+
+	void* big = FMemory::Alloc(1024 * 1024, 1, EAllocationPurpose::InternalString);
+	tcheck(FMemory::GetPurposeStats(EAllocationPurpose::InternalString).PeakSize >= initialStats.CurrentSize + 1024 * 1024);
+	FMemory::Free(big, EAllocationPurpose::InternalString);
+#endif
+}
+
+Benchmark(Memory_Churn)
+{
+	struct SBenchmarkNode
+	{
+		uint64 Data[4];
+	};
+
+	SBenchmarkNode* nodes[64] = {};
+	uint i = 0;
+	bench.Measure("FMemory", [&nodes, &i]
+	{
+		SBenchmarkNode*& node = nodes[i++ % 64];
+		FMemory::Free(node);
+		node = (SBenchmarkNode*)FMemory::Alloc(sizeof(SBenchmarkNode));
+	});
+	for (SBenchmarkNode*& node : nodes)
+	{
+		FMemory::Free(node);
+		node = nullptr;
+	}
+
+	TPoolAllocator<SBenchmarkNode, 64> pool;
+	bench.Measure("Pool", [&pool, &nodes, &i]
+	{
+		SBenchmarkNode*& node = nodes[i++ % 64];
+		if (node)
+		{
+			pool.Free(node);
+		}
+		node = pool.Alloc(1);
+	});
+}
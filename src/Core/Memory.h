@@ -33,17 +33,48 @@ enum class EAllocationPurpose : uint
 	Max
 };
 
+/**
+ * Allocation statistics of one EAllocationPurpose, only collected with PF_ENABLE_PROFILING
+ */
+struct SMemoryPurposeStats
+{
+	size_t CurrentSize = 0;
+
+	/**
+	 * Highest CurrentSize observed. Per-thread changes are published in batches (see Memory.cpp), so a peak may be
+	 * missed by up to kMemoryProfilingPublishThreshold per thread shard
+	 */
+	size_t PeakSize = 0;
+	uint64 AllocCount = 0;
+	uint64 FreeCount = 0;
+};
+
 struct FMemory
 {
-	static void* Alloc(size_t size, size_t alignment = 1, EAllocationPurpose purpose = EAllocationPurpose::General);
-	static void* ReAlloc(void* initialMemory, size_t size, size_t alignment = 1, EAllocationPurpose purpose = EAllocationPurpose::General);
+	// never inlined: allocation tracking skips a fixed number of frames to reach the caller, see FMemoryTracking
+	static NOINLINE void* Alloc(size_t size, size_t alignment = 1, EAllocationPurpose purpose = EAllocationPurpose::General);
+	static NOINLINE void* ReAlloc(void* initialMemory, size_t size, size_t alignment = 1, EAllocationPurpose purpose = EAllocationPurpose::General);
 	static void Free(void* memory, EAllocationPurpose purpose = EAllocationPurpose::General);
 	static size_t GetPurposeMemory(EAllocationPurpose purpose);
+	static SMemoryPurposeStats GetPurposeStats(EAllocationPurpose purpose);
+
+	/**
+	 * Allocations the calling thread made so far, any purpose. Always 0 without PF_ENABLE_PROFILING
+	 */
+	static uint64 GetThreadAllocCount();
 	
 	FORCEINLINE static void Copy(void* dst, void const* src, const size_t size)
 	{
 		memcpy(dst, src, size);
 	}
+
+	/**
+	 * Copy that allows overlapping source and destination
+	 */
+	FORCEINLINE static void Move(void* dst, void const* src, const size_t size)
+	{
+		memmove(dst, src, size);
+	}
 };
 
 template<typename T, EAllocationPurpose TPurpose = EAllocationPurpose::General, size_t TSize = sizeof(T)>
@@ -54,9 +85,18 @@ struct TRawAllocator
 	 */
 	const static bool kCanAllocateMany = true;
 
+	/**
+	 * Number of elements the allocator can store inside itself, without touching the heap
+	 */
+	const static size_t kInlineCount = 0;
+
+	using ElementType = T;
+
 	FORCEINLINE TRawAllocator() = default;
 	FORCEINLINE TRawAllocator(const TRawAllocator& other) = default; // no need to copy anything, it's a static allocator
 	FORCEINLINE TRawAllocator(TRawAllocator&& other) = default; // no need to move anything, it's a static allocator
+	FORCEINLINE TRawAllocator& operator=(const TRawAllocator& other) = default;
+	FORCEINLINE TRawAllocator& operator=(TRawAllocator&& other) = default;
 	
 	FORCEINLINE static T* Alloc(const size_t n, const size_t alignment = 1)
 	{
@@ -72,6 +112,280 @@ struct TRawAllocator
 	{
 		FMemory::Free(obj, TPurpose);
 	}
+
+	/**
+	 * Returns true if the memory lives inside the allocator object itself and can't be handed over to another allocator
+	 */
+	FORCEINLINE static constexpr bool IsInline(const T*)
+	{
+		return false;
+	}
+};
+
+/**
+ * Keeps up to N elements inside the allocator object and only spills to TFallback when a bigger block is requested.
+ * The inline block can be handed out to one owner at a time, the allocator is meant to be owned by a single container
+ */
+template<size_t N, typename TFallback>
+struct TInlineAllocator
+{
+	static_assert(N > 0, "TInlineAllocator requires at least one inline element");
+	static_assert(TFallback::kCanAllocateMany, "TInlineAllocator requires a fallback allocator with kCanAllocateMany");
+
+	const static bool kCanAllocateMany = true;
+	const static size_t kInlineCount = N;
+
+	using ElementType = typename TFallback::ElementType;
+	using T = ElementType;
+
+	TFallback Fallback;
+
+private:
+	alignas(T) uint8 m_InlineBuffer[N * sizeof(T)];
+	bool m_InlineUsed = false;
+
+	FORCEINLINE T* GetInline()
+	{
+		return (T*)m_InlineBuffer;
+	}
+
+public:
+	FORCEINLINE TInlineAllocator() = default;
+
+	// the inline block belongs to this instance: copies and moves only carry the fallback over
+	FORCEINLINE TInlineAllocator(const TInlineAllocator& other) : Fallback(other.Fallback)
+	{
+	}
+
+	FORCEINLINE TInlineAllocator(TInlineAllocator&& other) noexcept : Fallback(std::move(other.Fallback))
+	{
+	}
+
+	FORCEINLINE TInlineAllocator& operator=(const TInlineAllocator& other)
+	{
+		Fallback = other.Fallback;
+		return *this;
+	}
+
+	FORCEINLINE TInlineAllocator& operator=(TInlineAllocator&& other) noexcept
+	{
+		Fallback = std::move(other.Fallback);
+		return *this;
+	}
+
+	FORCEINLINE T* Alloc(const size_t n, const size_t alignment = 1)
+	{
+		if (n <= N && !m_InlineUsed && alignment <= alignof(T))
+		{
+			m_InlineUsed = true;
+			return GetInline();
+		}
+
+		return Fallback.Alloc(n, alignment);
+	}
+
+	FORCEINLINE T* ReAlloc(T* obj, const size_t n, const size_t alignment = 1)
+	{
+		if (IsInline(obj))
+		{
+			if (n <= N)
+			{
+				return obj;
+			}
+
+			T* res = Fallback.Alloc(n, alignment); // spill to the heap
+			FMemory::Copy(res, obj, N * sizeof(T));
+			m_InlineUsed = false;
+			return res;
+		}
+
+		if (n <= N && !m_InlineUsed && alignment <= alignof(T)) // fits back into the inline block
+		{
+			m_InlineUsed = true;
+			FMemory::Copy(GetInline(), obj, n * sizeof(T));
+			Fallback.Free(obj);
+			return GetInline();
+		}
+
+		return Fallback.ReAlloc(obj, n, alignment);
+	}
+
+	FORCEINLINE void Free(T* obj)
+	{
+		if (IsInline(obj))
+		{
+			m_InlineUsed = false;
+			return;
+		}
+
+		Fallback.Free(obj);
+	}
+
+	FORCEINLINE bool IsInline(const T* obj) const
+	{
+		return obj == (const T*)m_InlineBuffer;
+	}
+};
+
+/**
+ * Fixed-size allocator for node based containers. Elements are carved out of slab blocks of TBlockSize elements (or
+ * more, see Reserve) and freed slots are kept in an intrusive free list, so they are reused before the next block is
+ * allocated. Memory goes back to the heap only when the allocator is destroyed
+ */
+template<typename T, size_t TBlockSize = 64, EAllocationPurpose TPurpose = EAllocationPurpose::General>
+struct TPoolAllocator
+{
+	static_assert(TBlockSize > 0, "TPoolAllocator requires at least one element per block");
+
+	const static bool kCanAllocateMany = false;
+	const static size_t kInlineCount = 0;
+
+	using ElementType = T;
+
+private:
+	union USlot
+	{
+		USlot* NextFree;
+		alignas(T) uint8 Data[sizeof(T)];
+	};
+
+	/**
+	 * Header of a block, its slots follow
+	 */
+	struct alignas(USlot) SBlock
+	{
+		SBlock* Next;
+	};
+
+	SBlock* m_Blocks = nullptr;
+	USlot* m_FreeList = nullptr;
+
+	/**
+	 * Slots of the newest block that have never been handed out, starting at m_NextSlot
+	 */
+	USlot* m_NextSlot = nullptr;
+	size_t m_UnusedSlots = 0;
+
+	FORCEINLINE void AddBlock(const size_t slotCount)
+	{
+		SBlock* block = (SBlock*)FMemory::Alloc(sizeof(SBlock) + sizeof(USlot) * slotCount, alignof(SBlock), TPurpose);
+		block->Next = m_Blocks;
+		m_Blocks = block;
+		m_NextSlot = (USlot*)(block + 1);
+		m_UnusedSlots = slotCount;
+	}
+
+	FORCEINLINE void ReleaseBlocks()
+	{
+		while (m_Blocks)
+		{
+			SBlock* next = m_Blocks->Next;
+			FMemory::Free(m_Blocks, TPurpose);
+			m_Blocks = next;
+		}
+		m_FreeList = nullptr;
+		m_NextSlot = nullptr;
+		m_UnusedSlots = 0;
+	}
+
+public:
+	FORCEINLINE TPoolAllocator() = default;
+
+	// blocks can't be shared: a copy starts with an empty pool
+	FORCEINLINE TPoolAllocator(const TPoolAllocator&)
+	{
+	}
+
+	FORCEINLINE TPoolAllocator(TPoolAllocator&& other) noexcept : m_Blocks(other.m_Blocks), m_FreeList(other.m_FreeList),
+	                                                             m_NextSlot(other.m_NextSlot), m_UnusedSlots(other.m_UnusedSlots)
+	{
+		other.m_Blocks = nullptr;
+		other.m_FreeList = nullptr;
+		other.m_NextSlot = nullptr;
+		other.m_UnusedSlots = 0;
+	}
+
+	FORCEINLINE TPoolAllocator& operator=(const TPoolAllocator&)
+	{
+		return *this;
+	}
+
+	FORCEINLINE TPoolAllocator& operator=(TPoolAllocator&& other) noexcept
+	{
+		if (this != &other)
+		{
+			ReleaseBlocks();
+			m_Blocks = other.m_Blocks;
+			m_FreeList = other.m_FreeList;
+			m_NextSlot = other.m_NextSlot;
+			m_UnusedSlots = other.m_UnusedSlots;
+			other.m_Blocks = nullptr;
+			other.m_FreeList = nullptr;
+			other.m_NextSlot = nullptr;
+			other.m_UnusedSlots = 0;
+		}
+		return *this;
+	}
+
+	FORCEINLINE ~TPoolAllocator()
+	{
+		ReleaseBlocks();
+	}
+
+	FORCEINLINE T* Alloc(const size_t n, const size_t alignment = 1)
+	{
+		check(n == 1);
+		check(alignment <= alignof(USlot));
+
+		if (m_FreeList)
+		{
+			USlot* slot = m_FreeList;
+			m_FreeList = slot->NextFree;
+			return (T*)slot;
+		}
+
+		if (!m_UnusedSlots)
+		{
+			AddBlock(TBlockSize);
+		}
+
+		--m_UnusedSlots;
+		return (T*)m_NextSlot++;
+	}
+
+	/**
+	 * Make room for `count` more elements in one block, so that bulk construction allocates once and lays the elements
+	 * out in allocation order. Slots left in the current block are abandoned when a new block is needed
+	 */
+	FORCEINLINE void Reserve(const size_t count)
+	{
+		if (count > m_UnusedSlots)
+		{
+			AddBlock(count > TBlockSize ? count : TBlockSize);
+		}
+	}
+
+	FORCEINLINE void Free(T* obj)
+	{
+		USlot* slot = (USlot*)obj;
+		slot->NextFree = m_FreeList;
+		m_FreeList = slot;
+	}
+
+	FORCEINLINE static constexpr bool IsInline(const T*)
+	{
+		return false;
+	}
+
+	FORCEINLINE NODISCARD size_t GetBlockCount() const
+	{
+		size_t count = 0;
+		for (const SBlock* block = m_Blocks; block; block = block->Next)
+		{
+			++count;
+		}
+		return count;
+	}
 };
 
 #ifdef PF_UNIT_TEST
@@ -79,6 +393,9 @@ template<typename T, typename TAllocator = TRawAllocator<T>>
 struct TAllocatorMock
 {
 	const static bool kCanAllocateMany = TAllocator::kCanAllocateMany;
+	const static size_t kInlineCount = TAllocator::kInlineCount;
+
+	using ElementType = T;
 	
 	TAllocator Allocator;
 	
@@ -107,5 +424,10 @@ struct TAllocatorMock
 		++TotalCount;
 		Allocator.Free(obj);
 	}
+
+	FORCEINLINE bool IsInline(const T* obj) const
+	{
+		return Allocator.IsInline(obj);
+	}
 };
 #endif
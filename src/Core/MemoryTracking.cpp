@@ -0,0 +1,452 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+#include <mimalloc.h>
+
+#ifdef PF_ENABLE_PROFILING
+/**
+ * Side tables allocate straight from mimalloc: they must not be tracked themselves nor show up in FMemory statistics
+ */
+template <typename T>
+struct TUntrackedAllocator
+{
+	const static bool kCanAllocateMany = true;
+	const static size_t kInlineCount = 0;
+
+	using ElementType = T;
+
+	FORCEINLINE static T* Alloc(const size_t n, const size_t alignment = 1)
+	{
+		return (T*)mi_malloc_aligned(sizeof(T) * n, alignment > alignof(T) ? alignment : alignof(T));
+	}
+
+	FORCEINLINE static T* ReAlloc(T* obj, const size_t n, const size_t alignment = 1)
+	{
+		return (T*)mi_realloc_aligned(obj, sizeof(T) * n, alignment > alignof(T) ? alignment : alignof(T));
+	}
+
+	FORCEINLINE static void Free(T* obj)
+	{
+		mi_free(obj);
+	}
+
+	FORCEINLINE static constexpr bool IsInline(const T*)
+	{
+		return false;
+	}
+};
+
+struct SCallSiteEntry
+{
+	uint64 Hash;
+	void* Frames[SAllocationCallSite::kMaxFrames];
+	uint FrameCount;
+
+	std::atomic<uint64> AllocCount{0};
+	std::atomic<uint64> TotalSize{0};
+	std::atomic<uint64> LiveCount{0};
+	std::atomic<uint64> LiveSize{0};
+
+	SCallSiteEntry* Next; // list of all call sites, for lock-free reporting
+};
+
+struct SAllocationRecord
+{
+	SCallSiteEntry* CallSite;
+	size_t Size;
+	int64 Timestamp;
+	EAllocationPurpose Purpose;
+};
+
+constexpr uint kCallSiteShardCount = 16;
+constexpr uint kAllocationShardCount = 64;
+
+struct alignas(64) SCallSiteShard
+{
+	FSpinLock Lock;
+	THashMap<uint64, SCallSiteEntry*, FUtils::Hash<uint64>, FUtils::Equal<uint64>, TUntrackedAllocator<uint8>> CallSites;
+};
+
+struct alignas(64) SAllocationShard
+{
+	FSpinLock Lock;
+	THashMap<void*, SAllocationRecord, FUtils::Hash<void*>, FUtils::Equal<void*>, TUntrackedAllocator<uint8>> Records;
+};
+
+static std::atomic<bool> gAllocationTrackingEnabled{false};
+
+/**
+ * Set once tracking was enabled: frees keep untracking records after tracking is disabled again
+ */
+static std::atomic<bool> gAllocationTrackingUsed{false};
+
+static std::atomic<SCallSiteEntry*> gCallSiteList{nullptr};
+static SCallSiteShard gCallSiteShards[kCallSiteShardCount];
+static SAllocationShard gAllocationShards[kAllocationShardCount];
+
+static FORCEINLINE SAllocationShard& GetAllocationShard(const void* memory)
+{
+	return gAllocationShards[FUtils::MixHash((uint64)(size_t)memory) % kAllocationShardCount];
+}
+
+/**
+ * Never inlined, like its callers FMemoryTracking::OnAlloc and FMemory::Alloc (ReAlloc): the three frames skipped
+ * are those functions, the first frame kept is the allocating code
+ */
+static NOINLINE SCallSiteEntry* FindOrAddCallSite()
+{
+	void* frames[SAllocationCallSite::kMaxFrames];
+	const uint frameCount = ::RtlCaptureStackBackTrace(3, SAllocationCallSite::kMaxFrames, frames, nullptr);
+	const uint64 hash = FUtils::HashBytes(frames, sizeof(void*) * frameCount);
+
+	SCallSiteShard& shard = gCallSiteShards[hash % kCallSiteShardCount];
+	TScopeLock<FSpinLock> lock(shard.Lock);
+
+	SCallSiteEntry*& entry = shard.CallSites.FindOrAdd(hash, nullptr);
+	if (!entry)
+	{
+		entry = new(TUntrackedAllocator<SCallSiteEntry>::Alloc(1)) SCallSiteEntry();
+		entry->Hash = hash;
+		entry->FrameCount = frameCount;
+		FMemory::Copy(entry->Frames, frames, sizeof(void*) * frameCount);
+
+		entry->Next = gCallSiteList.load(std::memory_order_relaxed);
+		while (!gCallSiteList.compare_exchange_weak(entry->Next, entry, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+	}
+	return entry;
+}
+
+void FMemoryTracking::SetEnabled(const bool enabled)
+{
+	if (enabled)
+	{
+		gAllocationTrackingUsed.store(true, std::memory_order_relaxed);
+	}
+	gAllocationTrackingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool FMemoryTracking::IsEnabled()
+{
+	return gAllocationTrackingEnabled.load(std::memory_order_relaxed);
+}
+
+void FMemoryTracking::OnAlloc(void* memory, const size_t size, const EAllocationPurpose purpose)
+{
+	if (!memory || !gAllocationTrackingEnabled.load(std::memory_order_relaxed))return;
+
+	SCallSiteEntry* callSite = FindOrAddCallSite();
+	callSite->AllocCount.fetch_add(1, std::memory_order_relaxed);
+	callSite->TotalSize.fetch_add(size, std::memory_order_relaxed);
+	callSite->LiveCount.fetch_add(1, std::memory_order_relaxed);
+	callSite->LiveSize.fetch_add(size, std::memory_order_relaxed);
+
+	LARGE_INTEGER timestamp;
+	::QueryPerformanceCounter(&timestamp);
+
+	SAllocationShard& shard = GetAllocationShard(memory);
+	TScopeLock<FSpinLock> lock(shard.Lock);
+	shard.Records.InsertOrUpdate(memory, SAllocationRecord{callSite, size, timestamp.QuadPart, purpose});
+}
+
+void FMemoryTracking::OnFree(void* memory)
+{
+	if (!memory || !gAllocationTrackingUsed.load(std::memory_order_relaxed))return;
+
+	SAllocationShard& shard = GetAllocationShard(memory);
+	TScopeLock<FSpinLock> lock(shard.Lock);
+
+	const SAllocationRecord* record = shard.Records.Find(memory);
+	if (record) // allocations made while tracking was disabled have no record
+	{
+		record->CallSite->LiveCount.fetch_sub(1, std::memory_order_relaxed);
+		record->CallSite->LiveSize.fetch_sub(record->Size, std::memory_order_relaxed);
+		shard.Records.Remove(memory);
+	}
+}
+
+void FMemoryTracking::Reset()
+{
+	for (SAllocationShard& shard : gAllocationShards)
+	{
+		TScopeLock<FSpinLock> lock(shard.Lock);
+		shard.Records.Clear();
+	}
+
+	for (SCallSiteShard& shard : gCallSiteShards)
+	{
+		TScopeLock<FSpinLock> lock(shard.Lock);
+		shard.CallSites.Clear();
+	}
+
+	SCallSiteEntry* entry = gCallSiteList.exchange(nullptr);
+	while (entry)
+	{
+		SCallSiteEntry* next = entry->Next;
+		entry->~SCallSiteEntry();
+		TUntrackedAllocator<SCallSiteEntry>::Free(entry);
+		entry = next;
+	}
+}
+
+void FMemoryTracking::GetCallSites(TArray<SAllocationCallSite>& outCallSites)
+{
+	const size_t first = outCallSites.GetCount();
+	for (SCallSiteEntry* entry = gCallSiteList.load(std::memory_order_acquire); entry; entry = entry->Next)
+	{
+		SAllocationCallSite callSite;
+		callSite.Hash = entry->Hash;
+		callSite.FrameCount = entry->FrameCount;
+		FMemory::Copy(callSite.Frames, entry->Frames, sizeof(void*) * entry->FrameCount);
+		callSite.AllocCount = entry->AllocCount.load(std::memory_order_relaxed);
+		callSite.TotalSize = entry->TotalSize.load(std::memory_order_relaxed);
+		callSite.LiveCount = entry->LiveCount.load(std::memory_order_relaxed);
+		callSite.LiveSize = entry->LiveSize.load(std::memory_order_relaxed);
+		outCallSites.Add(callSite);
+	}
+
+	FAlgorithms::Sort(outCallSites.GetData() + first, outCallSites.GetData() + outCallSites.GetCount(),
+	                  [](const SAllocationCallSite& a, const SAllocationCallSite& b) { return a.TotalSize > b.TotalSize; });
+}
+
+void FMemoryTracking::GetLiveAllocations(TArray<SLiveAllocation>& outAllocations, const size_t maxCount)
+{
+	// allocating while holding a shard lock could deadlock on the same shard: count first, reserve, then copy
+	size_t count = 0;
+	for (SAllocationShard& shard : gAllocationShards)
+	{
+		TScopeLock<FSpinLock> lock(shard.Lock);
+		count += shard.Records.GetCount();
+	}
+
+	TArray<SLiveAllocation> allocations;
+	allocations.Reserve(count + 64); // slack for allocations made in between
+	for (SAllocationShard& shard : gAllocationShards)
+	{
+		TScopeLock<FSpinLock> lock(shard.Lock);
+		for (TPair<void*, SAllocationRecord>& record : shard.Records)
+		{
+			if (allocations.GetCount() == count + 64)break;
+			allocations.Add(SLiveAllocation{record.First, record.Second.Size, record.Second.Timestamp, record.Second.CallSite->Hash, record.Second.Purpose});
+		}
+	}
+
+	FAlgorithms::Sort(allocations.GetData(), allocations.GetData() + allocations.GetCount(),
+	                  [](const SLiveAllocation& a, const SLiveAllocation& b) { return a.Timestamp < b.Timestamp; });
+
+	for (size_t i = 0; i < allocations.GetCount() && i < maxCount; ++i)
+	{
+		outAllocations.Add(allocations[i]);
+	}
+}
+
+static void WriteCallStack(FString& out, const SAllocationCallSite& callSite)
+{
+	for (uint i = 0; i < callSite.FrameCount; ++i)
+	{
+		FFormat::Append(out, "        {}\r\n", callSite.Frames[i]);
+	}
+}
+
+void FMemoryTracking::WriteReport(FString& out, const uint maxCallSites, const uint maxAllocations)
+{
+	TArray<SAllocationCallSite> callSites;
+	GetCallSites(callSites);
+
+	FFormat::Append(out, "[Allocation hotspots] {} call sites, by total size\r\n", callSites.GetCount());
+	for (size_t i = 0; i < callSites.GetCount() && i < maxCallSites; ++i)
+	{
+		const SAllocationCallSite& callSite = callSites[i];
+		FFormat::Append(out, "    #{:<3} {:>12} bytes in {:>8} allocations, {} bytes in {} still alive (stack {:016x})\r\n", i + 1,
+		                callSite.TotalSize, callSite.AllocCount, callSite.LiveSize, callSite.LiveCount, callSite.Hash);
+		WriteCallStack(out, callSite);
+	}
+
+	FAlgorithms::Sort(callSites.GetData(), callSites.GetData() + callSites.GetCount(),
+	                  [](const SAllocationCallSite& a, const SAllocationCallSite& b) { return a.LiveSize > b.LiveSize; });
+
+	uint64 liveSize = 0;
+	uint64 liveCount = 0;
+	for (const SAllocationCallSite& callSite : callSites)
+	{
+		liveSize += callSite.LiveSize;
+		liveCount += callSite.LiveCount;
+	}
+
+	FFormat::Append(out, "[Live allocations] {} bytes in {} allocations, by call site\r\n", liveSize, liveCount);
+	for (size_t i = 0; i < callSites.GetCount() && i < maxCallSites && callSites[i].LiveCount; ++i)
+	{
+		const SAllocationCallSite& callSite = callSites[i];
+		FFormat::Append(out, "    {:>12} bytes in {:>8} allocations (stack {:016x})\r\n", callSite.LiveSize, callSite.LiveCount, callSite.Hash);
+	}
+
+	TArray<SLiveAllocation> allocations;
+	GetLiveAllocations(allocations, maxAllocations);
+
+	LARGE_INTEGER now;
+	LARGE_INTEGER frequency;
+	::QueryPerformanceCounter(&now);
+	::QueryPerformanceFrequency(&frequency);
+
+	FFormat::Append(out, "[Oldest live allocations]\r\n");
+	for (const SLiveAllocation& allocation : allocations)
+	{
+		FFormat::Append(out, "    {} {:>10} bytes, alive for {:.3f} s (stack {:016x})\r\n", allocation.Memory, allocation.Size,
+		                (double)(now.QuadPart - allocation.Timestamp) / (double)frequency.QuadPart, allocation.CallSiteHash);
+	}
+}
+#else
+void FMemoryTracking::SetEnabled(bool)
+{
+}
+
+bool FMemoryTracking::IsEnabled()
+{
+	return false;
+}
+
+void FMemoryTracking::Reset()
+{
+}
+
+void FMemoryTracking::GetCallSites(TArray<SAllocationCallSite>&)
+{
+}
+
+void FMemoryTracking::GetLiveAllocations(TArray<SLiveAllocation>&, size_t)
+{
+}
+
+void FMemoryTracking::WriteReport(FString& out, uint, uint)
+{
+	out.Append("[Allocation tracking] requires PF_ENABLE_PROFILING\r\n");
+}
+
+void FMemoryTracking::OnAlloc(void*, size_t, EAllocationPurpose)
+{
+}
+
+void FMemoryTracking::OnFree(void*)
+{
+}
+#endif
+
+#ifdef PF_ENABLE_PROFILING
+/**
+ * An address inside AllocateForTrackingTest. Taking the address of the function could give an incremental linking
+ * thunk instead
+ */
+static void* gTrackingTestCode = nullptr;
+
+static NOINLINE void* AllocateForTrackingTest(const size_t size)
+{
+	::RtlCaptureStackBackTrace(0, 1, &gTrackingTestCode, nullptr);
+	void* memory = FMemory::Alloc(size);
+	FBenchmark::DoNotOptimize(memory); // no tail call: this frame must be on the stack
+	return memory;
+}
+
+UnitTestExclusive(MemoryTracking_Basic)
+{
+	FMemoryTracking::Reset();
+	FMemoryTracking::SetEnabled(true);
+
+	void* leaked = AllocateForTrackingTest(2000);
+	void* freed[10];
+	for (void*& memory : freed)
+	{
+		memory = AllocateForTrackingTest(100);
+	}
+	for (void* memory : freed)
+	{
+		FMemory::Free(memory);
+	}
+
+	FMemoryTracking::SetEnabled(false);
+
+	TArray<SAllocationCallSite> callSites;
+	FMemoryTracking::GetCallSites(callSites);
+
+	tverify(callSites.GetCount() == 2); // the stacks differ in the return address inside the test body
+
+	const SAllocationCallSite& hotspot = callSites[0];
+	tcheck(hotspot.AllocCount == 1);
+	tcheck(hotspot.TotalSize == 2000);
+	tcheck(hotspot.LiveCount == 1);
+	tcheck(hotspot.LiveSize == 2000);
+
+	tcheck(callSites[1].AllocCount == 10);
+	tcheck(callSites[1].TotalSize == 1000);
+	tcheck(callSites[1].LiveCount == 0);
+
+	// the first frame kept is the allocating function, not a tracking frame nor the caller of the allocating function
+	const size_t distance = (size_t)((uint8*)hotspot.Frames[0] - (uint8*)gTrackingTestCode);
+	tcheck(hotspot.FrameCount > 0 && distance < 256);
+
+	TArray<SLiveAllocation> allocations;
+	FMemoryTracking::GetLiveAllocations(allocations);
+	tverify(allocations.GetCount() == 1);
+	tcheck(allocations[0].Memory == leaked);
+	tcheck(allocations[0].Size == 2000);
+	tcheck(allocations[0].CallSiteHash == hotspot.Hash);
+
+	FMemory::Free(leaked); // untracked even though tracking is disabled now
+	allocations.Clear();
+	FMemoryTracking::GetLiveAllocations(allocations);
+	tcheck(allocations.GetCount() == 0);
+
+	FString report;
+	FMemoryTracking::WriteReport(report);
+	tcheck(report.Find("[Allocation hotspots]") == 0);
+
+	FMemoryTracking::Reset();
+}
+
+Benchmark(MemoryTracking_Overhead)
+{
+	void* blocks[64] = {};
+	uint i = 0;
+	const auto churn = [&blocks, &i]
+	{
+		void*& block = blocks[i++ % 64];
+		FMemory::Free(block);
+		block = FMemory::Alloc(32 + i % 64);
+	};
+
+	const bool wasEnabled = FMemoryTracking::IsEnabled();
+	FMemoryTracking::SetEnabled(false);
+	bench.Measure("Disabled", churn);
+	FMemoryTracking::SetEnabled(true);
+	bench.Measure("Enabled", churn);
+	FMemoryTracking::SetEnabled(wasEnabled);
+
+	for (void* block : blocks)
+	{
+		FMemory::Free(block);
+	}
+}
+#endif
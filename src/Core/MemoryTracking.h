@@ -0,0 +1,91 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Cumulative statistics of one allocating call stack
+ */
+struct SAllocationCallSite
+{
+	static constexpr uint kMaxFrames = 8;
+
+	uint64 Hash = 0;
+	void* Frames[kMaxFrames]{};
+	uint FrameCount = 0;
+
+	uint64 AllocCount = 0;
+	uint64 TotalSize = 0;
+	uint64 LiveCount = 0;
+	uint64 LiveSize = 0;
+};
+
+/**
+ * An allocation that has not been freed yet
+ */
+struct SLiveAllocation
+{
+	void* Memory;
+	size_t Size;
+	int64 Timestamp; // QueryPerformanceCounter ticks
+	uint64 CallSiteHash;
+	EAllocationPurpose Purpose;
+};
+
+/**
+ * Opt-in allocation tracking, available with PF_ENABLE_PROFILING.
+ * While enabled, every FMemory allocation records its call stack, size and time in side tables that bypass FMemory.
+ * Reports list the call sites that allocate the most and the allocations that are still alive.
+ * Costs a stack capture and two short spin-locked hash map updates per allocation, nothing beyond an atomic load when
+ * disabled
+ */
+struct FMemoryTracking
+{
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+
+	/**
+	 * Forget all records and call sites. Must not race with allocations
+	 */
+	static void Reset();
+
+	/**
+	 * Appends call sites sorted by total allocated size, largest first
+	 */
+	static void GetCallSites(TArray<SAllocationCallSite>& outCallSites);
+
+	/**
+	 * Appends up to `maxCount` live allocations, oldest first
+	 */
+	static void GetLiveAllocations(TArray<SLiveAllocation>& outAllocations, size_t maxCount = (size_t)-1);
+
+	/**
+	 * Human readable hotspot and leak report
+	 */
+	static void WriteReport(FString& out, uint maxCallSites = 16, uint maxAllocations = 16);
+
+	// hooks called by FMemory. OnAlloc is never inlined so that the stack above it has a fixed depth
+	static NOINLINE void OnAlloc(void* memory, size_t size, EAllocationPurpose purpose);
+	static void OnFree(void* memory);
+};
@@ -0,0 +1,196 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+UnitTestExclusive(ParallelAlgorithms_Sort)
+{
+	FJobSystem::Initialize(4);
+
+	TArray<uint> values;
+	TArray<uint> expected;
+	uint seed = 777;
+	for (uint i = 0; i < 200000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		values.Add(seed >> 4);
+	}
+	expected = values;
+
+	FAlgorithms::Sort(expected);
+	FAlgorithms::ParallelSort(values);
+	tcheck(memcmp(values.GetData(), expected.GetData(), values.GetCount() * sizeof(uint)) == 0);
+
+	FAlgorithms::ParallelSort(values.GetData(), values.GetData() + values.GetCount(), [](uint a, uint b) { return a > b; });
+	tcheck(values[0] == expected[expected.GetCount() - 1]);
+	tcheck(FAlgorithms::IsSorted(values.GetData(), values.GetData() + values.GetCount(), [](uint a, uint b) { return a > b; }));
+
+	// stability over keys with many duplicates, the second member is the original position
+	TArray<TPair<uint, uint>> pairs;
+	for (uint i = 0; i < 100000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		pairs.Add(TPair<uint, uint>((seed >> 8) % 100, i));
+	}
+	FAlgorithms::ParallelStableSort(pairs.GetData(), pairs.GetData() + pairs.GetCount(),
+	                                [](const TPair<uint, uint>& a, const TPair<uint, uint>& b) { return a.First < b.First; });
+
+	bool stable = true;
+	for (size_t i = 1; i < pairs.GetCount(); ++i)
+	{
+		stable &= pairs[i - 1].First < pairs[i].First || (pairs[i - 1].First == pairs[i].First && pairs[i - 1].Second < pairs[i].Second);
+	}
+	tcheck(stable);
+
+	// non-trivial elements go through the constructed merge buffer
+	TArray<FString> strings;
+	for (uint i = 0; i < 30000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		FString string;
+		FFormat::Append(string, "{} a suffix long enough for the heap", seed % 5000);
+		strings.Add(std::move(string));
+	}
+	FAlgorithms::ParallelSort(strings);
+	tcheck(FAlgorithms::IsSorted(strings.GetData(), strings.GetData() + strings.GetCount()));
+	tcheck(strings.GetCount() == 30000);
+
+	FJobSystem::Shutdown();
+}
+
+UnitTestExclusive(ParallelAlgorithms_TransformReduceScan)
+{
+	FJobSystem::Initialize(4);
+
+	TArray<uint64> values;
+	values.Resize(100000);
+	for (size_t i = 0; i < values.GetCount(); ++i)
+	{
+		values[i] = i;
+	}
+
+	FAlgorithms::ParallelTransform(values.GetData(), values.GetData() + values.GetCount(), values.GetData(), [](uint64 v) { return v * 3; });
+	tcheck(values[99999] == 99999 * 3);
+
+	const uint64 sum = FAlgorithms::ParallelReduce(values.GetData(), values.GetData() + values.GetCount(), (uint64)0,
+	                                               [](uint64 a, uint64 b) { return a + b; });
+	tcheck(sum == 3ull * 99999 * 100000 / 2);
+
+	const uint64 smallSum = FAlgorithms::ParallelReduce(values.GetData(), values.GetData() + 10, (uint64)0, [](uint64 a, uint64 b) { return a + b; });
+	tcheck(smallSum == 3 * 45);
+
+	TArray<uint64> inclusive;
+	inclusive.Resize(values.GetCount());
+	FAlgorithms::ParallelInclusiveScan(values.GetData(), values.GetData() + values.GetCount(), inclusive.GetData(),
+	                                   [](uint64 a, uint64 b) { return a + b; });
+
+	// in place
+	FAlgorithms::ParallelExclusiveScan(values.GetData(), values.GetData() + values.GetCount(), values.GetData(), (uint64)5,
+	                                   [](uint64 a, uint64 b) { return a + b; });
+
+	bool valid = true;
+	for (uint64 i = 0; i < values.GetCount(); ++i)
+	{
+		valid &= inclusive[i] == 3 * i * (i + 1) / 2;
+		valid &= values[i] == 5 + 3 * i * (i - 1) / 2;
+	}
+	tcheck(valid);
+
+	FJobSystem::Shutdown();
+}
+
+UnitTestExclusive(ParallelAlgorithms_Partition)
+{
+	FJobSystem::Initialize(4);
+
+	TArray<uint> values;
+	for (uint i = 0; i < 100000; ++i)
+	{
+		values.Add(i);
+	}
+
+	uint* const first = values.GetData();
+	uint* const last = first + values.GetCount();
+	uint* const cut = FAlgorithms::ParallelStablePartition(first, last, [](uint v) { return v % 3 == 0; });
+	tcheck(cut - first == 33334);
+
+	bool valid = true;
+	for (uint* i = first; i < last; ++i)
+	{
+		valid &= (i < cut) == (*i % 3 == 0);
+		valid &= i + 1 == cut || i + 1 == last || *i < *(i + 1); // order kept within both groups
+	}
+	tcheck(valid);
+
+	FJobSystem::Shutdown();
+}
+
+Benchmark(ParallelAlgorithms_Sort)
+{
+	FJobSystem::Initialize();
+
+	// the 100M inputs take about 1.2 GB with the sorted copy and the radix sort scratch buffer
+	const char* sizeNames[] = {"1M", "10M", "100M"};
+	const uint sizes[] = {1000000, 10000000, 100000000};
+	for (uint size = 0; size < 3; ++size)
+	{
+		TArray<uint> input;
+		input.Reserve(sizes[size]);
+		uint seed = 777;
+		for (uint i = 0; i < sizes[size]; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			input.Add(seed);
+		}
+
+		// every iteration sorts a fresh copy, the copy is part of the time
+		TArray<uint> values;
+		char variant[32];
+		FFormat::ToBuffer(variant, sizeof(variant), "Sort/{}", sizeNames[size]);
+		bench.Measure(variant, [&input, &values]
+		{
+			values = input;
+			FAlgorithms::Sort(values);
+		});
+		FFormat::ToBuffer(variant, sizeof(variant), "ParallelSort/{}", sizeNames[size]);
+		bench.Measure(variant, [&input, &values]
+		{
+			values = input;
+			FAlgorithms::ParallelSort(values);
+		});
+		FFormat::ToBuffer(variant, sizeof(variant), "RadixSort/{}", sizeNames[size]);
+		bench.Measure(variant, [&input, &values]
+		{
+			values = input;
+			FAlgorithms::RadixSort(values);
+		});
+		FFormat::ToBuffer(variant, sizeof(variant), "Copy/{}", sizeNames[size]);
+		bench.Measure(variant, [&input, &values]
+		{
+			values = input;
+		});
+	}
+
+	FJobSystem::Shutdown();
+}
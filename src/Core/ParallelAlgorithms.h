@@ -0,0 +1,472 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Parallel versions of the FAlgorithms building blocks, running on FJobSystem. Small ranges, calls from threads that
+ * are not job system workers and job systems with a single worker take the serial path
+ */
+namespace FAlgorithms
+{
+	/**
+	 * Ranges shorter than this are processed serially, splitting them costs more than it saves
+	 */
+	constexpr size_t kParallelThreshold = 16 * 1024;
+
+	FORCEINLINE bool ShouldRunParallel(const size_t count)
+	{
+		return count >= kParallelThreshold && FJobSystem::GetWorkerCount() > 1 && FJobSystem::GetCurrentWorkerIndex() >= 0;
+	}
+
+	/**
+	 * Number of elements per job: a few jobs per worker for load balancing, but at least `minBatchSize`
+	 */
+	FORCEINLINE size_t GetParallelBatchSize(const size_t count, const size_t minBatchSize = 4096)
+	{
+		const size_t batches = (size_t)FJobSystem::GetWorkerCount() * 4;
+		const size_t batchSize = (count + batches - 1) / batches;
+		return batchSize > minBatchSize ? batchSize : minBatchSize;
+	}
+
+	/**
+	 * out[i] = function(first[i]). `out` may be `first`
+	 */
+	template <typename TIn, typename TOut, typename F>
+	void ParallelTransform(TIn* first, TIn* last, TOut* out, F function)
+	{
+		const size_t count = last - first;
+		if (!ShouldRunParallel(count))
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				out[i] = function(first[i]);
+			}
+			return;
+		}
+
+		FJobSystem::ParallelFor(count, GetParallelBatchSize(count), [first, out, &function](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				out[i] = function(first[i]);
+			}
+		});
+	}
+
+	/**
+	 * Fold the range with `operation`, which must be associative. Every batch starts from `identity` and the batch
+	 * results are combined in order, so `identity` must not change the result (0 for a sum, 1 for a product)
+	 */
+	template <typename T, typename TResult, typename TOperation>
+	TResult ParallelReduce(const T* first, const T* last, const TResult& identity, TOperation operation)
+	{
+		const size_t count = last - first;
+		if (!ShouldRunParallel(count))
+		{
+			TResult result = identity;
+			for (const T* i = first; i < last; ++i)
+			{
+				result = operation(result, *i);
+			}
+			return result;
+		}
+
+		const size_t batchSize = GetParallelBatchSize(count);
+		TArray<TResult> partials;
+		partials.Resize((count + batchSize - 1) / batchSize, identity);
+
+		FJobSystem::ParallelFor(count, batchSize, [first, batchSize, &partials, &operation](const size_t begin, const size_t end)
+		{
+			TResult& partial = partials[begin / batchSize];
+			for (size_t i = begin; i < end; ++i)
+			{
+				partial = operation(partial, first[i]);
+			}
+		});
+
+		TResult result = partials[0];
+		for (size_t i = 1; i < partials.GetCount(); ++i)
+		{
+			result = operation(result, partials[i]);
+		}
+		return result;
+	}
+
+	/**
+	 * Two pass scan: every batch is reduced, the batch totals are scanned serially, then every batch is scanned
+	 * again starting from the total of the batches before it. Stores the inclusive scan of batch totals in `partials`
+	 */
+	template <typename T, typename TOperation, typename F>
+	void ParallelScanBatches(const T* first, const size_t count, TArray<T>& partials, TOperation& operation, const F& scanBatch)
+	{
+		const size_t batchSize = GetParallelBatchSize(count);
+		partials.Resize((count + batchSize - 1) / batchSize, first[0]);
+
+		FJobSystem::ParallelFor(count, batchSize, [first, batchSize, &partials, &operation](const size_t begin, const size_t end)
+		{
+			T total = first[begin];
+			for (size_t i = begin + 1; i < end; ++i)
+			{
+				total = operation(total, first[i]);
+			}
+			partials[begin / batchSize] = std::move(total);
+		});
+
+		for (size_t i = 1; i < partials.GetCount(); ++i)
+		{
+			partials[i] = operation(partials[i - 1], partials[i]);
+		}
+
+		FJobSystem::ParallelFor(count, batchSize, [batchSize, &scanBatch](const size_t begin, const size_t end)
+		{
+			scanBatch(begin, end, begin / batchSize);
+		});
+	}
+
+	/**
+	 * out[i] = first[0] op ... op first[i]. `operation` must be associative, `out` may be `first`
+	 */
+	template <typename T, typename TOperation>
+	void ParallelInclusiveScan(const T* first, const T* last, T* out, TOperation operation)
+	{
+		const size_t count = last - first;
+		if (!count)return;
+
+		if (!ShouldRunParallel(count))
+		{
+			T total = first[0];
+			out[0] = total;
+			for (size_t i = 1; i < count; ++i)
+			{
+				total = operation(total, first[i]);
+				out[i] = total;
+			}
+			return;
+		}
+
+		TArray<T> partials;
+		ParallelScanBatches(first, count, partials, operation, [first, out, &partials, &operation](const size_t begin, const size_t end, const size_t batch)
+		{
+			T total = batch ? operation(partials[batch - 1], first[begin]) : first[begin];
+			out[begin] = total;
+			for (size_t i = begin + 1; i < end; ++i)
+			{
+				total = operation(total, first[i]);
+				out[i] = total;
+			}
+		});
+	}
+
+	/**
+	 * out[i] = init op first[0] op ... op first[i - 1]. `operation` must be associative, `out` may be `first`
+	 */
+	template <typename T, typename TOperation>
+	void ParallelExclusiveScan(const T* first, const T* last, T* out, const T& init, TOperation operation)
+	{
+		const size_t count = last - first;
+		if (!count)return;
+
+		if (!ShouldRunParallel(count))
+		{
+			T total = init;
+			for (size_t i = 0; i < count; ++i)
+			{
+				T next = operation(total, first[i]); // read before writing: out may alias first
+				out[i] = std::move(total);
+				total = std::move(next);
+			}
+			return;
+		}
+
+		TArray<T> partials;
+		ParallelScanBatches(first, count, partials, operation, [first, out, &init, &partials, &operation](const size_t begin, const size_t end, const size_t batch)
+		{
+			T total = batch ? operation(init, partials[batch - 1]) : init;
+			for (size_t i = begin; i < end; ++i)
+			{
+				T next = operation(total, first[i]);
+				out[i] = std::move(total);
+				total = std::move(next);
+			}
+		});
+	}
+
+	/**
+	 * Parallel StablePartition. `predicate` is called twice per element and must not depend on anything else.
+	 * Allocates a buffer of the range size
+	 */
+	template <typename T, typename TPredicate>
+	T* ParallelStablePartition(T* first, T* last, TPredicate predicate)
+	{
+		const size_t count = last - first;
+		if (!ShouldRunParallel(count))
+		{
+			return StablePartition(first, last, predicate);
+		}
+
+		const size_t batchSize = GetParallelBatchSize(count);
+		TArray<size_t> acceptedBefore; // per batch, then the exclusive scan of it
+		acceptedBefore.Resize((count + batchSize - 1) / batchSize, 0);
+
+		FJobSystem::ParallelFor(count, batchSize, [first, batchSize, &acceptedBefore, &predicate](const size_t begin, const size_t end)
+		{
+			size_t accepted = 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				accepted += predicate(first[i]) ? 1 : 0;
+			}
+			acceptedBefore[begin / batchSize] = accepted;
+		});
+
+		size_t acceptedCount = 0;
+		for (size_t& accepted : acceptedBefore)
+		{
+			const size_t batchAccepted = accepted;
+			accepted = acceptedCount;
+			acceptedCount += batchAccepted;
+		}
+
+		T* buffer = (T*)FMemory::Alloc(sizeof(T) * count, alignof(T));
+		FJobSystem::ParallelFor(count, batchSize, [first, buffer, batchSize, acceptedCount, &acceptedBefore, &predicate](const size_t begin, const size_t end)
+		{
+			const size_t accepted = acceptedBefore[begin / batchSize];
+			T* acceptedOut = buffer + accepted;
+			T* rejectedOut = buffer + acceptedCount + (begin - accepted);
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (predicate(first[i]))
+					new(acceptedOut++) T(std::move(first[i]));
+				else
+					new(rejectedOut++) T(std::move(first[i]));
+			}
+		});
+
+		FJobSystem::ParallelFor(count, batchSize, [first, buffer](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				first[i] = std::move(buffer[i]);
+				buffer[i].~T();
+			}
+		});
+		FMemory::Free(buffer);
+
+		return first + acceptedCount;
+	}
+
+	/**
+	 * Move `value` to `out`, which is raw memory if TConstruct
+	 */
+	template <bool TConstruct, typename T>
+	FORCEINLINE void MoveTo(T* out, T& value)
+	{
+		if constexpr (TConstruct)
+			new(out) T(std::move(value));
+		else
+			*out = std::move(value);
+	}
+
+	/**
+	 * Merge sorted [first1, last1) and [first2, last2) to `out`, equal elements are taken from the first range
+	 */
+	template <bool TConstruct, typename T, typename TCompare>
+	void MergeTo(T* first1, T* last1, T* first2, T* last2, T* out, TCompare& compare)
+	{
+		while (first1 < last1 && first2 < last2)
+		{
+			if (compare(*first2, *first1))
+				MoveTo<TConstruct>(out++, *first2++);
+			else
+				MoveTo<TConstruct>(out++, *first1++);
+		}
+
+		for (; first1 < last1; ++first1)
+		{
+			MoveTo<TConstruct>(out++, *first1);
+		}
+		for (; first2 < last2; ++first2)
+		{
+			MoveTo<TConstruct>(out++, *first2);
+		}
+	}
+
+	/**
+	 * Parallel MergeTo. The longer range is cut into even pieces and the matching cut points of the other range are
+	 * found by binary search, the pieces are merged independently
+	 */
+	template <bool TConstruct, typename T, typename TCompare>
+	void ParallelMergeTo(T* first1, T* last1, T* first2, T* last2, T* out, TCompare& compare)
+	{
+		const size_t count1 = last1 - first1;
+		const size_t count2 = last2 - first2;
+		if (!count1 || !count2 || !ShouldRunParallel(count1 + count2))
+		{
+			MergeTo<TConstruct>(first1, last1, first2, last2, out, compare);
+			return;
+		}
+
+		const size_t pieceSize = GetParallelBatchSize(count1 + count2);
+		const size_t pieceCount = (count1 + count2 + pieceSize - 1) / pieceSize;
+
+		// cut points are found before any element is moved out. Stability: a cut in the first range keeps equal
+		// elements of the second range after it (lower bound), a cut in the second range keeps equal elements of the
+		// first range before it (upper bound)
+		TArray<TPair<size_t, size_t>> cuts;
+		cuts.Resize(pieceCount + 1, TPair<size_t, size_t>(0, 0));
+		cuts[pieceCount] = TPair<size_t, size_t>(count1, count2);
+		for (size_t piece = 1; piece < pieceCount; ++piece)
+		{
+			if (count1 >= count2)
+			{
+				const size_t index1 = count1 * piece / pieceCount;
+				cuts[piece] = TPair<size_t, size_t>(index1, LowerBound(first2, last2, first1[index1], compare) - first2);
+			}
+			else
+			{
+				const size_t index2 = count2 * piece / pieceCount;
+				cuts[piece] = TPair<size_t, size_t>(UpperBound(first1, last1, first2[index2], compare) - first1, index2);
+			}
+		}
+
+		FJobSystem::ParallelFor(pieceCount, 1, [=, &cuts, &compare](const size_t begin, const size_t end)
+		{
+			for (size_t piece = begin; piece < end; ++piece)
+			{
+				const TPair<size_t, size_t>& from = cuts[piece];
+				const TPair<size_t, size_t>& to = cuts[piece + 1];
+				MergeTo<TConstruct>(first1 + from.First, first1 + to.First, first2 + from.Second, first2 + to.Second,
+				                    out + from.First + from.Second, compare);
+			}
+		});
+	}
+
+	/**
+	 * Merge adjacent sorted runs of `width` elements of `source` in pairs to `destination`
+	 */
+	template <bool TConstruct, typename T, typename TCompare>
+	void ParallelMergeRuns(T* source, T* destination, const size_t count, const size_t width, TCompare& compare)
+	{
+		const size_t pairCount = (count + 2 * width - 1) / (2 * width);
+		FJobSystem::ParallelFor(pairCount, 1, [=, &compare](const size_t begin, const size_t end)
+		{
+			for (size_t pair = begin; pair < end; ++pair)
+			{
+				const size_t start = pair * 2 * width;
+				const size_t mid = count - start > width ? start + width : count;
+				const size_t stop = count - start > 2 * width ? start + 2 * width : count;
+				ParallelMergeTo<TConstruct>(source + start, source + mid, source + mid, source + stop, destination + start, compare);
+			}
+		});
+	}
+
+	/**
+	 * Parallel merge sort: runs are sorted independently with `sortRun`, then merged in pairs, with each merge
+	 * split across workers too. Allocates a buffer of the range size
+	 */
+	template <typename T, typename TCompare, typename TSortRun>
+	void ParallelMergeSort(T* first, T* last, TCompare& compare, const TSortRun& sortRun)
+	{
+		const size_t count = last - first;
+		const size_t runSize = GetParallelBatchSize(count);
+		const size_t runCount = (count + runSize - 1) / runSize;
+
+		FJobSystem::ParallelFor(runCount, 1, [=, &sortRun](const size_t begin, const size_t end)
+		{
+			for (size_t run = begin; run < end; ++run)
+			{
+				const size_t start = run * runSize;
+				sortRun(first + start, first + (count - start > runSize ? start + runSize : count));
+			}
+		});
+
+		if (runCount < 2)return;
+
+		T* buffer = (T*)FMemory::Alloc(sizeof(T) * count, alignof(T));
+		ParallelMergeRuns<true>(first, buffer, count, runSize, compare); // constructs every buffer element
+
+		T* source = buffer;
+		T* destination = first;
+		for (size_t width = runSize * 2; width < count; width *= 2)
+		{
+			ParallelMergeRuns<false>(source, destination, count, width, compare);
+			FUtils::Swap(source, destination);
+		}
+
+		FJobSystem::ParallelFor(count, GetParallelBatchSize(count), [first, source, buffer](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (source != first)
+				{
+					first[i] = std::move(source[i]);
+				}
+				buffer[i].~T();
+			}
+		});
+		FMemory::Free(buffer);
+	}
+
+	/**
+	 * Parallel version of Sort. Not stable
+	 */
+	template <typename T, typename TCompare = FUtils::Less<T>>
+	void ParallelSort(T* first, T* last, TCompare compare = TCompare())
+	{
+		if (!ShouldRunParallel(last - first))
+		{
+			Sort(first, last, compare);
+			return;
+		}
+
+		ParallelMergeSort(first, last, compare, [&compare](T* runFirst, T* runLast) { Sort(runFirst, runLast, compare); });
+	}
+
+	template <typename TContainer, typename TCompare = FUtils::Less<typename std::remove_reference<decltype(*std::declval<TContainer&>().GetData())>::type>>
+	void ParallelSort(TContainer& container, TCompare compare = TCompare())
+	{
+		ParallelSort(container.GetData(), container.GetData() + container.GetCount(), compare);
+	}
+
+	/**
+	 * Parallel version of StableSort
+	 */
+	template <typename T, typename TCompare = FUtils::Less<T>>
+	void ParallelStableSort(T* first, T* last, TCompare compare = TCompare())
+	{
+		if (!ShouldRunParallel(last - first))
+		{
+			StableSort(first, last, compare);
+			return;
+		}
+
+		ParallelMergeSort(first, last, compare, [&compare](T* runFirst, T* runLast) { StableSort(runFirst, runLast, compare); });
+	}
+
+	template <typename TContainer, typename TCompare = FUtils::Less<typename std::remove_reference<decltype(*std::declval<TContainer&>().GetData())>::type>>
+	void ParallelStableSort(TContainer& container, TCompare compare = TCompare())
+	{
+		ParallelStableSort(container.GetData(), container.GetData() + container.GetCount(), compare);
+	}
+}
@@ -0,0 +1,514 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+std::atomic<bool> gProfilerEnabled{false};
+
+#ifdef PF_ENABLE_PROFILING
+constexpr uint kProfileChunkSize = 4096;
+
+struct SProfileEvent
+{
+	const char* Name;
+	uint64 Begin;
+	uint64 End;
+};
+
+struct SProfileChunk
+{
+	std::atomic<SProfileChunk*> Next{nullptr};
+	std::atomic<uint> Count{0}; // published with release after the event is written
+	SProfileEvent Events[kProfileChunkSize];
+};
+
+/**
+ * Zones recorded by one thread. Records are never freed: zones of threads that exited stay available to reports,
+ * the record is reused by a new thread after a Reset
+ */
+struct SProfileThread
+{
+	SProfileThread* Next = nullptr;
+	std::atomic<SProfileChunk*> FirstChunk{nullptr};
+	SProfileChunk* CurrentChunk = nullptr; // owner only
+	std::atomic<bool> Owned{true};
+	uint ThreadId = 0;
+	char Name[32]{};
+};
+
+static struct
+{
+	std::atomic<SProfileThread*> Threads{nullptr};
+
+	// timestamp counter calibration against QueryPerformanceCounter
+	uint64 BaseTimestamp = 0;
+	int64 BaseCounter = 0;
+} gProfiler;
+
+struct SProfileThreadSlot
+{
+	SProfileThread* Thread = nullptr;
+
+	~SProfileThreadSlot()
+	{
+		if (Thread)
+		{
+			Thread->Owned.store(false, std::memory_order_release);
+		}
+	}
+};
+
+static thread_local SProfileThreadSlot gProfileThreadSlot;
+
+static SProfileThread& GetProfileThread()
+{
+	if (gProfileThreadSlot.Thread)
+	{
+		return *gProfileThreadSlot.Thread;
+	}
+
+	SProfileThread* thread = gProfiler.Threads.load(std::memory_order_acquire);
+	for (; thread; thread = thread->Next)
+	{
+		bool owned = false;
+		if (!thread->Owned.load(std::memory_order_relaxed) && !thread->FirstChunk.load(std::memory_order_relaxed) &&
+			thread->Owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+		{
+			break;
+		}
+	}
+
+	if (!thread)
+	{
+		thread = new(FMemory::Alloc(sizeof(SProfileThread), alignof(SProfileThread))) SProfileThread();
+		SProfileThread* head = gProfiler.Threads.load(std::memory_order_relaxed);
+		do
+		{
+			thread->Next = head;
+		}
+		while (!gProfiler.Threads.compare_exchange_weak(head, thread, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	thread->CurrentChunk = nullptr;
+	thread->ThreadId = (uint)::GetCurrentThreadId();
+	thread->Name[0] = 0;
+	gProfileThreadSlot.Thread = thread;
+	return *thread;
+}
+
+static NOINLINE SProfileChunk* AddProfileChunk(SProfileThread& thread)
+{
+	SProfileChunk* chunk = new(FMemory::Alloc(sizeof(SProfileChunk), alignof(SProfileChunk))) SProfileChunk();
+	if (thread.CurrentChunk)
+	{
+		thread.CurrentChunk->Next.store(chunk, std::memory_order_release);
+	}
+	else
+	{
+		thread.FirstChunk.store(chunk, std::memory_order_release);
+	}
+	thread.CurrentChunk = chunk;
+	return chunk;
+}
+
+void FProfiler::RecordZone(const char* name, const uint64 begin, const uint64 end)
+{
+	SProfileThread& thread = GetProfileThread();
+	SProfileChunk* chunk = thread.CurrentChunk;
+	uint count = chunk ? chunk->Count.load(std::memory_order_relaxed) : kProfileChunkSize;
+	if (count == kProfileChunkSize)
+	{
+		chunk = AddProfileChunk(thread);
+		count = 0;
+	}
+
+	chunk->Events[count] = SProfileEvent{name, begin, end};
+	chunk->Count.store(count + 1, std::memory_order_release);
+}
+
+void FProfiler::SetEnabled(const bool enabled)
+{
+	if (enabled && !gProfiler.BaseTimestamp)
+	{
+		LARGE_INTEGER counter;
+		::QueryPerformanceCounter(&counter);
+		gProfiler.BaseCounter = counter.QuadPart;
+		gProfiler.BaseTimestamp = GetTimestamp();
+	}
+	gProfilerEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void FProfiler::Reset()
+{
+	for (SProfileThread* thread = gProfiler.Threads.load(std::memory_order_acquire); thread; thread = thread->Next)
+	{
+		SProfileChunk* chunk = thread->FirstChunk.load(std::memory_order_acquire);
+		while (chunk)
+		{
+			SProfileChunk* next = chunk->Next.load(std::memory_order_relaxed);
+			chunk->~SProfileChunk();
+			FMemory::Free(chunk);
+			chunk = next;
+		}
+		thread->FirstChunk.store(nullptr, std::memory_order_relaxed);
+		thread->CurrentChunk = nullptr;
+	}
+
+	gProfiler.BaseTimestamp = 0;
+	if (IsEnabled())
+	{
+		SetEnabled(true); // new time base
+	}
+}
+
+void FProfiler::SetThreadName(const FStringView name)
+{
+	SProfileThread& thread = GetProfileThread();
+	const size_t length = name.GetLength() < sizeof(thread.Name) - 1 ? name.GetLength() : sizeof(thread.Name) - 1;
+	FMemory::Copy(thread.Name, name.GetData(), length);
+	thread.Name[length] = 0;
+}
+
+/**
+ * Timestamp counter ticks per microsecond, measured against QueryPerformanceCounter since profiling was enabled.
+ * Waits until at least 10ms passed for a stable ratio
+ */
+static double GetTicksPerMicrosecond()
+{
+	LARGE_INTEGER frequency;
+	::QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	uint64 timestamp;
+	do
+	{
+		::QueryPerformanceCounter(&counter);
+		timestamp = FProfiler::GetTimestamp();
+	}
+	while ((counter.QuadPart - gProfiler.BaseCounter) * 100 < frequency.QuadPart);
+
+	const double elapsedUs = (double)(counter.QuadPart - gProfiler.BaseCounter) * 1000000.0 / (double)frequency.QuadPart;
+	return (double)(timestamp - gProfiler.BaseTimestamp) / elapsedUs;
+}
+
+/**
+ * Snapshot of the zones recorded by one thread so far
+ */
+static void CollectProfileEvents(const SProfileThread& thread, TArray<SProfileEvent>& outEvents)
+{
+	for (SProfileChunk* chunk = thread.FirstChunk.load(std::memory_order_acquire); chunk; chunk = chunk->Next.load(std::memory_order_acquire))
+	{
+		const uint count = chunk->Count.load(std::memory_order_acquire);
+		for (uint i = 0; i < count; ++i)
+		{
+			outEvents.Add(chunk->Events[i]);
+		}
+	}
+}
+
+void FProfiler::GetZoneStats(TArray<SProfileZoneStats>& outStats)
+{
+	if (!gProfiler.BaseTimestamp)return;
+
+	const double ticksPerMs = GetTicksPerMicrosecond() * 1000.0;
+
+	TArray<SProfileZoneStats> stats;
+	THashMap<const char*, size_t> statsIndices;
+	TArray<SProfileEvent> events;
+	TArray<uint64> childTicks;
+	TArray<size_t> stack;
+
+	for (SProfileThread* thread = gProfiler.Threads.load(std::memory_order_acquire); thread; thread = thread->Next)
+	{
+		events.Resize(0);
+		CollectProfileEvents(*thread, events);
+
+		// outer zones first: the zone on top of the stack is the innermost one still open
+		FAlgorithms::Sort(events.GetData(), events.GetData() + events.GetCount(), [](const SProfileEvent& a, const SProfileEvent& b)
+		{
+			return a.Begin < b.Begin || (a.Begin == b.Begin && a.End > b.End);
+		});
+
+		childTicks.Resize(0);
+		childTicks.Resize(events.GetCount(), 0);
+		stack.Resize(0);
+		for (size_t i = 0; i < events.GetCount(); ++i)
+		{
+			while (stack.GetCount() && events[stack[stack.GetCount() - 1]].End <= events[i].Begin)
+			{
+				stack.RemoveAt(stack.GetCount() - 1);
+			}
+			if (stack.GetCount())
+			{
+				childTicks[stack[stack.GetCount() - 1]] += events[i].End - events[i].Begin;
+			}
+			stack.Add(i);
+		}
+
+		for (size_t i = 0; i < events.GetCount(); ++i)
+		{
+			const SProfileEvent& event = events[i];
+			const double ms = (double)(event.End - event.Begin) / ticksPerMs;
+
+			size_t& index = statsIndices.FindOrAdd(event.Name, stats.GetCount());
+			if (index == stats.GetCount())
+			{
+				SProfileZoneStats& added = stats.Emplace();
+				added.Name = event.Name;
+				added.MinMs = ms;
+			}
+
+			SProfileZoneStats& zone = stats[index];
+			++zone.Count;
+			zone.TotalMs += ms;
+			zone.SelfMs += (double)(event.End - event.Begin - childTicks[i]) / ticksPerMs;
+			zone.MinMs = ms < zone.MinMs ? ms : zone.MinMs;
+			zone.MaxMs = ms > zone.MaxMs ? ms : zone.MaxMs;
+		}
+	}
+
+	// identical names in different translation units may be different pointers
+	FAlgorithms::Sort(stats.GetData(), stats.GetData() + stats.GetCount(), [](const SProfileZoneStats& a, const SProfileZoneStats& b)
+	{
+		return strcmp(a.Name, b.Name) < 0;
+	});
+
+	size_t mergedCount = 0;
+	for (size_t i = 0; i < stats.GetCount(); ++i)
+	{
+		if (mergedCount && strcmp(stats[mergedCount - 1].Name, stats[i].Name) == 0)
+		{
+			SProfileZoneStats& merged = stats[mergedCount - 1];
+			merged.Count += stats[i].Count;
+			merged.TotalMs += stats[i].TotalMs;
+			merged.SelfMs += stats[i].SelfMs;
+			merged.MinMs = stats[i].MinMs < merged.MinMs ? stats[i].MinMs : merged.MinMs;
+			merged.MaxMs = stats[i].MaxMs > merged.MaxMs ? stats[i].MaxMs : merged.MaxMs;
+		}
+		else
+		{
+			stats[mergedCount++] = stats[i];
+		}
+	}
+	stats.Resize(mergedCount);
+
+	FAlgorithms::Sort(stats.GetData(), stats.GetData() + stats.GetCount(), [](const SProfileZoneStats& a, const SProfileZoneStats& b)
+	{
+		return a.TotalMs > b.TotalMs;
+	});
+
+	for (const SProfileZoneStats& zone : stats)
+	{
+		outStats.Add(zone);
+	}
+}
+
+void FProfiler::WriteReport(FString& out, const uint maxZones)
+{
+	TArray<SProfileZoneStats> stats;
+	GetZoneStats(stats);
+
+	FFormat::Append(out, "[CPU profile] {} zone names\r\n", stats.GetCount());
+	FFormat::Append(out, "{:>12} {:>12} {:>10} {:>10} {:>10}  {}\r\n", "Total ms", "Self ms", "Count", "Avg us", "Max us", "Zone");
+	for (size_t i = 0; i < stats.GetCount() && i < maxZones; ++i)
+	{
+		const SProfileZoneStats& zone = stats[i];
+		FFormat::Append(out, "{:>12.3f} {:>12.3f} {:>10} {:>10.2f} {:>10.2f}  {}\r\n", zone.TotalMs, zone.SelfMs, zone.Count,
+		                zone.TotalMs * 1000.0 / (double)zone.Count, zone.MaxMs * 1000.0, zone.Name);
+	}
+}
+
+void FProfiler::WriteChromeTrace(FString& out)
+{
+	out.Append("{\"traceEvents\":[");
+	if (!gProfiler.BaseTimestamp)
+	{
+		out.Append("]}\n");
+		return;
+	}
+
+	const double ticksPerUs = GetTicksPerMicrosecond();
+	bool first = true;
+	TArray<SProfileEvent> events;
+
+	for (SProfileThread* thread = gProfiler.Threads.load(std::memory_order_acquire); thread; thread = thread->Next)
+	{
+		if (thread->Name[0])
+		{
+			FFormat::Append(out, "{}\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":", first ? "" : ",", thread->ThreadId);
+			FFormat::AppendJsonString(out, thread->Name);
+			out.Append("}}");
+			first = false;
+		}
+
+		events.Resize(0);
+		CollectProfileEvents(*thread, events);
+		for (const SProfileEvent& event : events)
+		{
+			FFormat::Append(out, "{}\n{{\"name\":", first ? "" : ",");
+			FFormat::AppendJsonString(out, event.Name);
+			FFormat::Append(out, ",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}", thread->ThreadId,
+			                (double)(int64)(event.Begin - gProfiler.BaseTimestamp) / ticksPerUs,
+			                (double)(event.End - event.Begin) / ticksPerUs);
+			first = false;
+		}
+	}
+
+	out.Append("\n],\"displayTimeUnit\":\"ns\"}\n");
+}
+#else
+void FProfiler::SetEnabled(bool)
+{
+}
+
+void FProfiler::Reset()
+{
+}
+
+void FProfiler::SetThreadName(FStringView)
+{
+}
+
+void FProfiler::GetZoneStats(TArray<SProfileZoneStats>&)
+{
+}
+
+void FProfiler::WriteReport(FString& out, uint)
+{
+	out.Append("[CPU profile] requires PF_ENABLE_PROFILING\r\n");
+}
+
+void FProfiler::WriteChromeTrace(FString& out)
+{
+	out.Append("{\"traceEvents\":[]}\n");
+}
+
+void FProfiler::RecordZone(const char*, uint64, uint64)
+{
+}
+#endif
+
+#ifdef PF_ENABLE_PROFILING
+static NOINLINE uint64 SpinForProfilerTest(const uint iterations)
+{
+	volatile uint64 sink = 0;
+	for (uint i = 0; i < iterations; ++i)
+	{
+		sink = sink + i;
+	}
+	return sink;
+}
+
+UnitTestExclusive(Profiler_Zones)
+{
+	FProfiler::Reset();
+	FProfiler::SetEnabled(true);
+
+	{
+		PF_PROFILE_SCOPE("Profiler test outer");
+		for (uint i = 0; i < 3; ++i)
+		{
+			PF_PROFILE_SCOPE("Profiler test inner");
+			SpinForProfilerTest(10000);
+		}
+	}
+
+	std::thread thread([]
+	{
+		FProfiler::SetThreadName("Profiler \"test\" thread");
+		PF_PROFILE_SCOPE("Profiler test inner");
+		SpinForProfilerTest(10000);
+	});
+	thread.join();
+
+	FProfiler::SetEnabled(false);
+	{
+		PF_PROFILE_SCOPE("Profiler test disabled");
+	}
+
+	TArray<SProfileZoneStats> stats;
+	FProfiler::GetZoneStats(stats);
+	tverify(stats.GetCount() == 2);
+
+	const SProfileZoneStats& outer = strcmp(stats[0].Name, "Profiler test outer") == 0 ? stats[0] : stats[1];
+	const SProfileZoneStats& inner = strcmp(stats[0].Name, "Profiler test outer") == 0 ? stats[1] : stats[0];
+	tcheck(strcmp(inner.Name, "Profiler test inner") == 0);
+	tcheck(outer.Count == 1);
+	tcheck(inner.Count == 4); // both threads
+	tcheck(inner.SelfMs == inner.TotalMs);
+	tcheck(outer.SelfMs < outer.TotalMs); // the nested zones are subtracted
+	tcheck(inner.MinMs <= inner.MaxMs);
+
+	FString trace;
+	FProfiler::WriteChromeTrace(trace);
+	tcheck(trace.Find("{\"traceEvents\":[") == 0);
+	tcheck(trace.Find("\"ph\":\"X\"") != FStringView::kNotFound);
+	tcheck(trace.Find("Profiler \\\"test\\\" thread") != FStringView::kNotFound);
+
+	FString report;
+	FProfiler::WriteReport(report);
+	tcheck(report.Find("[CPU profile] 2 zone names") == 0);
+
+	FProfiler::Reset();
+	stats.Clear();
+	FProfiler::GetZoneStats(stats);
+	tcheck(stats.GetCount() == 0);
+}
+
+Benchmark(Profiler_Zone)
+{
+	// cost of one empty zone: an atomic load when disabled, two timestamps and an append when enabled
+	uint64 counter = 0;
+	bench.Measure("NoZone", [&counter]
+	{
+		FBenchmark::DoNotOptimize(++counter);
+	});
+
+	FProfiler::SetEnabled(false);
+	bench.Measure("Disabled", [&counter]
+	{
+		PF_PROFILE_SCOPE("Profiler benchmark");
+		FBenchmark::DoNotOptimize(++counter);
+	});
+
+	FProfiler::Reset();
+	FProfiler::SetEnabled(true);
+	uint recorded = 0;
+	bench.Measure("Enabled", [&counter, &recorded]
+	{
+		{
+			PF_PROFILE_SCOPE("Profiler benchmark");
+			FBenchmark::DoNotOptimize(++counter);
+		}
+		if (++recorded == 1u << 20) // bounds the memory, the chunks freed here are as many as were allocated
+		{
+			FProfiler::Reset();
+			recorded = 0;
+		}
+	});
+
+	FProfiler::SetEnabled(false);
+	FProfiler::Reset();
+}
+#endif
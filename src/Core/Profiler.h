@@ -0,0 +1,125 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Aggregated timings of all zones with the same name
+ */
+struct SProfileZoneStats
+{
+	const char* Name = nullptr;
+	uint64 Count = 0;
+	double TotalMs = 0.0;
+	double SelfMs = 0.0; // minus the time spent in nested zones of the same thread
+	double MinMs = 0.0;
+	double MaxMs = 0.0;
+};
+
+extern std::atomic<bool> gProfilerEnabled;
+
+/**
+ * Hierarchical CPU profiler, available with PF_ENABLE_PROFILING.
+ * PF_PROFILE_SCOPE records the time between its construction and the end of the scope into a buffer owned by the
+ * calling thread: two timestamp counter reads and one append, no locks. Nesting is reconstructed from the intervals
+ * when a report is made. Recorded zones can be exported as a Chrome trace (chrome://tracing, ui.perfetto.dev) or
+ * summarized per zone name. Recording costs an atomic load when disabled
+ */
+struct FProfiler
+{
+	static void SetEnabled(bool enabled);
+
+	static FORCEINLINE bool IsEnabled()
+	{
+		return gProfilerEnabled.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Forget all recorded zones. Must not race with recording
+	 */
+	static void Reset();
+
+	/**
+	 * Name of the calling thread in exported traces, truncated to 31 characters
+	 */
+	static void SetThreadName(FStringView name);
+
+	/**
+	 * Appends the statistics of every zone name, largest total time first
+	 */
+	static void GetZoneStats(TArray<SProfileZoneStats>& outStats);
+
+	/**
+	 * Per-zone aggregate table
+	 */
+	static void WriteReport(FString& out, uint maxZones = 32);
+
+	/**
+	 * Chrome trace event JSON of every recorded zone. Can run while other threads record
+	 */
+	static void WriteChromeTrace(FString& out);
+
+	/**
+	 * Store a finished zone. `name` must outlive the profiler data (string literals)
+	 */
+	static void RecordZone(const char* name, uint64 begin, uint64 end);
+
+	static FORCEINLINE uint64 GetTimestamp()
+	{
+		return __rdtsc();
+	}
+};
+
+class FProfileScope
+{
+	const char* m_Name;
+	uint64 m_Begin;
+
+public:
+	explicit FORCEINLINE FProfileScope(const char* name)
+	{
+		m_Name = FProfiler::IsEnabled() ? name : nullptr;
+		m_Begin = m_Name ? FProfiler::GetTimestamp() : 0;
+	}
+
+	FORCEINLINE ~FProfileScope()
+	{
+		if (m_Name)
+		{
+			FProfiler::RecordZone(m_Name, m_Begin, FProfiler::GetTimestamp());
+		}
+	}
+
+	FProfileScope(const FProfileScope&) = delete;
+	FProfileScope& operator=(const FProfileScope&) = delete;
+};
+
+#define PF_PROFILE_CONCAT_INNER(a, b) a##b
+#define PF_PROFILE_CONCAT(a, b) PF_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PF_ENABLE_PROFILING
+#define PF_PROFILE_SCOPE(name) FProfileScope PF_PROFILE_CONCAT(__profileScope, __LINE__)(name)
+#else
+#define PF_PROFILE_SCOPE(name)
+#endif
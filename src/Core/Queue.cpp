@@ -0,0 +1,355 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+/**
+ * Move-only payload that counts live instances
+ */
+struct SQueueMoveOnly
+{
+	static std::atomic<int> LiveCount;
+
+	uint* Value = nullptr;
+
+	SQueueMoveOnly()
+	{
+		++LiveCount;
+	}
+
+	explicit SQueueMoveOnly(uint* value) : Value(value)
+	{
+		++LiveCount;
+	}
+
+	SQueueMoveOnly(SQueueMoveOnly&& other) noexcept : Value(other.Value)
+	{
+		other.Value = nullptr;
+		++LiveCount;
+	}
+
+	SQueueMoveOnly& operator=(SQueueMoveOnly&& other) noexcept
+	{
+		Value = other.Value;
+		other.Value = nullptr;
+		return *this;
+	}
+
+	SQueueMoveOnly(const SQueueMoveOnly&) = delete;
+	SQueueMoveOnly& operator=(const SQueueMoveOnly&) = delete;
+
+	~SQueueMoveOnly()
+	{
+		--LiveCount;
+	}
+};
+
+std::atomic<int> SQueueMoveOnly::LiveCount{0};
+
+UnitTestExclusive(Queue_Spsc)
+{
+	uint storage[8] = {};
+	{
+		TSpscQueue<SQueueMoveOnly, 4> queue;
+		tcheck(queue.IsEmpty());
+		for (uint i = 0; i < 4; ++i)
+		{
+			tcheck(queue.TryEmplace(&storage[i]));
+		}
+		tcheck(!queue.TryEmplace(&storage[4])); // full
+		tcheck(queue.GetCount() == 4);
+
+		SQueueMoveOnly out;
+		tcheck(queue.TryPop(out) && out.Value == &storage[0]);
+		tcheck(queue.TryPush(SQueueMoveOnly(&storage[5])));
+		tcheck(queue.TryPop(out) && out.Value == &storage[1]);
+		tcheck(SQueueMoveOnly::LiveCount.load() == 4); // three queued and `out`
+	}
+	tcheck(SQueueMoveOnly::LiveCount.load() == 0); // the queue destroyed what was left
+
+	constexpr uint64 kCount = 200000;
+	TSpscQueue<uint64, 256> queue;
+	std::thread producer([&queue]
+	{
+		for (uint64 i = 0; i < kCount; ++i)
+		{
+			while (!queue.TryPush(i))
+			{
+				_mm_pause();
+			}
+		}
+	});
+
+	bool ordered = true;
+	uint64 value;
+	for (uint64 i = 0; i < kCount; ++i)
+	{
+		while (!queue.TryPop(value))
+		{
+			_mm_pause();
+		}
+		ordered &= value == i;
+	}
+	producer.join();
+	tcheck(ordered);
+	tcheck(queue.IsEmpty());
+}
+
+UnitTestExclusive(Queue_Mpmc)
+{
+	{
+		TMpmcQueue<SQueueMoveOnly> queue(4);
+		uint storage[4] = {};
+		for (uint i = 0; i < 4; ++i)
+		{
+			tcheck(queue.TryEmplace(&storage[i]));
+		}
+		tcheck(!queue.TryEmplace(nullptr));
+
+		SQueueMoveOnly out;
+		tcheck(queue.TryPop(out) && out.Value == &storage[0]);
+	}
+	tcheck(SQueueMoveOnly::LiveCount.load() == 0);
+
+	constexpr uint kThreadCount = 4;
+	constexpr uint64 kPerProducer = 50000;
+	TMpmcQueue<uint64> queue(1024);
+	std::atomic<uint64> sum{0};
+	std::atomic<uint64> popped{0};
+
+	std::thread threads[kThreadCount * 2];
+	for (uint t = 0; t < kThreadCount; ++t)
+	{
+		threads[t] = std::thread([&queue, t]
+		{
+			for (uint64 i = 0; i < kPerProducer; ++i)
+			{
+				while (!queue.TryPush(t * kPerProducer + i))
+				{
+					_mm_pause();
+				}
+			}
+		});
+
+		threads[kThreadCount + t] = std::thread([&queue, &sum, &popped]
+		{
+			uint64 value;
+			uint64 localSum = 0;
+			while (popped.load(std::memory_order_relaxed) < kThreadCount * kPerProducer)
+			{
+				if (queue.TryPop(value))
+				{
+					localSum += value;
+					popped.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					_mm_pause();
+				}
+			}
+			sum.fetch_add(localSum);
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	constexpr uint64 kTotal = kThreadCount * kPerProducer;
+	tcheck(popped.load() == kTotal);
+	tcheck(sum.load() == kTotal * (kTotal - 1) / 2);
+}
+
+Benchmark(Queue_Throughput)
+{
+	// one iteration moves kCount values from a producer thread to the measuring thread, thread start included
+	constexpr uint64 kCount = 65536;
+
+	bench.Measure("Spsc", []
+	{
+		TSpscQueue<uint64, 1024> queue;
+		std::thread producer([&queue]
+		{
+			for (uint64 i = 0; i < kCount; ++i)
+			{
+				while (!queue.TryPush(i))
+				{
+					_mm_pause();
+				}
+			}
+		});
+
+		uint64 value, sum = 0;
+		for (uint64 i = 0; i < kCount; ++i)
+		{
+			while (!queue.TryPop(value))
+			{
+				_mm_pause();
+			}
+			sum += value;
+		}
+		producer.join();
+		FBenchmark::DoNotOptimize(sum);
+	});
+
+	bench.Measure("Mpmc", []
+	{
+		TMpmcQueue<uint64> queue(1024);
+		std::thread producer([&queue]
+		{
+			for (uint64 i = 0; i < kCount; ++i)
+			{
+				while (!queue.TryPush(i))
+				{
+					_mm_pause();
+				}
+			}
+		});
+
+		uint64 value, sum = 0;
+		for (uint64 i = 0; i < kCount; ++i)
+		{
+			while (!queue.TryPop(value))
+			{
+				_mm_pause();
+			}
+			sum += value;
+		}
+		producer.join();
+		FBenchmark::DoNotOptimize(sum);
+	});
+
+	// contention: 4 producers and 4 consumers (the measuring thread is one of them) share one queue
+	bench.Measure("Mpmc/4x4", []
+	{
+		constexpr uint kThreadCount = 4;
+		constexpr uint64 kCountPerThread = kCount / kThreadCount;
+		TMpmcQueue<uint64> queue(1024);
+		std::atomic<uint64> consumedSum{0};
+
+		auto consume = [&queue, &consumedSum]
+		{
+			uint64 value, sum = 0;
+			for (uint64 i = 0; i < kCountPerThread; ++i)
+			{
+				while (!queue.TryPop(value))
+				{
+					_mm_pause();
+				}
+				sum += value;
+			}
+			consumedSum += sum;
+		};
+
+		std::thread threads[kThreadCount * 2 - 1];
+		for (uint t = 0; t < kThreadCount; ++t)
+		{
+			threads[t] = std::thread([&queue]
+			{
+				for (uint64 i = 0; i < kCountPerThread; ++i)
+				{
+					while (!queue.TryPush(i))
+					{
+						_mm_pause();
+					}
+				}
+			});
+		}
+		for (uint t = kThreadCount; t < kThreadCount * 2 - 1; ++t)
+		{
+			threads[t] = std::thread(consume);
+		}
+
+		consume();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		FBenchmark::DoNotOptimize(consumedSum.load());
+	});
+}
+
+/**
+ * One iteration sends a value to an echo thread through `ping` and waits until it comes back through `pong`
+ */
+template <typename TBenchmark, typename TQueue>
+static void MeasureQueueRoundTrip(TBenchmark& bench, const FStringView variant, TQueue& ping, TQueue& pong)
+{
+	constexpr uint64 kStop = ~0ull;
+	std::thread echo([&ping, &pong]
+	{
+		uint64 value;
+		for (;;)
+		{
+			while (!ping.TryPop(value))
+			{
+				_mm_pause();
+			}
+			if (value == kStop)
+			{
+				break;
+			}
+			while (!pong.TryPush(value))
+			{
+				_mm_pause();
+			}
+		}
+	});
+
+	uint64 next = 0;
+	bench.Measure(variant, [&ping, &pong, &next]
+	{
+		uint64 value;
+		while (!ping.TryPush(next))
+		{
+			_mm_pause();
+		}
+		while (!pong.TryPop(value))
+		{
+			_mm_pause();
+		}
+		TBenchmark::DoNotOptimize(value);
+		++next;
+	});
+
+	while (!ping.TryPush(kStop))
+	{
+		_mm_pause();
+	}
+	echo.join();
+}
+
+Benchmark(Queue_Latency)
+{
+	// round trip between two spinning threads, so the median is about two hand-offs
+	{
+		TSpscQueue<uint64, 64> ping, pong;
+		MeasureQueueRoundTrip(bench, "Spsc", ping, pong);
+	}
+	{
+		TMpmcQueue<uint64> ping(64), pong(64);
+		MeasureQueueRoundTrip(bench, "Mpmc", ping, pong);
+	}
+}
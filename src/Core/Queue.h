@@ -0,0 +1,276 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Bounded lock-free single producer, single consumer ring buffer of N elements (a power of two).
+ * Each side caches the index of the other side and only reloads it when the ring looks full or empty, so the
+ * shared cache lines are touched about once per lap instead of once per element
+ */
+template <typename T, size_t N>
+class TSpscQueue
+{
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "TSpscQueue capacity must be a power of two");
+
+	static constexpr size_t kMask = N - 1;
+	static constexpr size_t kAlignment = alignof(T) > 64 ? alignof(T) : 64;
+
+	T* m_Data;
+
+	// consumer side
+	alignas(64) std::atomic<size_t> m_Head{0};
+	size_t m_CachedTail = 0;
+
+	// producer side
+	alignas(64) std::atomic<size_t> m_Tail{0};
+	size_t m_CachedHead = 0;
+
+public:
+	FORCEINLINE TSpscQueue()
+	{
+		m_Data = (T*)FMemory::Alloc(sizeof(T) * N, kAlignment);
+	}
+
+	~TSpscQueue()
+	{
+		const size_t tail = m_Tail.load(std::memory_order_acquire);
+		for (size_t i = m_Head.load(std::memory_order_relaxed); i != tail; ++i)
+		{
+			m_Data[i & kMask].~T();
+		}
+		FMemory::Free(m_Data);
+	}
+
+	TSpscQueue(const TSpscQueue&) = delete;
+	TSpscQueue& operator=(const TSpscQueue&) = delete;
+
+	/**
+	 * Producer only. Returns false if the queue is full
+	 */
+	template <typename...Args>
+	FORCEINLINE bool TryEmplace(Args&&...args)
+	{
+		const size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_CachedHead == N)
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			if (tail - m_CachedHead == N)
+			{
+				return false;
+			}
+		}
+
+		new(m_Data + (tail & kMask)) T(std::forward<Args>(args)...);
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	FORCEINLINE bool TryPush(const T& value)
+	{
+		return TryEmplace(value);
+	}
+
+	FORCEINLINE bool TryPush(T&& value)
+	{
+		return TryEmplace(std::move(value));
+	}
+
+	/**
+	 * Consumer only. Moves the oldest element to `out`, returns false if the queue is empty
+	 */
+	FORCEINLINE bool TryPop(T& out)
+	{
+		const size_t head = m_Head.load(std::memory_order_relaxed);
+		if (head == m_CachedTail)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			if (head == m_CachedTail)
+			{
+				return false;
+			}
+		}
+
+		T& element = m_Data[head & kMask];
+		out = std::move(element);
+		element.~T();
+		m_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Exact only when called from the producer or the consumer while the other side is idle
+	 */
+	FORCEINLINE size_t GetCount() const
+	{
+		return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+	}
+
+	FORCEINLINE bool IsEmpty() const
+	{
+		return GetCount() == 0;
+	}
+
+	static constexpr size_t GetCapacity()
+	{
+		return N;
+	}
+};
+
+/**
+ * Bounded lock-free multi producer, multi consumer queue (Dmitry Vyukov's bounded MPMC queue).
+ * Every cell carries a sequence number telling whose turn it is: producers and consumers claim a position with a
+ * single CAS on their own index and then only touch that cell
+ */
+template <typename T>
+class TMpmcQueue
+{
+	struct SCell
+	{
+		std::atomic<size_t> Sequence;
+		alignas(T) uint8 Storage[sizeof(T)];
+	};
+
+	static constexpr size_t kAlignment = alignof(SCell) > 64 ? alignof(SCell) : 64;
+
+	SCell* m_Cells;
+	size_t m_Mask;
+
+	alignas(64) std::atomic<size_t> m_EnqueuePosition{0};
+	alignas(64) std::atomic<size_t> m_DequeuePosition{0};
+
+public:
+	/**
+	 * `capacity` must be a power of two
+	 */
+	explicit TMpmcQueue(const size_t capacity) : m_Mask(capacity - 1)
+	{
+		check(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+
+		m_Cells = (SCell*)FMemory::Alloc(sizeof(SCell) * capacity, kAlignment);
+		for (size_t i = 0; i < capacity; ++i)
+		{
+			new(&m_Cells[i].Sequence) std::atomic<size_t>(i);
+		}
+	}
+
+	~TMpmcQueue()
+	{
+		const size_t end = m_EnqueuePosition.load(std::memory_order_acquire);
+		for (size_t i = m_DequeuePosition.load(std::memory_order_relaxed); i != end; ++i)
+		{
+			((T*)m_Cells[i & m_Mask].Storage)->~T();
+		}
+		FMemory::Free(m_Cells);
+	}
+
+	TMpmcQueue(const TMpmcQueue&) = delete;
+	TMpmcQueue& operator=(const TMpmcQueue&) = delete;
+
+	/**
+	 * Any thread. Returns false if the queue is full
+	 */
+	template <typename...Args>
+	bool TryEmplace(Args&&...args)
+	{
+		size_t position = m_EnqueuePosition.load(std::memory_order_relaxed);
+		SCell* cell;
+		while (true)
+		{
+			cell = &m_Cells[position & m_Mask];
+			const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+			const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+			if (difference == 0) // the cell is free for this lap
+			{
+				if (m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0) // the cell still holds an element from the previous lap
+			{
+				return false;
+			}
+			else
+			{
+				position = m_EnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		new(cell->Storage) T(std::forward<Args>(args)...);
+		cell->Sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	FORCEINLINE bool TryPush(const T& value)
+	{
+		return TryEmplace(value);
+	}
+
+	FORCEINLINE bool TryPush(T&& value)
+	{
+		return TryEmplace(std::move(value));
+	}
+
+	/**
+	 * Any thread. Moves the oldest element to `out`, returns false if the queue is empty
+	 */
+	bool TryPop(T& out)
+	{
+		size_t position = m_DequeuePosition.load(std::memory_order_relaxed);
+		SCell* cell;
+		while (true)
+		{
+			cell = &m_Cells[position & m_Mask];
+			const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+			const intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+			if (difference == 0) // the cell holds an element
+			{
+				if (m_DequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0) // not written yet
+			{
+				return false;
+			}
+			else
+			{
+				position = m_DequeuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		T& element = *(T*)cell->Storage;
+		out = std::move(element);
+		element.~T();
+		cell->Sequence.store(position + m_Mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	FORCEINLINE size_t GetCapacity() const
+	{
+		return m_Mask + 1;
+	}
+};
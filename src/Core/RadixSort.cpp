@@ -0,0 +1,85 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+UnitTest(RadixSort_Keys)
+{
+	TArray<uint> values;
+	TArray<int64> signedValues;
+	TArray<float> floats;
+	uint seed = 31337;
+	for (uint i = 0; i < 20000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		values.Add(seed);
+		signedValues.Add((int64)seed * (seed & 1 ? -1 : 1) * 1000);
+		floats.Add(((float)(seed >> 8) - 8388608.0f) / 1000.0f);
+	}
+	floats.Add(-0.0f);
+	floats.Add(0.0f);
+
+	TArray<uint> expected = values;
+	FAlgorithms::Sort(expected);
+	FAlgorithms::RadixSort(values);
+	tcheck(memcmp(values.GetData(), expected.GetData(), values.GetCount() * sizeof(uint)) == 0);
+
+	FAlgorithms::RadixSort(signedValues);
+	tcheck(FAlgorithms::IsSorted(signedValues.GetData(), signedValues.GetData() + signedValues.GetCount()));
+
+	FAlgorithms::RadixSort(floats);
+	tcheck(FAlgorithms::IsSorted(floats.GetData(), floats.GetData() + floats.GetCount()));
+
+	int8 small[] = {5, -3, 127, -128, 0, 3, -1};
+	FAlgorithms::RadixSort(small, small + 7);
+	tcheck(small[0] == -128 && small[1] == -3 && small[6] == 127);
+}
+
+UnitTest(RadixSort_KeyExtractor)
+{
+	struct SEntry
+	{
+		uint64 Key;
+		uint Order;
+	};
+
+	TArray<SEntry> entries;
+	uint seed = 2024;
+	for (uint i = 0; i < 10000; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		entries.Add(SEntry{(uint64)(seed % 300) << 40, i}); // only the high bytes differ: low passes are skipped
+	}
+
+	FMemArena arena;
+	TArenaAllocator<SEntry> allocator(arena);
+	FAlgorithms::RadixSort(entries.GetData(), entries.GetData() + entries.GetCount(), [](const SEntry& e) { return e.Key; }, allocator);
+
+	bool stable = true;
+	for (size_t i = 1; i < entries.GetCount(); ++i)
+	{
+		stable &= entries[i - 1].Key < entries[i].Key || (entries[i - 1].Key == entries[i].Key && entries[i - 1].Order < entries[i].Order);
+	}
+	tcheck(stable);
+}
@@ -0,0 +1,168 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * Least significant digit radix sort over 8-bit digits for integer and floating point keys
+ */
+namespace FAlgorithms
+{
+	/**
+	 * Map a key to an unsigned integer with the same order
+	 */
+	FORCEINLINE uint8 ToRadixKey(const uint8 v) { return v; }
+	FORCEINLINE uint16 ToRadixKey(const uint16 v) { return v; }
+	FORCEINLINE uint32 ToRadixKey(const uint32 v) { return v; }
+	FORCEINLINE uint64 ToRadixKey(const uint64 v) { return v; }
+
+	// flipping the sign bit moves negative numbers below positive ones
+	FORCEINLINE uint8 ToRadixKey(const int8 v) { return (uint8)v ^ 0x80u; }
+	FORCEINLINE uint16 ToRadixKey(const int16 v) { return (uint16)((uint16)v ^ 0x8000u); }
+	FORCEINLINE uint32 ToRadixKey(const int32 v) { return (uint32)v ^ 0x80000000u; }
+	FORCEINLINE uint64 ToRadixKey(const int64 v) { return (uint64)v ^ 0x8000000000000000ull; }
+
+	// IEEE 754: positive numbers get the sign bit set, negative numbers are inverted entirely so that a bigger
+	// magnitude sorts lower. -0 sorts before +0, NaNs sort to the ends depending on their sign
+	FORCEINLINE uint32 ToRadixKey(const float v)
+	{
+		uint32 bits;
+		memcpy(&bits, &v, sizeof(bits));
+		return bits ^ ((uint32)((int32)bits >> 31) | 0x80000000u);
+	}
+
+	FORCEINLINE uint64 ToRadixKey(const double v)
+	{
+		uint64 bits;
+		memcpy(&bits, &v, sizeof(bits));
+		return bits ^ ((uint64)((int64)bits >> 63) | 0x8000000000000000ull);
+	}
+
+	/**
+	 * Key extractor for ranges of plain keys
+	 */
+	struct FRadixIdentityKey
+	{
+		template <typename T>
+		FORCEINLINE const T& operator()(const T& v) const
+		{
+			return v;
+		}
+	};
+
+	/**
+	 * Stable sort by `key(element)`, which must return one of the types ToRadixKey accepts. `buffer` is scratch
+	 * memory for `last - first` elements that the elements ping-pong with, one pass per key byte. Passes where every
+	 * key has the same byte are skipped. Elements are moved as raw bytes
+	 */
+	template <typename T, typename TKeyExtractor>
+	void RadixSort(T* first, T* last, T* buffer, TKeyExtractor key)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "RadixSort moves elements as raw bytes");
+
+		using TKey = decltype(ToRadixKey(key(*first)));
+		constexpr uint kPassCount = sizeof(TKey);
+
+		const size_t count = last - first;
+		if (count <= kInsertionSortThreshold)
+		{
+			InsertionSort(first, last, [&key](const T& a, const T& b) { return ToRadixKey(key(a)) < ToRadixKey(key(b)); });
+			return;
+		}
+
+		size_t histograms[kPassCount][256] = {};
+		for (const T* i = first; i < last; ++i)
+		{
+			const TKey radixKey = ToRadixKey(key(*i));
+			for (uint pass = 0; pass < kPassCount; ++pass)
+			{
+				++histograms[pass][(radixKey >> (pass * 8)) & 0xff];
+			}
+		}
+
+		const TKey firstKey = ToRadixKey(key(*first));
+		T* source = first;
+		T* destination = buffer;
+		for (uint pass = 0; pass < kPassCount; ++pass)
+		{
+			const uint shift = pass * 8;
+			size_t* const offsets = histograms[pass];
+			if (offsets[(firstKey >> shift) & 0xff] == count)
+			{
+				continue;
+			}
+
+			size_t offset = 0;
+			for (uint digit = 0; digit < 256; ++digit)
+			{
+				const size_t digitCount = offsets[digit];
+				offsets[digit] = offset;
+				offset += digitCount;
+			}
+
+			for (const T* i = source; i < source + count; ++i)
+			{
+				destination[offsets[(ToRadixKey(key(*i)) >> shift) & 0xff]++] = *i;
+			}
+			FUtils::Swap(source, destination);
+		}
+
+		if (source != first)
+		{
+			FMemory::Copy(first, source, count * sizeof(T));
+		}
+	}
+
+	/**
+	 * RadixSort with the scratch buffer taken from `allocator` (e.g. a TArenaAllocator) and returned to it
+	 */
+	template <typename T, typename TKeyExtractor, typename TAllocator>
+	void RadixSort(T* first, T* last, TKeyExtractor key, TAllocator& allocator)
+	{
+		static_assert(std::is_same<typename TAllocator::ElementType, T>::value, "RadixSort allocator must allocate elements");
+
+		if ((size_t)(last - first) <= kInsertionSortThreshold)
+		{
+			RadixSort(first, last, (T*)nullptr, key); // no scratch needed
+			return;
+		}
+
+		T* buffer = allocator.Alloc(last - first, alignof(T));
+		RadixSort(first, last, buffer, key);
+		allocator.Free(buffer);
+	}
+
+	template <typename T, typename TKeyExtractor = FRadixIdentityKey>
+	void RadixSort(T* first, T* last, TKeyExtractor key = TKeyExtractor())
+	{
+		TRawAllocator<T> allocator;
+		RadixSort(first, last, key, allocator);
+	}
+
+	template <typename T, typename TArrayAllocator, typename TGrowthPolicy, typename TKeyExtractor = FRadixIdentityKey>
+	void RadixSort(TArray<T, TArrayAllocator, TGrowthPolicy>& array, TKeyExtractor key = TKeyExtractor())
+	{
+		RadixSort(array.GetData(), array.GetData() + array.GetCount(), key);
+	}
+}
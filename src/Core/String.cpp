@@ -0,0 +1,161 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pch.h"
+
+UnitTestExclusive(String_Inline)
+{
+	const size_t initialMemory = FMemory::GetPurposeMemory(EAllocationPurpose::InternalString);
+
+	{
+		FString empty;
+		tcheck(empty.GetLength() == 0);
+		tcheck(empty[0] == 0);
+
+		FString shortString("short");
+		tcheck(shortString.GetLength() == 5);
+		tcheck(strcmp(shortString.GetData(), "short") == 0);
+
+		shortString += FString(" str");
+		tcheck(strcmp(shortString.GetData(), "short str") == 0);
+
+		FString copy = shortString;
+		tcheck(strcmp(copy.GetData(), "short str") == 0);
+
+		FString full("exactly 23 characters!!");
+		tcheck(full.IsInline());
+		tcheck(full.GetLength() == 23);
+		tcheck(full[23] == 0); // the inline capacity byte doubles as the terminator
+		static_assert(sizeof(FString) == 24, "the allocator must not add to the inline block");
+
+		tcheck(FMemory::GetPurposeMemory(EAllocationPurpose::InternalString) == initialMemory); // nothing on the heap
+	}
+
+	{
+		FString longString("a string that is too long for the inline block");
+		longString *= 2;
+		tcheck(longString.GetLength() == 92);
+
+		FString moved = std::move(longString);
+		tcheck(moved.GetLength() == 92);
+		tcheck(moved[91] == 'k');
+	}
+
+	tcheck(FMemory::GetPurposeMemory(EAllocationPurpose::InternalString) == initialMemory);
+}
+
+UnitTest(String_Append)
+{
+	FString string("0123456789");
+	string += string; // appending itself
+	tcheck(string == "01234567890123456789");
+	string.Append(string.SubString(5, 10)); // view into itself that spills to the heap
+	tcheck(!string.IsInline());
+	tcheck(string == "012345678901234567895678901234");
+	tcheck(string.GetLength() == 30);
+
+	FString assigned;
+	assigned = string;
+	tcheck(assigned == string);
+	assigned = FString("short");
+	tcheck(assigned.IsInline());
+	tcheck(assigned == "short");
+	tcheck(FString("a") < FString("ab"));
+	tcheck(FString("ab") < "b");
+	tcheck("a" < FString("b"));
+}
+
+UnitTest(String_View)
+{
+	const FStringView view("  key=value;other=1;;last  ");
+	const FStringView trimmed = view.Trim();
+	tcheck(trimmed == "key=value;other=1;;last");
+	tcheck(trimmed.StartsWith("key"));
+	tcheck(trimmed.EndsWith("last"));
+	tcheck(trimmed.Find('=') == 3);
+	tcheck(trimmed.Find("other") == 10);
+	tcheck(trimmed.Find("missing") == FStringView::kNotFound);
+	tcheck(trimmed.SubString(4, 5) == "value");
+	tcheck(trimmed.SubString(100).IsEmpty());
+	tcheck(trimmed.Right(4) == "last");
+
+	TArray<FStringView> parts;
+	tcheck(trimmed.Split(';', parts) == 4);
+	tcheck(parts[0] == "key=value");
+	tcheck(parts[1] == "other=1");
+	tcheck(parts[2].IsEmpty());
+	tcheck(parts[3] == "last");
+	tcheck(parts[1].GetData() == trimmed.GetData() + 10); // views share the source memory
+
+	uint count = 0;
+	trimmed.ForEachSplit(';', [&count](FStringView) { ++count; });
+	tcheck(count == 4);
+
+	FString owned(parts[0]);
+	tcheck(owned == parts[0]);
+	tcheck(owned.SubString(owned.Find("=") + 1) == "value");
+
+	THashMap<FString, int> map;
+	map.Insert("value", 1);
+	tcheck(map.Contains(owned.SubString(4))); // probe with a view, no temporary string
+}
+
+Benchmark(String_Append)
+{
+	bench.Measure("Inline", []
+	{
+		FString string;
+		for (uint i = 0; i < 4; ++i)
+		{
+			string += "short";
+		}
+		FBenchmark::DoNotOptimize(string.GetData()[0]);
+	});
+
+	bench.Measure("Heap", []
+	{
+		FString string;
+		for (uint i = 0; i < 200; ++i)
+		{
+			string += "a longer piece of text";
+		}
+		FBenchmark::DoNotOptimize(string.GetData()[0]);
+	});
+}
+
+Benchmark(String_Compare)
+{
+	TArray<FString> strings;
+	for (uint i = 0; i < 64; ++i)
+	{
+		strings.Add(FFormat::Format("a rather long string that does not fit inline, number {}", i * 7919 % 64));
+	}
+
+	uint i = 0;
+	bench.Measure([&strings, &i]
+	{
+		const uint index = i++;
+		FBenchmark::DoNotOptimize(strings[index % 64] < strings[(index + 1) % 64]);
+	});
+}
@@ -25,69 +25,360 @@
 #pragma once
 
 /**
- * A UTF-8 string
+ * Number of characters an FString stores inline before spilling to the heap (the terminating zero fits too)
  */
-class FString
+constexpr size_t kStringInlineLength = 23;
+
+using FDefaultStringAllocator = TRawAllocator<char, EAllocationPurpose::InternalString>;
+
+/**
+ * A UTF-8 string, always zero terminated.
+ * Short strings are stored in place (small string optimization): the 24 bytes that hold the heap pointer, length
+ * and capacity of a long string hold up to 23 characters instead. The last byte is the unused inline capacity,
+ * which becomes the terminating zero when the inline block is full. Long strings set the top bit of the capacity,
+ * which is that same byte on little-endian targets. The allocator is a base class so that a stateless one takes no
+ * space: an FString is those 24 bytes
+ */
+template <typename TAllocator = FDefaultStringAllocator>
+class TString : private TAllocator
 {
 	using CharType = char;
-	TArray<CharType, TRawAllocator<CharType, EAllocationPurpose::InternalString>> m_Data;
+
+	static_assert(std::is_same<typename TAllocator::ElementType, CharType>::value, "TString allocator must allocate characters");
+
+	struct SHeapData
+	{
+		CharType* Data;
+		size_t Length;
+		size_t Capacity; // top bit marks heap storage
+	};
+
+	static constexpr size_t kHeapFlag = (size_t)1 << (sizeof(size_t) * 8 - 1);
+	static constexpr size_t kInlineSize = sizeof(SHeapData);
+
+	static_assert(kInlineSize == kStringInlineLength + 1, "kStringInlineLength must fill SHeapData");
+
+	union
+	{
+		SHeapData m_Heap;
+		CharType m_Inline[kInlineSize];
+	};
+
+	FORCEINLINE bool IsHeap() const
+	{
+		return (m_Inline[kInlineSize - 1] & 0x80) != 0;
+	}
+
+	FORCEINLINE void InitInline()
+	{
+		m_Inline[0] = 0;
+		m_Inline[kInlineSize - 1] = (CharType)kStringInlineLength;
+	}
+
+	FORCEINLINE void SetLength(const size_t length)
+	{
+		if (IsHeap())
+		{
+			m_Heap.Length = length;
+			m_Heap.Data[length] = 0;
+		}
+		else
+		{
+			m_Inline[length] = 0;
+			m_Inline[kInlineSize - 1] = (CharType)(kStringInlineLength - length); // zero (the terminator) when full
+		}
+	}
+
+	/**
+	 * Move the characters to a heap block with room for `capacity` characters
+	 */
+	void Grow(const size_t capacity)
+	{
+		const size_t length = GetLength();
+		if (IsHeap())
+		{
+			m_Heap.Data = GetAllocator().ReAlloc(m_Heap.Data, capacity + 1);
+		}
+		else
+		{
+			CharType* data = GetAllocator().Alloc(capacity + 1);
+			FMemory::Copy(data, m_Inline, length + 1);
+			m_Heap.Data = data;
+			m_Heap.Length = length;
+		}
+		m_Heap.Capacity = capacity | kHeapFlag;
+	}
+
+	FORCEINLINE void FreeHeap()
+	{
+		if (IsHeap())
+		{
+			GetAllocator().Free(m_Heap.Data);
+		}
+	}
+
+	FORCEINLINE void MoveFrom(TString& other)
+	{
+		FMemory::Copy(m_Inline, other.m_Inline, kInlineSize); // either representation is relocatable as raw bytes
+		other.InitInline();
+	}
 
 public:
-	FORCEINLINE FString() : m_Data({0})
+	using AllocatorType = TAllocator;
+
+	FORCEINLINE TString() : TAllocator()
 	{
+		InitInline();
 	}
 
-	FORCEINLINE FString(const CharType* rawString)
+	explicit FORCEINLINE TString(const TAllocator& allocator) : TAllocator(allocator)
 	{
-		const size_t strLen = strlen(rawString);
-		m_Data.Resize(strLen + 1);
-		FMemory::Copy(m_Data.GetData(), rawString, sizeof(CharType) * strLen);
+		InitInline();
+	}
+
+	FORCEINLINE TString(const CharType* rawString, const TAllocator& allocator = TAllocator()) : TAllocator(allocator)
+	{
+		InitInline();
+		Append(rawString, strlen(rawString));
+	}
+
+	explicit FORCEINLINE TString(const FStringView view, const TAllocator& allocator = TAllocator()) : TAllocator(allocator)
+	{
+		InitInline();
+		Append(view.GetData(), view.GetLength());
+	}
+
+	FORCEINLINE TString(const TString& other) : TAllocator(other.GetAllocator())
+	{
+		InitInline();
+		Append(other.GetData(), other.GetLength());
+	}
+
+	FORCEINLINE TString(TString&& other) noexcept : TAllocator(std::move(other.GetAllocator()))
+	{
+		MoveFrom(other);
+	}
+
+	FORCEINLINE ~TString()
+	{
+		FreeHeap();
+	}
+
+	FORCEINLINE TString& operator=(const TString& other)
+	{
+		if (this != &other)
+		{
+			SetLength(0);
+			Append(other.GetData(), other.GetLength());
+		}
+		return *this;
+	}
+
+	FORCEINLINE TString& operator=(TString&& other) noexcept
+	{
+		if (this != &other)
+		{
+			FreeHeap();
+			GetAllocator() = std::move(other.GetAllocator());
+			MoveFrom(other);
+		}
+		return *this;
 	}
 
 	FORCEINLINE size_t GetLength() const
 	{
-		return m_Data.GetCount() - 1;
+		return IsHeap() ? m_Heap.Length : kStringInlineLength - m_Inline[kInlineSize - 1];
+	}
+
+	/**
+	 * Number of characters that fit without reallocating, excluding the terminating zero
+	 */
+	FORCEINLINE size_t GetCapacity() const
+	{
+		return IsHeap() ? m_Heap.Capacity & ~kHeapFlag : kStringInlineLength;
+	}
+
+	FORCEINLINE TAllocator& GetAllocator()
+	{
+		return *this;
+	}
+
+	FORCEINLINE const TAllocator& GetAllocator() const
+	{
+		return *this;
+	}
+
+	FORCEINLINE bool IsInline() const
+	{
+		return !IsHeap();
 	}
 
 	FORCEINLINE char& operator[](const size_t index)
 	{
-		return m_Data[index];
+		return GetData()[index];
 	}
 
 	FORCEINLINE char operator[](const size_t index) const
 	// char instead of char& to avoid additional memory address overhead
 	{
-		return m_Data[index];
+		return GetData()[index];
 	}
 
 	FORCEINLINE char* GetData()
 	{
-		return m_Data.GetData();
+		return IsHeap() ? m_Heap.Data : m_Inline;
 	}
 
 	FORCEINLINE const char* GetData() const
 	{
-		return m_Data.GetData();
+		return IsHeap() ? m_Heap.Data : m_Inline;
 	}
 
+	FORCEINLINE FStringView ToView() const
+	{
+		return FStringView(GetData(), GetLength());
+	}
+
+	FORCEINLINE operator FStringView() const
+	{
+		return ToView();
+	}
+
+	FORCEINLINE void Reserve(const size_t length)
+	{
+		if (length > GetCapacity())
+		{
+			Grow(length);
+		}
+	}
+
+	/**
+	 * New characters are zero
+	 */
 	FORCEINLINE void Resize(const size_t len)
 	{
-		m_Data.Resize(len + 1, 0);
-		m_Data[len] = 0; // ensure safe memory access
+		const size_t initialLen = GetLength();
+		Reserve(len);
+		if (len > initialLen)
+		{
+			memset(GetData() + initialLen, 0, len - initialLen);
+		}
+		SetLength(len);
 	}
 
-	FORCEINLINE FString& operator+=(const FString& other)
+	/**
+	 * `str` may point into this string
+	 */
+	FORCEINLINE TString& Append(const CharType* str, const size_t length)
 	{
 		const size_t initialLen = GetLength();
-		Resize(GetLength() + other.GetLength());
-		FMemory::Copy(GetData() + initialLen, other.GetData(), other.GetLength());
+		if (initialLen + length > GetCapacity())
+		{
+			const CharType* const data = GetData();
+			const bool aliased = str >= data && str < data + initialLen;
+			const size_t offset = str - data;
+
+			const size_t doubled = GetCapacity() * 2;
+			Grow(initialLen + length > doubled ? initialLen + length : doubled);
+			if (aliased)
+			{
+				str = GetData() + offset;
+			}
+		}
+
+		FMemory::Move(GetData() + initialLen, str, length);
+		SetLength(initialLen + length);
 		return *this;
 	}
 
+	FORCEINLINE TString& Append(const FStringView view)
+	{
+		return Append(view.GetData(), view.GetLength());
+	}
+
+	FORCEINLINE FStringView SubString(const size_t position, const size_t count = FStringView::kNotFound) const
+	{
+		return ToView().SubString(position, count);
+	}
+
+	FORCEINLINE size_t Find(const FStringView str, const size_t from = 0) const
+	{
+		return ToView().Find(str, from);
+	}
+
+	template <typename TArrayAllocator>
+	FORCEINLINE size_t Split(const CharType separator, TArray<FStringView, TArrayAllocator>& outParts) const
+	{
+		return ToView().Split(separator, outParts);
+	}
+
+	FORCEINLINE bool operator==(const FStringView other) const
+	{
+		return ToView() == other;
+	}
+
+	FORCEINLINE bool operator!=(const FStringView other) const
+	{
+		return !(*this == other);
+	}
+
+	FORCEINLINE bool operator==(const CharType* other) const
+	{
+		return ToView() == FStringView(other);
+	}
+
+	FORCEINLINE bool operator!=(const CharType* other) const
+	{
+		return !(*this == other);
+	}
+
+	FORCEINLINE bool operator==(const TString& other) const
+	{
+		return ToView() == other.ToView();
+	}
+
+	FORCEINLINE bool operator!=(const TString& other) const
+	{
+		return !(*this == other);
+	}
+
+	/**
+	 * Byte-wise lexicographical order
+	 */
+	FORCEINLINE bool operator<(const FStringView other) const
+	{
+		return ToView() < other;
+	}
+
+	FORCEINLINE bool operator<(const CharType* other) const
+	{
+		return ToView() < FStringView(other);
+	}
+
+	FORCEINLINE bool operator<(const TString& other) const
+	{
+		return ToView() < other.ToView();
+	}
+
+	FORCEINLINE TString& operator+=(const FStringView other)
+	{
+		return Append(other);
+	}
+
+	FORCEINLINE TString& operator+=(const TString& other)
+	{
+		return Append(other.GetData(), other.GetLength());
+	}
+
+	FORCEINLINE TString& operator+=(const CharType* other)
+	{
+		return Append(other, strlen(other));
+	}
+
 	/**
 	 * Repeat string N times
 	 */
-	FORCEINLINE FString& operator*=(const uint n)
+	FORCEINLINE TString& operator*=(const uint n)
 	{
 		const size_t initialLen = GetLength();
 		const size_t finalLen = initialLen * n;
@@ -95,21 +386,48 @@ public:
 		Resize(finalLen);
 
 		char* const pBegin = GetData() + initialLen;
-		for (char* p = pBegin; p < pBegin + finalLen; p += initialLen)
+		for (char* p = pBegin; p < GetData() + finalLen; p += initialLen)
 		{
-			FMemory::Copy(p, m_Data.GetData(), initialLen);
+			FMemory::Copy(p, GetData(), initialLen);
 		}
-		m_Data[initialLen * n] = 0;
 
 		return *this;
 	}
+};
+
+template <typename TAllocator>
+FORCEINLINE bool operator<(const char* s1, const TString<TAllocator>& s2)
+{
+	return FStringView(s1) < s2.ToView();
+}
+
+template <typename TAllocator>
+FORCEINLINE bool operator<(const FStringView s1, const TString<TAllocator>& s2)
+{
+	return s1 < s2.ToView();
+}
+
+using FString = TString<>;
 
-	template<typename...Args>
-	static FString PrintF(const FString& format, Args...args)
+namespace FUtils
+{
+	template <typename TAllocator>
+	struct Hash<TString<TAllocator>>
 	{
-		char buffer[1024];
-		sprintf(buffer, format.GetData(), args...);
+		FORCEINLINE size_t operator()(const TString<TAllocator>& v) const
+		{
+			return (size_t)HashBytes(v.GetData(), v.GetLength());
+		}
 
-		return FString(buffer);
-	}
-};
+		// hash the same as a TString with the same contents: allows THashMap lookups by view or raw string
+		FORCEINLINE size_t operator()(const FStringView v) const
+		{
+			return (size_t)HashBytes(v.GetData(), v.GetLength());
+		}
+
+		FORCEINLINE size_t operator()(const char* v) const
+		{
+			return (size_t)HashBytes(v, strlen(v));
+		}
+	};
+}
@@ -42,4 +42,35 @@ struct FStringConv
 		buffer.Resize(bufferSize);
 		return ToUtf16(inStr, bufferSize, buffer.GetData());
 	}
+
+	/**
+	 * Converts a character range that is not necessarily zero terminated. The result is zero terminated,
+	 * the returned count excludes the terminator
+	 */
+	static uint ToUtf16(const FStringView inStr, TArray<wchar_t>& buffer)
+	{
+		if (inStr.IsEmpty())
+		{
+			buffer.Resize(1);
+			buffer[0] = 0;
+			return 0;
+		}
+
+		const int inLength = (int)inStr.GetLength();
+		const uint count = (uint)::MultiByteToWideChar(CP_UTF8, 0, inStr.GetData(), inLength, nullptr, 0);
+		buffer.Resize(count + 1);
+		::MultiByteToWideChar(CP_UTF8, 0, inStr.GetData(), inLength, buffer.GetData(), count);
+		buffer[count] = 0;
+		return count;
+	}
+
+	static void ToUtf8(const wchar_t inStr[], FString& out)
+	{
+		const int count = ::WideCharToMultiByte(CP_UTF8, 0, inStr, -1, nullptr, 0, nullptr, nullptr);
+		out.Resize(count > 0 ? count - 1 : 0);
+		if (count > 1)
+		{
+			::WideCharToMultiByte(CP_UTF8, 0, inStr, -1, out.GetData(), count, nullptr, nullptr); // the terminating zero goes to the slot the string keeps past its length
+		}
+	}
 };
\ No newline at end of file
@@ -0,0 +1,230 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * A non-owning view of a UTF-8 character range. Not necessarily zero terminated.
+ * The viewed memory must outlive the view
+ */
+class FStringView
+{
+	using CharType = char;
+
+	const CharType* m_Data = "";
+	size_t m_Length = 0;
+
+public:
+	static constexpr size_t kNotFound = (size_t)-1;
+
+	FORCEINLINE constexpr FStringView() = default;
+
+	FORCEINLINE FStringView(const CharType* rawString) : m_Data(rawString), m_Length(strlen(rawString))
+	{
+	}
+
+	FORCEINLINE constexpr FStringView(const CharType* data, const size_t length) : m_Data(data), m_Length(length)
+	{
+	}
+
+	FORCEINLINE const CharType* GetData() const
+	{
+		return m_Data;
+	}
+
+	FORCEINLINE size_t GetLength() const
+	{
+		return m_Length;
+	}
+
+	FORCEINLINE bool IsEmpty() const
+	{
+		return !m_Length;
+	}
+
+	FORCEINLINE CharType operator[](const size_t index) const
+	{
+		check(index < m_Length);
+		return m_Data[index];
+	}
+
+	FORCEINLINE const CharType* begin() const
+	{
+		return m_Data;
+	}
+
+	FORCEINLINE const CharType* end() const
+	{
+		return m_Data + m_Length;
+	}
+
+	/**
+	 * Up to `count` characters starting at `position`, clamped to the view
+	 */
+	FORCEINLINE FStringView SubString(size_t position, const size_t count = kNotFound) const
+	{
+		position = position < m_Length ? position : m_Length;
+		const size_t remaining = m_Length - position;
+		return FStringView(m_Data + position, count < remaining ? count : remaining);
+	}
+
+	FORCEINLINE FStringView Left(const size_t count) const
+	{
+		return SubString(0, count);
+	}
+
+	FORCEINLINE FStringView Right(const size_t count) const
+	{
+		return count < m_Length ? SubString(m_Length - count) : *this;
+	}
+
+	/**
+	 * Index of the first occurrence of `c` at or after `from`, or kNotFound
+	 */
+	FORCEINLINE size_t Find(const CharType c, const size_t from = 0) const
+	{
+		if (from >= m_Length)return kNotFound;
+
+		const void* found = memchr(m_Data + from, c, m_Length - from);
+		return found ? (const CharType*)found - m_Data : kNotFound;
+	}
+
+	/**
+	 * Index of the first occurrence of `str` at or after `from`, or kNotFound
+	 */
+	size_t Find(const FStringView str, const size_t from = 0) const
+	{
+		if (str.IsEmpty())return from <= m_Length ? from : kNotFound;
+
+		for (size_t i = Find(str[0], from); i != kNotFound && i + str.m_Length <= m_Length; i = Find(str[0], i + 1))
+		{
+			if (memcmp(m_Data + i, str.m_Data, str.m_Length) == 0)
+			{
+				return i;
+			}
+		}
+		return kNotFound;
+	}
+
+	FORCEINLINE bool StartsWith(const FStringView prefix) const
+	{
+		return prefix.m_Length <= m_Length && memcmp(m_Data, prefix.m_Data, prefix.m_Length) == 0;
+	}
+
+	FORCEINLINE bool EndsWith(const FStringView suffix) const
+	{
+		return suffix.m_Length <= m_Length && memcmp(m_Data + m_Length - suffix.m_Length, suffix.m_Data, suffix.m_Length) == 0;
+	}
+
+	/**
+	 * View without leading and trailing spaces, tabs and line breaks
+	 */
+	FORCEINLINE FStringView Trim() const
+	{
+		size_t first = 0;
+		size_t last = m_Length;
+		while (first < last && IsWhitespace(m_Data[first]))
+			++first;
+		while (last > first && IsWhitespace(m_Data[last - 1]))
+			--last;
+		return FStringView(m_Data + first, last - first);
+	}
+
+	/**
+	 * Appends the parts between `separator` occurrences to `outParts`, empty parts included. Returns the number of parts
+	 */
+	template <typename TAllocator>
+	size_t Split(const CharType separator, TArray<FStringView, TAllocator>& outParts) const
+	{
+		size_t count = 0;
+		size_t begin = 0;
+		for (size_t end = Find(separator); end != kNotFound; end = Find(separator, begin))
+		{
+			outParts.Emplace(m_Data + begin, end - begin);
+			begin = end + 1;
+			++count;
+		}
+		outParts.Emplace(m_Data + begin, m_Length - begin);
+		return count + 1;
+	}
+
+	/**
+	 * Calls `callback(FStringView part)` for every part between `separator` occurrences, without storing them
+	 */
+	template <typename TCallback>
+	void ForEachSplit(const CharType separator, TCallback callback) const
+	{
+		size_t begin = 0;
+		for (size_t end = Find(separator); end != kNotFound; end = Find(separator, begin))
+		{
+			callback(FStringView(m_Data + begin, end - begin));
+			begin = end + 1;
+		}
+		callback(FStringView(m_Data + begin, m_Length - begin));
+	}
+
+	FORCEINLINE int Compare(const FStringView other) const
+	{
+		const size_t minLength = m_Length < other.m_Length ? m_Length : other.m_Length;
+		const int cmp = memcmp(m_Data, other.m_Data, minLength);
+		if (cmp)return cmp;
+		return m_Length < other.m_Length ? -1 : (m_Length > other.m_Length ? 1 : 0);
+	}
+
+	FORCEINLINE bool operator==(const FStringView other) const
+	{
+		return m_Length == other.m_Length && memcmp(m_Data, other.m_Data, m_Length) == 0;
+	}
+
+	FORCEINLINE bool operator!=(const FStringView other) const
+	{
+		return !(*this == other);
+	}
+
+	/**
+	 * Byte-wise lexicographical order
+	 */
+	FORCEINLINE bool operator<(const FStringView other) const
+	{
+		return Compare(other) < 0;
+	}
+
+private:
+	FORCEINLINE static bool IsWhitespace(const CharType c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+};
+
+namespace FUtils
+{
+	template <>
+	struct Hash<FStringView>
+	{
+		FORCEINLINE size_t operator()(const FStringView v) const
+		{
+			return (size_t)HashBytes(v.GetData(), v.GetLength());
+		}
+	};
+}
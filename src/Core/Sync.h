@@ -0,0 +1,78 @@
+/*
+ * Proef
+ *
+ * Copyright (c) Andrey Tsurkan
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * A test-and-test-and-set spin lock for short critical sections. Not reentrant
+ */
+class FSpinLock
+{
+	std::atomic<bool> m_Locked{false};
+
+public:
+	FORCEINLINE void Lock()
+	{
+		while (m_Locked.exchange(true, std::memory_order_acquire))
+		{
+			while (m_Locked.load(std::memory_order_relaxed))
+			{
+				_mm_pause();
+			}
+		}
+	}
+
+	FORCEINLINE bool TryLock()
+	{
+		return !m_Locked.load(std::memory_order_relaxed) && !m_Locked.exchange(true, std::memory_order_acquire);
+	}
+
+	FORCEINLINE void Unlock()
+	{
+		m_Locked.store(false, std::memory_order_release);
+	}
+};
+
+/**
+ * Holds a lock for the duration of a scope
+ */
+template <typename TLock>
+class TScopeLock
+{
+	TLock& m_Lock;
+
+public:
+	explicit FORCEINLINE TScopeLock(TLock& lock) : m_Lock(lock)
+	{
+		m_Lock.Lock();
+	}
+
+	FORCEINLINE ~TScopeLock()
+	{
+		m_Lock.Unlock();
+	}
+
+	TScopeLock(const TScopeLock&) = delete;
+	TScopeLock& operator=(const TScopeLock&) = delete;
+};
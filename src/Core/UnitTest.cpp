@@ -25,62 +25,324 @@
 #ifdef PF_UNIT_TEST
 #include "pch.h"
 
-static struct
+/**
+ * The test running on this thread. Failures are collected in Output and printed in one piece when the test is done,
+ * so that the output of tests running in parallel does not interleave
+ */
+static thread_local struct
 {
 	const __SUnitTestDesc* Desc = nullptr;
 	uint NumFailures = 0;
 	uint NumSuccesses = 0;
+	FString Output;
 } gCurrentTestInfo{};
 
 TArray<__SUnitTestDesc, TRawAllocator<__SUnitTestDesc, EAllocationPurpose::InternalDynamicInit>> __gUnitTests;
 
-void RunUnitTestsAndExit()
+/**
+ * All runs of one test
+ */
+struct SUnitTestResult
 {
-	FConsole::Initialize();
-	FConsole::WriteLine("Running unit tests...");
-	FConsole::WriteLine();
+	const __SUnitTestDesc* Desc = nullptr;
+	uint RunCount = 0;
+	uint FailedRunCount = 0;
+	uint NumSuccesses = 0;
+	uint NumFailures = 0;
+	int64 TotalTicks = 0;
+	int64 MinTicks = 0;
+	int64 MaxTicks = 0;
+	uint64 AllocCount = 0; // made by the test's own thread
+	FString FirstFailure;
+};
 
-	bool allSucceeded = true;
+static struct
+{
+	std::mutex PrintMutex;
+	double MsPerTick = 0.0;
+} gUnitTestRunner;
 
-	for (const __SUnitTestDesc& test : __gUnitTests)
+bool MatchesUnitTestFilter(const char* name, const FStringView filter)
+{
+	if (filter.IsEmpty())return true;
+
+	TArray<FStringView> parts;
+	filter.Split(',', parts);
+	for (const FStringView part : parts)
+	{
+		if (!part.IsEmpty() && FStringView(name).Find(part) != FStringView::kNotFound)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void PrintUnitTestResult(const SUnitTestResult& result)
+{
+	const bool succeeded = result.FailedRunCount == 0;
+	FString summary = FFormat::Format(" (succeeded: {}, failed: {}, total: {}, {:.2f} ms", result.NumSuccesses,
+	                                  result.NumFailures, result.NumSuccesses + result.NumFailures,
+	                                  (double)result.TotalTicks * gUnitTestRunner.MsPerTick / result.RunCount);
+#ifdef PF_ENABLE_PROFILING
+	FFormat::Append(summary, ", {} allocations", result.AllocCount / result.RunCount);
+#endif
+	if (result.RunCount > 1)
 	{
-		gCurrentTestInfo.Desc = &test;
+		FFormat::Append(summary, ", {} of {} runs failed", result.FailedRunCount, result.RunCount);
+	}
+	summary += ")";
+
+	std::lock_guard<std::mutex> lock(gUnitTestRunner.PrintMutex);
+	FConsole::WriteLine(FFormat::Format("[TEST \"{}\" in \"{}\"]", result.Desc->TestName, result.Desc->TestFilename));
+	FConsole::SetTextColor(succeeded ? EConsoleTextColor::Green : EConsoleTextColor::Red);
+	if (!succeeded)
+	{
+		FConsole::Write(result.FirstFailure);
+	}
+	FConsole::Write(succeeded ? "    TEST SUCCEEDED" : "    TEST FAILED");
+	FConsole::SetTextColor(EConsoleTextColor::White);
+	FConsole::WriteLine(summary);
+}
+
+static void RunUnitTest(SUnitTestResult& result, const uint repeatCount)
+{
+	for (uint run = 0; run < repeatCount; ++run)
+	{
+		gCurrentTestInfo.Desc = result.Desc;
 		gCurrentTestInfo.NumSuccesses = 0;
 		gCurrentTestInfo.NumFailures = 0;
+		gCurrentTestInfo.Output.Resize(0);
+
+		const uint64 initialAllocCount = FMemory::GetThreadAllocCount();
+		LARGE_INTEGER start, end;
+		::QueryPerformanceCounter(&start);
+		result.Desc->TestBody();
+		::QueryPerformanceCounter(&end);
 
-		FConsole::WriteLine(FString::PrintF("[TEST \"%s\" in \"%s\"]", test.TestName, test.TestFilename));
-		test.TestBody();
-		const bool succeeded = gCurrentTestInfo.NumFailures == 0;
+		const int64 ticks = end.QuadPart - start.QuadPart;
+		result.TotalTicks += ticks;
+		result.MinTicks = run == 0 || ticks < result.MinTicks ? ticks : result.MinTicks;
+		result.MaxTicks = ticks > result.MaxTicks ? ticks : result.MaxTicks;
+		result.AllocCount += FMemory::GetThreadAllocCount() - initialAllocCount;
+		result.NumSuccesses += gCurrentTestInfo.NumSuccesses;
+		result.NumFailures += gCurrentTestInfo.NumFailures;
+		++result.RunCount;
 
-		if (succeeded)
+		if (gCurrentTestInfo.NumFailures)
 		{
-			FConsole::SetTextColor(EConsoleTextColor::Green);
+			if (!result.FailedRunCount)
+			{
+				result.FirstFailure = gCurrentTestInfo.Output;
+				if (repeatCount > 1)
+				{
+					FFormat::Append(result.FirstFailure, "    (first failure in run {})\r\n", run + 1);
+				}
+			}
+			++result.FailedRunCount;
+		}
+
+		gCurrentTestInfo.Desc = nullptr; // reset desc to prevent asserts from working
+	}
+
+	PrintUnitTestResult(result);
+}
+
+static void WriteUnitTestJson(FString& out, const TArray<SUnitTestResult>& results)
+{
+	out.Append("{\"tests\":[");
+	for (size_t i = 0; i < results.GetCount(); ++i)
+	{
+		const SUnitTestResult& result = results[i];
+		out.Append(i ? ",\n{\"name\":" : "\n{\"name\":");
+		FFormat::AppendJsonString(out, result.Desc->TestName);
+		out.Append(",\"file\":");
+		FFormat::AppendJsonString(out, result.Desc->TestFilename);
+		FFormat::Append(out, ",\"runs\":{},\"failed_runs\":{},\"checks_succeeded\":{},\"checks_failed\":{},"
+		                "\"mean_ms\":{:.3f},\"min_ms\":{:.3f},\"max_ms\":{:.3f},\"allocs_per_run\":",
+		                result.RunCount, result.FailedRunCount, result.NumSuccesses, result.NumFailures,
+		                (double)result.TotalTicks * gUnitTestRunner.MsPerTick / result.RunCount,
+		                (double)result.MinTicks * gUnitTestRunner.MsPerTick, (double)result.MaxTicks * gUnitTestRunner.MsPerTick);
+#ifdef PF_ENABLE_PROFILING
+		FFormat::Append(out, "{:.1f}", (double)result.AllocCount / result.RunCount);
+#else
+		out.Append("null");
+#endif
+		out.Append(",\"failure\":");
+		if (result.FailedRunCount)
+		{
+			FFormat::AppendJsonString(out, result.FirstFailure);
 		}
 		else
 		{
-			FConsole::SetTextColor(EConsoleTextColor::Red);
+			out.Append("null");
+		}
+		out.Append("}");
+	}
+	out.Append("\n]}\n");
+}
+
+static void AppendXmlEscaped(FString& out, const FStringView text)
+{
+	for (const char* p = text.GetData(); p < text.GetData() + text.GetLength(); ++p)
+	{
+		switch (*p)
+		{
+		case '<': out.Append("&lt;"); break;
+		case '>': out.Append("&gt;"); break;
+		case '&': out.Append("&amp;"); break;
+		case '"': out.Append("&quot;"); break;
+		default: out.Append(p, 1); break;
+		}
+	}
+}
+
+/**
+ * One testcase per test, repeated runs are folded into it: the time is the mean, any failed run fails the case
+ */
+static void WriteUnitTestJUnit(FString& out, const TArray<SUnitTestResult>& results)
+{
+	uint failureCount = 0;
+	int64 totalTicks = 0;
+	for (const SUnitTestResult& result : results)
+	{
+		failureCount += result.FailedRunCount ? 1 : 0;
+		totalTicks += result.TotalTicks;
+	}
+
+	const double secondsPerTick = gUnitTestRunner.MsPerTick / 1000.0;
+	out.Append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	FFormat::Append(out, "<testsuites tests=\"{}\" failures=\"{}\" time=\"{:.3f}\">\n", results.GetCount(), failureCount, (double)totalTicks * secondsPerTick);
+	FFormat::Append(out, "<testsuite name=\"proef\" tests=\"{}\" failures=\"{}\" time=\"{:.3f}\">\n", results.GetCount(), failureCount, (double)totalTicks * secondsPerTick);
+	for (const SUnitTestResult& result : results)
+	{
+		out.Append("<testcase name=\"");
+		AppendXmlEscaped(out, result.Desc->TestName);
+		out.Append("\" classname=\"");
+		AppendXmlEscaped(out, result.Desc->TestFilename);
+		FFormat::Append(out, "\" time=\"{:.6f}\"", (double)result.TotalTicks * secondsPerTick / result.RunCount);
+		if (!result.FailedRunCount)
+		{
+			out.Append("/>\n");
+			continue;
+		}
+
+		FFormat::Append(out, "><failure message=\"{} of {} runs failed\">", result.FailedRunCount, result.RunCount);
+		AppendXmlEscaped(out, result.FirstFailure);
+		out.Append("</failure></testcase>\n");
+	}
+	out.Append("</testsuite>\n</testsuites>\n");
+}
+
+void RunUnitTestsAndExit(const SUnitTestOptions& options)
+{
+	if (options.Headless)
+	{
+		FConsole::InitializeHeadless();
+	}
+	else
+	{
+		FConsole::Initialize();
+	}
+	FConsole::WriteLine("Running unit tests...");
+	FConsole::WriteLine();
+
+	LARGE_INTEGER frequency;
+	::QueryPerformanceFrequency(&frequency);
+	gUnitTestRunner.MsPerTick = 1000.0 / (double)frequency.QuadPart;
+
+	TArray<SUnitTestResult> results;
+	for (const __SUnitTestDesc& test : __gUnitTests)
+	{
+		if (MatchesUnitTestFilter(test.TestName, options.Filter))
+		{
+			results.Emplace().Desc = &test;
 		}
+	}
 
-		FConsole::Write(succeeded ? "    TEST SUCCEEDED" : "    TEST FAILED");
+	const uint repeatCount = options.RepeatCount ? options.RepeatCount : 1;
+	uint threadCount = options.ThreadCount ? options.ThreadCount : std::thread::hardware_concurrency();
+	threadCount = threadCount < 1 ? 1 : threadCount;
 
-		FConsole::SetTextColor(EConsoleTextColor::White);
+	if (threadCount == 1)
+	{
+		for (SUnitTestResult& result : results)
+		{
+			RunUnitTest(result, repeatCount);
+		}
+	}
+	else
+	{
+		std::atomic<size_t> nextTest{0};
+		const auto worker = [&results, &nextTest, repeatCount]
+		{
+			for (size_t i = nextTest.fetch_add(1); i < results.GetCount(); i = nextTest.fetch_add(1))
+			{
+				if (!results[i].Desc->Exclusive)
+				{
+					RunUnitTest(results[i], repeatCount);
+				}
+			}
+		};
 
-		FConsole::WriteLine(FString::PrintF(" (succeeded: %u, failed: %u, total: %u)",
-		                                    gCurrentTestInfo.NumSuccesses, gCurrentTestInfo.NumFailures,
-		                                    gCurrentTestInfo.NumSuccesses + gCurrentTestInfo.NumFailures));
+		TArray<std::thread> threads;
+		for (uint i = 1; i < threadCount; ++i)
+		{
+			threads.Emplace(worker);
+		}
+		worker();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
 
-		if (!succeeded)
+		for (SUnitTestResult& result : results)
 		{
-			allSucceeded = false;
+			if (result.Desc->Exclusive)
+			{
+				RunUnitTest(result, repeatCount);
+			}
 		}
+	}
 
-		gCurrentTestInfo.Desc = nullptr; // reset desc to prevent asserts from working
+	uint failedCount = 0;
+	for (const SUnitTestResult& result : results)
+	{
+		failedCount += result.FailedRunCount ? 1 : 0;
+	}
+
+	if (options.JsonPath)
+	{
+		FString json;
+		WriteUnitTestJson(json, results);
+		if (!__UnitTestWriteFile(options.JsonPath, json))
+		{
+			FConsole::WriteLine("Could not write the JSON report");
+		}
+	}
+	if (options.JUnitPath)
+	{
+		FString xml;
+		WriteUnitTestJUnit(xml, results);
+		if (!__UnitTestWriteFile(options.JUnitPath, xml))
+		{
+			FConsole::WriteLine("Could not write the JUnit report");
+		}
 	}
 
 	FConsole::WriteLine();
-	FConsole::Write("Press any key to continue...  ");
-	FConsole::WaitForKey();
-	::ExitProcess(allSucceeded ? 0 : 3);
+	FConsole::WriteLine(FFormat::Format("{} of {} tests failed", failedCount, results.GetCount()));
+	if (options.BeforeExit)
+	{
+		options.BeforeExit();
+	}
+	if (!options.Headless)
+	{
+		FConsole::Write("Press any key to continue...  ");
+		FConsole::WaitForKey();
+	}
+	FConsole::Flush();
+	::ExitProcess(failedCount ? 3 : 0);
 }
 
 bool __UnitTestAssert(const bool result, const char* code, const char* message, const uint line)
@@ -90,14 +352,12 @@ bool __UnitTestAssert(const bool result, const char* code, const char* message,
 	if (!result)
 	{
 		gCurrentTestInfo.NumFailures++;
-		FConsole::SetTextColor(EConsoleTextColor::Red);
-		FConsole::WriteLine(FString::PrintF("    Failed on line %u:", line));
+		FFormat::Append(gCurrentTestInfo.Output, "    Failed on line {}:\r\n", line);
 
 		if (message)
-			FConsole::WriteLine(FString::PrintF("        %s   :   %s", code, message));
+			FFormat::Append(gCurrentTestInfo.Output, "        {}   :   {}\r\n", code, message);
 		else
-			FConsole::WriteLine(FString::PrintF("        %s", code, message));
-		FConsole::SetTextColor(EConsoleTextColor::White);
+			FFormat::Append(gCurrentTestInfo.Output, "        {}\r\n", code);
 	}
 	else
 	{
@@ -106,4 +366,39 @@ bool __UnitTestAssert(const bool result, const char* code, const char* message,
 
 	return !result;
 }
+
+bool __UnitTestReadFile(const wchar_t* path, FString& out)
+{
+	const HANDLE file = ::CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	bool succeeded = ::GetFileSizeEx(file, &size) != 0;
+	if (succeeded)
+	{
+		DWORD read = 0;
+		out.Resize((size_t)size.QuadPart);
+		succeeded = ::ReadFile(file, out.GetData(), (DWORD)size.QuadPart, &read, nullptr) && read == (DWORD)size.QuadPart;
+	}
+	::CloseHandle(file);
+	return succeeded;
+}
+
+bool __UnitTestWriteFile(const wchar_t* path, const FStringView text)
+{
+	const HANDLE file = ::CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	DWORD written = 0;
+	const bool succeeded = ::WriteFile(file, text.GetData(), (DWORD)text.GetLength(), &written, nullptr) && written == (DWORD)text.GetLength();
+	::CloseHandle(file);
+	return succeeded;
+}
+
 #endif
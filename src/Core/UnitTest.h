@@ -30,23 +30,73 @@ struct __SUnitTestDesc
 	const char* TestName;
 	const char* TestFilename;
 	void(*TestBody)();
+	bool Exclusive;
 };
 
 extern TArray<__SUnitTestDesc, TRawAllocator<__SUnitTestDesc, EAllocationPurpose::InternalDynamicInit>> __gUnitTests;
 
 struct __SUnitTestFactory
 {
-	__SUnitTestFactory(const char* testName, const char* testFilename, void(*testBody)())
+	__SUnitTestFactory(const char* testName, const char* testFilename, void(*testBody)(), const bool exclusive = false)
 	{
-		__gUnitTests.Add(__SUnitTestDesc{ testName, testFilename, testBody });
+		__gUnitTests.Add(__SUnitTestDesc{ testName, testFilename, testBody, exclusive });
 	}
 };
 
 #define UnitTest(name) void __UnitTest_##name(); __SUnitTestFactory __gUnitTestFactory_##name(#name, __FILE__, &__UnitTest_##name); void __UnitTest_##name ()
 
-[[noreturn]] void RunUnitTestsAndExit();
+/**
+ * A test that never runs concurrently with other tests: for tests that use process-wide state such as the job
+ * system, memory statistics or the console mode
+ */
+#define UnitTestExclusive(name) void __UnitTest_##name(); __SUnitTestFactory __gUnitTestFactory_##name(#name, __FILE__, &__UnitTest_##name, true); void __UnitTest_##name ()
+
+struct SUnitTestOptions
+{
+	/**
+	 * Comma separated parts of test names: a test runs if its name contains any of them. Empty runs every test
+	 */
+	FString Filter;
+
+	/**
+	 * Runs of every test, repeats of one test are never concurrent with each other
+	 */
+	uint RepeatCount = 1;
+
+	/**
+	 * Threads tests are spread over, 0 for one per hardware thread. Exclusive tests run after the others, one by one
+	 */
+	uint ThreadCount = 1;
+
+	/**
+	 * Write to the standard output and do not wait for a key at the end, see FConsole::InitializeHeadless
+	 */
+	bool Headless = false;
+
+	/**
+	 * Called after the summary, before the process exits: the runner never returns to the caller
+	 */
+	void (*BeforeExit)() = nullptr;
+
+	const wchar_t* JsonPath = nullptr;
+	const wchar_t* JUnitPath = nullptr;
+};
+
+[[noreturn]] void RunUnitTestsAndExit(const SUnitTestOptions& options = SUnitTestOptions());
 bool __UnitTestAssert(bool result, const char* code, const char* message, uint line);
 
+/**
+ * Report files of the test and benchmark runners
+ */
+bool __UnitTestReadFile(const wchar_t* path, FString& out);
+bool __UnitTestWriteFile(const wchar_t* path, FStringView text);
+
+/**
+ * Whether `name` contains any of the comma separated parts of `filter`, or `filter` is empty. Shared by the test
+ * and benchmark runners so that -filter selects the same way in both
+ */
+bool MatchesUnitTestFilter(const char* name, FStringView filter);
+
 #define tcheck(code) __UnitTestAssert((code), #code, nullptr, __LINE__)
 #define tcheckm(code, message) __UnitTestAssert((code), #code, message, __LINE__)
 
@@ -55,6 +105,7 @@ bool __UnitTestAssert(bool result, const char* code, const char* message, uint l
 
 #else
 #define UnitTest(name) void __unused__UnitTest_##name ()
+#define UnitTestExclusive(name) void __unused__UnitTest_##name ()
 #define tcheck(code)
 #define tcheckm(code)
 #define tverify(code)
@@ -29,30 +29,140 @@ namespace FUtils
 	template<typename T>
 	struct Less
 	{
-		constexpr bool operator()(const T& v1, const T& v2)
+		constexpr bool operator()(const T& v1, const T& v2) const
+		{
+			return v1 < v2;
+		}
+
+		// heterogeneous overloads: containers can be searched with a key of another type (e.g. const char* for FString)
+		// as long as T provides the matching operator<. Arithmetic keys are left to the overload above so they are
+		// converted to T first instead of being compared with mixed signedness
+		template<typename U, typename = std::enable_if_t<!std::is_arithmetic<U>::value>>
+		constexpr bool operator()(const T& v1, const U& v2) const
+		{
+			return v1 < v2;
+		}
+
+		template<typename U, typename = std::enable_if_t<!std::is_arithmetic<U>::value>>
+		constexpr bool operator()(const U& v1, const T& v2) const
 		{
 			return v1 < v2;
 		}
 	};
 	
+	template<typename T>
+	struct Equal
+	{
+		constexpr bool operator()(const T& v1, const T& v2) const
+		{
+			return v1 == v2;
+		}
+
+		template<typename U, typename = std::enable_if_t<!std::is_arithmetic<U>::value>>
+		constexpr bool operator()(const T& v1, const U& v2) const
+		{
+			return v1 == v2;
+		}
+	};
+
+	/**
+	 * 64-bit finalizer from MurmurHash3: every input bit affects every output bit
+	 */
+	FORCEINLINE uint64 MixHash(uint64 v)
+	{
+		v ^= v >> 33;
+		v *= 0xff51afd7ed558ccdull;
+		v ^= v >> 33;
+		v *= 0xc4ceb9fe1a85ec53ull;
+		v ^= v >> 33;
+		return v;
+	}
+
+	/**
+	 * Fast non-cryptographic hash of a byte range, processes 8 bytes at a time
+	 */
+	FORCEINLINE uint64 HashBytes(const void* data, const size_t size)
+	{
+		constexpr uint64 kMultiplier = 0x517cc1b727220a95ull;
+		const uint8* bytes = (const uint8*)data;
+		uint64 hash = size;
+
+		size_t i = 0;
+		for (; i + sizeof(uint64) <= size; i += sizeof(uint64))
+		{
+			uint64 word;
+			memcpy(&word, bytes + i, sizeof(uint64));
+			hash = (((hash << 5) | (hash >> 59)) ^ word) * kMultiplier;
+		}
+
+		if (i < size)
+		{
+			uint64 tail = 0;
+			memcpy(&tail, bytes + i, size - i);
+			hash = (((hash << 5) | (hash >> 59)) ^ tail) * kMultiplier;
+		}
+
+		return MixHash(hash);
+	}
+
+	/**
+	 * Hash functor for hash containers. Works for integers, enums and pointers, specialize it for other key types
+	 */
+	template<typename T>
+	struct Hash
+	{
+		FORCEINLINE size_t operator()(const T& v) const
+		{
+			static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+			              "FUtils::Hash must be specialized for this type");
+			return (size_t)MixHash((uint64)v);
+		}
+	};
+
+	/**
+	 * Index of the lowest set bit, v must not be zero
+	 */
+	FORCEINLINE uint CountTrailingZeros(const uint32 v)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, v);
+		return (uint)index;
+#else
+		return (uint)__builtin_ctz(v);
+#endif
+	}
+
 	template<typename T>
 	void Swap(T& v1, T& v2)
 	{
-		const T initial = v1;
-		v1 = v2;
-		v2 = initial;
+		T initial = std::move(v1);
+		v1 = std::move(v2);
+		v2 = std::move(initial);
 	}
 }
 
-/* Reverse iterators wrapper for range-based for (https://stackoverflow.com/a/28139075) */
+/**
+ * Trivially relocatable types can be moved to another address with a raw memory copy, the source is then treated as
+ * destroyed. Containers use this to reallocate memory without running move constructors and destructors.
+ * Specialize for types that are not trivially copyable but don't store pointers to themselves
+ */
+template<typename T>
+struct TIsTriviallyRelocatable
+{
+	const static bool kValue = std::is_trivially_copyable<T>::value;
+};
+
+/* Reverse iterators wrapper for range-based for (https://stackoverflow.com/a/28139075).
+ * Temporaries (e.g. TMap::Range) are moved into the wrapper so that they live as long as the loop */
 template <typename T>
-struct TReverseWrapper { T& Iterable; };
+struct TReverseWrapper { T Iterable; };
 
 template <typename T>
-auto begin(TReverseWrapper<T> wrapper) { return std::rbegin(wrapper.Iterable); }
+auto begin(TReverseWrapper<T>& wrapper) { return std::rbegin(wrapper.Iterable); }
 
 template <typename T>
-auto end(TReverseWrapper<T> wrapper) { return std::rend(wrapper.Iterable); }
+auto end(TReverseWrapper<T>& wrapper) { return std::rend(wrapper.Iterable); }
 
 template <typename T>
-TReverseWrapper<T> reverse(T&& iterable) { return { iterable }; }
+TReverseWrapper<T> reverse(T&& iterable) { return { std::forward<T>(iterable) }; }
@@ -44,18 +44,100 @@ struct STest
 	}
 };
 
+static void WriteAllocationReport()
+{
+	FString report;
+	FMemoryTracking::WriteReport(report);
+	FConsole::Write(report);
+}
+
 int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR lpCmdLine, _In_ int)
 {
 	int argc;
 	LPWSTR* argvW = ::CommandLineToArgvW(lpCmdLine, &argc);
 
+	bool trackAllocations = false;
+	bool runTests = false;
+	bool runBenchmarks = false;
+	SUnitTestOptions testOptions;
+	SBenchmarkOptions benchmarkOptions;
 	for(int i = 0; i<argc; ++i)
 	{
-		if(wcscmp(argvW[i], L"-test") == 0)
+		if(wcscmp(argvW[i], L"-trackallocations") == 0)
+		{
+			trackAllocations = true;
+			FMemoryTracking::SetEnabled(true);
+		}
+		else if(wcscmp(argvW[i], L"-test") == 0)
+		{
+			runTests = true;
+		}
+		else if(wcscmp(argvW[i], L"-headless") == 0)
+		{
+			testOptions.Headless = true;
+			benchmarkOptions.Headless = true;
+		}
+		else if(wcsncmp(argvW[i], L"-repeat=", 8) == 0)
+		{
+			testOptions.RepeatCount = (uint)wcstoul(argvW[i] + 8, nullptr, 10);
+		}
+		else if(wcsncmp(argvW[i], L"-threads=", 9) == 0)
+		{
+			testOptions.ThreadCount = (uint)wcstoul(argvW[i] + 9, nullptr, 10);
+		}
+		else if(wcsncmp(argvW[i], L"-junit=", 7) == 0)
+		{
+			testOptions.JUnitPath = argvW[i] + 7;
+		}
+		else if(wcscmp(argvW[i], L"-benchmark") == 0)
+		{
+			runBenchmarks = true;
+		}
+		else if(wcsncmp(argvW[i], L"-filter=", 8) == 0)
+		{
+			FStringConv::ToUtf8(argvW[i] + 8, testOptions.Filter);
+			benchmarkOptions.Filter = testOptions.Filter;
+		}
+		else if(wcsncmp(argvW[i], L"-json=", 6) == 0)
+		{
+			testOptions.JsonPath = argvW[i] + 6;
+			benchmarkOptions.JsonPath = argvW[i] + 6;
+		}
+		else if(wcsncmp(argvW[i], L"-baseline=", 10) == 0)
+		{
+			benchmarkOptions.BaselinePath = argvW[i] + 10;
+		}
+		else if(wcscmp(argvW[i], L"-failonregression") == 0)
 		{
-			RunUnitTestsAndExit();
+			benchmarkOptions.FailOnRegression = true;
 		}
 	}
+
+	if(trackAllocations)
+	{
+		// the runners exit the process themselves
+		testOptions.BeforeExit = &WriteAllocationReport;
+		benchmarkOptions.BeforeExit = &WriteAllocationReport;
+	}
+
+	if(runTests)
+	{
+		RunUnitTestsAndExit(testOptions);
+	}
+
+	if(runBenchmarks)
+	{
+		RunBenchmarksAndExit(benchmarkOptions);
+	}
+
+	if(trackAllocations)
+	{
+		FString report;
+		FMemoryTracking::WriteReport(report);
+		FConsole::Initialize();
+		FConsole::Write(report);
+		FConsole::WaitForKey();
+	}
 	
 	return 0;
 }
\ No newline at end of file
@@ -47,10 +47,20 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include <new>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <initializer_list>
 #include <functional>
+#include <type_traits>
+#include <utility>
+
+#include <emmintrin.h>
+#include <intrin.h>
 
 /* [[IMPORTANT ENGINE HEADERS]] */
 #include "Core/Core.h"
\ No newline at end of file